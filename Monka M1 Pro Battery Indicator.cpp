@@ -9,15 +9,21 @@
 #include <devguid.h>  
 #include <hidclass.h>
 #include <shellapi.h> 
-#include <fstream>   
 #include <vector>    
 #include <string>     
-#include "resource.h"
+#include <chrono>
+#include "Monka M1 Pro Battery Indicator.h"
 #include "resource_loader.h"
 #include "ui_renderer.h"
 #include "tray_icon_renderer.h"
 #include "device_discovery.h"
 #include "settings_view.h"
+#include "latency_trace.h"
+#include "trace_events.h"
+#include "battery_service.h"
+#include "process_metrics.h"
+#include "config_file.h"
+#include "settings_store.h"
 #pragma comment(lib, "dwmapi.lib")
 #pragma comment(lib, "comctl32.lib")
 
@@ -33,6 +39,7 @@ HANDLE g_hMutex = NULL;
 #define ID_EXIT 1003
 #define ID_LAUNCH_AT_STARTUP 1004
 #define ID_ENABLE_NOTIFICATIONS 1005
+#define ID_DUMP_LATENCY 1006
 NOTIFYICONDATA g_notifyIconData = {0};
 bool g_isWindowVisible = true;
 
@@ -46,6 +53,20 @@ bool g_chargingStateInitialized = false;
 
 bool g_isUsingMockData = false;
 
+struct TrayIconState {
+    int batteryLevel;
+    bool isCharging;
+    bool isOnline;
+    bool isUpdating;
+    bool isStale;
+    bool isDarkTheme;
+    bool isIconModeColored;
+    Gdiplus::ARGB batteryColor;
+};
+
+TrayIconState g_lastTrayIconState = {0};
+bool g_hasTrayIconState = false;
+
 enum NotificationType {
     NOTIFICATION_FULL_CHARGE,
     NOTIFICATION_LOW_BATTERY,
@@ -73,11 +94,6 @@ enum NotificationType {
 LRESULT CALLBACK WndProc(HWND, UINT, WPARAM, LPARAM);
 INT_PTR CALLBACK AboutDlgProc(HWND hDlg, UINT message, WPARAM wParam, LPARAM lParam);
 
-bool IsLaunchAtStartupEnabled();
-void SetLaunchAtStartup(bool enable);
-void LoadStartupSettings();
-void SaveStartupSettings();
-
 bool IsNotificationsEnabled();
 void SetNotificationsEnabled(bool enable);
 void CheckBatteryNotifications();
@@ -92,6 +108,7 @@ void UpdateTrayIcon();
 void ShowContextMenu(HWND hWnd, POINT pt);
 void ShowHideWindow(HWND hWnd);
 void MinimizeToTray(HWND hWnd);
+void DumpLatencyStats();
 
 COLORREF GetRandomColor()
 {
@@ -161,6 +178,11 @@ int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _
 
     hInst = hInstance;
 
+    if (lpCmdLine && strstr(lpCmdLine, "-stop") != nullptr) {
+        BatteryService::RequestStop();
+        return 0;
+    }
+
     g_hMutex = CreateMutexA(NULL, TRUE, "MonkaM1ProBatteryIndicator_SingleInstance");
     if (GetLastError() == ERROR_ALREADY_EXISTS) {
         if (g_hMutex) {
@@ -178,11 +200,47 @@ int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _
         return 0; 
     }
 
+    DashboardSettings dashboard = BatteryService::LoadDashboardSettings("Config.ini");
+    if (lpCmdLine && strstr(lpCmdLine, "-dashboard") != nullptr) {
+        dashboard.enabled = true;
+    }
+
+    MulticastSettings multicast = BatteryService::LoadMulticastSettings("Config.ini");
+    BatteryService::SetMetricsTextfile(BatteryService::LoadMetricsTextfile("Config.ini"));
+    if (lpCmdLine && strstr(lpCmdLine, "-multicast") != nullptr) {
+        multicast.enabled = true;
+    }
+
+    // BEFORE THE HEADLESS BRANCH SO A HEADLESS RUN CAN BE TRACED TOO
+#ifdef MONKA_TRACE
+    if (lpCmdLine && strstr(lpCmdLine, "-trace-events") != nullptr) {
+        TraceEvents::Start("MonkaTrace.json");
+    }
+#endif
+
+    if (lpCmdLine && strstr(lpCmdLine, "-headless") != nullptr) {
+        if (dashboard.enabled) {
+            BatteryService::StartDashboard(dashboard);
+        }
+        if (multicast.enabled) {
+            BatteryService::StartMulticast(multicast);
+        }
+        int result = BatteryService::RunHeadless("", 1);
+#ifdef MONKA_TRACE
+        TraceEvents::Stop();
+#endif
+        return result;
+    }
+
     bool startMinimized = false;
     if (lpCmdLine && strstr(lpCmdLine, "-minimized") != nullptr) {
         startMinimized = true;
         nCmdShow = SW_HIDE;
     }
+    if (lpCmdLine && strstr(lpCmdLine, "-trace-latency") != nullptr) {
+        LatencyTrace::SetEnabled(true);
+    }
+    TRACE_THREAD_NAME("ui");
     WNDCLASSEX wc = { sizeof(wc) };
     wc.style = CS_HREDRAW | CS_VREDRAW;
     wc.lpfnWndProc = WndProc;
@@ -218,6 +276,8 @@ int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _
     if (!hWnd)
         return 1;
 
+    SettingsStore::Start("Config.ini", ResourceLoader::LoadResourceAsString(IDR_CONFIG_INI));
+
     if (!UIRenderer::Initialize()) {
         MessageBoxW(NULL, L"Failed to initialize UI renderer", L"Error", MB_OK | MB_ICONERROR);
         return 1;
@@ -225,6 +285,14 @@ int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _
 
     SettingsView::LoadUISettings();
 
+    BatteryService::StartStatusServer("");
+    if (dashboard.enabled) {
+        BatteryService::StartDashboard(dashboard);
+    }
+    if (multicast.enabled) {
+        BatteryService::StartMulticast(multicast);
+    }
+
     LoadStartupSettings();
 
     UIRenderer::SetMainWindow(hWnd);
@@ -232,6 +300,9 @@ int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _
     if (!InitializeSystemTray(hWnd)) {
         MessageBoxW(NULL, L"Failed to initialize system tray", L"Warning", MB_OK | MB_ICONWARNING);
     }
+
+    UIRenderer::StartBackgroundDiscovery(hWnd);
+    UIRenderer::StartConfigWatcher(hWnd);
     
     TRACKMOUSEEVENT tme = {};
     tme.cbSize = sizeof(TRACKMOUSEEVENT);
@@ -275,6 +346,21 @@ int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _
         TranslateMessage(&msg);
         DispatchMessage(&msg);
     }
+
+    UIRenderer::Shutdown();
+    SettingsStore::Stop();
+    BatteryService::StopMulticast();
+    BatteryService::StopDashboard();
+    BatteryService::StopStatusServer();
+
+    if (LatencyTrace::IsEnabled()) {
+        DumpLatencyStats();
+    }
+
+#ifdef MONKA_TRACE
+    TraceEvents::Stop();
+#endif
+
     return (int)msg.wParam;
 }
 
@@ -284,6 +370,9 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
     {
     case WM_PAINT:
     {
+        TRACE_SCOPE("WM_PAINT", "paint");
+        auto paintStart = std::chrono::steady_clock::now();
+
         PAINTSTRUCT ps;
         HDC hdc = BeginPaint(hWnd, &ps);
 
@@ -310,6 +399,9 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
         DeleteDC(memDC);
 
         EndPaint(hWnd, &ps);
+
+        ProcessMetrics::RecordPaintUs(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - paintStart).count()));
     }
     break;
 
@@ -398,6 +490,10 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
 
     case WM_TIMER:
     {
+        if (wParam >= 1 && wParam <= 4) {
+            ProcessMetrics::Increment(static_cast<ProcessCounter>(static_cast<int>(ProcessCounter::TIMER_ANIMATION) + static_cast<int>(wParam) - 1));
+        }
+
         if (wParam == 1) {
             bool hasActiveAnimations = UIRenderer::UpdateHoverAnimation(hWnd);
 
@@ -408,9 +504,14 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
             UIRenderer::UpdateBatteryStatus(hWnd);
             UpdateTrayIcon();
             CheckBatteryNotifications();
+
+            if (LatencyTrace::IsEnabled()) {
+                LatencyTrace::Collect();
+            }
         } else if (wParam == 3) {
-            UIRenderer::CheckDeviceHealth(hWnd);
             UpdateTrayIcon();
+        } else if (wParam == 4) {
+            UIRenderer::TickHeartbeats();
         }
         return 0;
     }
@@ -444,6 +545,22 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
         break;
     }
 
+    case WM_DISCOVERY_COMPLETE:
+        UIRenderer::OnBackgroundDiscoveryComplete(hWnd, wParam != 0);
+        return 0;
+
+    case WM_CONFIG_CHANGED:
+        UIRenderer::OnConfigChanged(hWnd);
+        return 0;
+
+    case WM_LINK_STATE_CHANGED:
+        UIRenderer::OnLinkStateChanged(hWnd, static_cast<DeviceId>(wParam), static_cast<LinkState>(lParam));
+        return 0;
+
+    case WM_BATTERY_UPDATED:
+        UIRenderer::OnBatteryUpdated(hWnd);
+        return 0;
+
     case WM_TRAYICON:
     {
         if (lParam == WM_RBUTTONUP) {
@@ -466,6 +583,9 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
         case ID_ENABLE_NOTIFICATIONS:
             SetNotificationsEnabled(!IsNotificationsEnabled());
             break;
+        case ID_DUMP_LATENCY:
+            DumpLatencyStats();
+            break;
         case IDM_ABOUT:
             DialogBox(hInst, MAKEINTRESOURCE(IDD_ABOUTBOX), hWnd, AboutDlgProc);
             break;
@@ -500,10 +620,18 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
         MinimizeToTray(hWnd);
         return 0;
 
+    case WM_ENDSESSION:
+        // THE PROCESS MAY BE ENDED WITHOUT LEAVING THE MESSAGE LOOP
+        if (wParam) {
+            SettingsStore::Flush();
+        }
+        return 0;
+
     case WM_DESTROY:
         KillTimer(hWnd, 1);
         KillTimer(hWnd, 2); 
         KillTimer(hWnd, 3); 
+        KillTimer(hWnd, 4);
 
         if (hDeviceNotify) {
             UnregisterDeviceNotification(hDeviceNotify);
@@ -574,128 +702,13 @@ void SetLaunchAtStartup(bool enable) {
 }
 
 void LoadStartupSettings() {
-    std::ifstream configFile("Config.ini");
-    if (!configFile.is_open()) {
-        std::string configContent = ResourceLoader::LoadResourceAsString(IDR_CONFIG_INI);
-        if (!configContent.empty()) {
-            std::ofstream createFile("Config.ini");
-            createFile << configContent;
-            createFile.close();
-            
-            configFile.open("Config.ini");
-        }
-    }
-    
-    if (!configFile.is_open()) {
-        return;
-    }
-
-    std::string line;
-    bool inOptionSection = false;
-
-    while (std::getline(configFile, line)) {
-        line.erase(0, line.find_first_not_of(" \t"));
-        line.erase(line.find_last_not_of(" \t") + 1);
-
-        if (line == "[Option]") {
-            inOptionSection = true;
-            continue;
-        }
-
-        if (line.empty() || line[0] == '[') {
-            inOptionSection = false;
-            continue;
-        }
-
-        if (inOptionSection) {
-            size_t equalPos = line.find('=');
-            if (equalPos != std::string::npos) {
-                std::string key = line.substr(0, equalPos);
-                std::string value = line.substr(equalPos + 1);
-
-                if (key == "EnableNotifications") {
-                    g_notificationsEnabled = (value == "1");
-                }
-            }
-        }
-    }
-
-    configFile.close();
+    TRACE_SCOPE("LoadStartupSettings", "config");
+    g_notificationsEnabled = SettingsStore::GetBool(ConfigKey::OPTION_ENABLE_NOTIFICATIONS, g_notificationsEnabled);
 }
 
 void SaveStartupSettings() {
-    std::ifstream checkFile("Config.ini");
-    bool fileExists = checkFile.is_open();
-    checkFile.close();
-    
-    if (!fileExists) {
-        std::string configContent = ResourceLoader::LoadResourceAsString(IDR_CONFIG_INI);
-        if (!configContent.empty()) {
-            std::ofstream createFile("Config.ini");
-            createFile << configContent;
-            createFile.close();
-        }
-    }
-
-    std::ifstream configFile("Config.ini");
-    std::vector<std::string> lines;
-    std::string line;
-
-    while (configFile.is_open() && std::getline(configFile, line)) {
-        lines.push_back(line);
-    }
-    configFile.close();
-
-    if (lines.empty()) {
-        lines.push_back("[Option]");
-        lines.push_back("EnableNotifications=" + std::string(g_notificationsEnabled ? "1" : "0"));
-        lines.push_back("");
-        lines.push_back("[UISettings]");
-        lines.push_back("IconMode=COLORED");
-        lines.push_back("");
-        lines.push_back("[ColorSettings]");
-    } else {
-        bool optionSectionFound = false;
-        bool notificationUpdated = false;
-
-        for (size_t i = 0; i < lines.size(); i++) {
-            std::string trimmedLine = lines[i];
-            trimmedLine.erase(0, trimmedLine.find_first_not_of(" \t"));
-            trimmedLine.erase(trimmedLine.find_last_not_of(" \t") + 1);
-
-            if (trimmedLine == "[Option]") {
-                optionSectionFound = true;
-                continue;
-            }
-
-            if (optionSectionFound && trimmedLine.find("EnableNotifications=") == 0) {
-                lines[i] = "EnableNotifications=" + std::string(g_notificationsEnabled ? "1" : "0");
-                notificationUpdated = true;
-                break;
-            }
-
-            if (optionSectionFound && (trimmedLine.empty() || trimmedLine[0] == '[')) {
-                if (!notificationUpdated) {
-                    lines.insert(lines.begin() + i, "EnableNotifications=" + std::string(g_notificationsEnabled ? "1" : "0"));
-                }
-                break;
-            }
-        }
-
-        if (!optionSectionFound) {
-            if (!lines.empty() && !lines.back().empty()) {
-                lines.push_back("");
-            }
-            lines.push_back("[Option]");
-            lines.push_back("EnableNotifications=" + std::string(g_notificationsEnabled ? "1" : "0"));
-        }
-    }
-
-    std::ofstream outFile("Config.ini");
-    for (const auto& fileLine : lines) {
-        outFile << fileLine << "\n";
-    }
-    outFile.close();
+    TRACE_SCOPE("SaveStartupSettings", "config");
+    SettingsStore::Set(ConfigKey::OPTION_ENABLE_NOTIFICATIONS, g_notificationsEnabled ? "1" : "0");
 }
 
 bool IsNotificationsEnabled() {
@@ -720,27 +733,33 @@ void ShowNotification(const std::wstring& title, const std::wstring& message, DW
     g_notifyIconData.uFlags &= ~NIF_INFO;
 }
 
+// THE DEVICE BATTERY REPLIES ARE ROUTED TO: THE MONITORED ONE, OR THE ONE MONITORING WILL PICK BEFORE IT STARTS
+static DeviceId GetReportingDevice(DeviceDiscovery& discovery) {
+    DeviceId deviceId = discovery.GetMonitoredDevice();
+    return deviceId != INVALID_DEVICE_ID ? deviceId : discovery.PickPreferredDevice();
+}
+
 void CheckBatteryNotifications() {
     if (!g_notificationsEnabled) return;
+    if (UIRenderer::IsDiscoveryInProgress()) return;
 
     extern DeviceDiscovery& GetDeviceDiscovery();
     DeviceDiscovery& discovery = GetDeviceDiscovery();
 
-    const auto& devices = discovery.GetDiscoveredDevices();
-    if (devices.empty()) return;
+    DeviceId deviceId = GetReportingDevice(discovery);
+    if (deviceId == INVALID_DEVICE_ID) return;
 
-    const auto& device = devices[0];
-    bool isOnline = discovery.IsDeviceOnline(device.devicePath);
+    bool isOnline = discovery.IsDeviceOnline(deviceId);
     if (!isOnline) return;
 
-    auto status = discovery.GetBatteryStatus(device.devicePath);
+    auto status = discovery.GetBatteryStatus(deviceId);
     int batteryLevel = 0;
     bool isCharging = (status.isCharging != 0);
 
     if (status.level > 0) {
         batteryLevel = status.level;
     } else if (status.BatVoltage > 0) {
-        batteryLevel = discovery.calculateBatteryPercentage(status.BatVoltage);
+        batteryLevel = discovery.calculateBatteryPercentage(deviceId, status.BatVoltage);
     }
 
     if (g_lastBatteryLevel != -1 && abs(batteryLevel - g_lastBatteryLevel) > 5) {
@@ -891,6 +910,7 @@ void CleanupSystemTray() {
 }
 
 void UpdateTrayIcon() {
+    TRACE_SCOPE("UpdateTrayIcon", "render");
     extern DeviceDiscovery& GetDeviceDiscovery();
     DeviceDiscovery& discovery = GetDeviceDiscovery();
     
@@ -898,19 +918,27 @@ void UpdateTrayIcon() {
     bool isCharging = false;
     bool isOnline = false;
     bool isUpdating = false;
+    bool isStale = false;
 
-    const auto& devices = discovery.GetDiscoveredDevices();
-    if (!devices.empty()) {
-        const auto& device = devices[0];
-        
-        isOnline = discovery.IsDeviceOnline(device.devicePath);
+    if (UIRenderer::IsDiscoveryInProgress()) {
+        const auto& mouseList = UIRenderer::GetMouseList();
+        if (!mouseList.empty()) {
+            batteryLevel = mouseList[0].batteryLevel;
+            isCharging = mouseList[0].isCharging;
+            isOnline = mouseList[0].isOnline;
+            isStale = mouseList[0].isStale;
+        } else {
+            isUpdating = true;
+        }
+    } else if (DeviceId deviceId = GetReportingDevice(discovery); deviceId != INVALID_DEVICE_ID) {
+        isOnline = discovery.IsDeviceOnline(deviceId);
         
-        auto status = discovery.GetBatteryStatus(device.devicePath);
+        auto status = discovery.GetBatteryStatus(deviceId);
         
         if (status.level > 0) {
             batteryLevel = status.level;
         } else if (status.BatVoltage > 0) {
-            batteryLevel = discovery.calculateBatteryPercentage(status.BatVoltage);
+            batteryLevel = discovery.calculateBatteryPercentage(deviceId, status.BatVoltage);
         }
         
         isCharging = (status.isCharging != 0);
@@ -932,7 +960,34 @@ void UpdateTrayIcon() {
         }
     }
 
+    TrayIconState state = {};
+    state.batteryLevel = batteryLevel;
+    state.isCharging = isCharging;
+    state.isOnline = isOnline;
+    state.isUpdating = isUpdating;
+    state.isStale = isStale;
+    state.isDarkTheme = IsDarkMode() != FALSE;
+    state.isIconModeColored = SettingsView::IsIconModeColored();
+    state.batteryColor = Colors::GetBatteryColor(batteryLevel).GetValue();
+
+    // THE CHARGING MASK BLINKS, SO THAT STATE KEEPS REDRAWING
+    bool isAnimating = isOnline && isCharging && batteryLevel < 100;
+
+    if (g_hasTrayIconState && !isAnimating &&
+        state.batteryLevel == g_lastTrayIconState.batteryLevel &&
+        state.isCharging == g_lastTrayIconState.isCharging &&
+        state.isOnline == g_lastTrayIconState.isOnline &&
+        state.isUpdating == g_lastTrayIconState.isUpdating &&
+        state.isStale == g_lastTrayIconState.isStale &&
+        state.isDarkTheme == g_lastTrayIconState.isDarkTheme &&
+        state.isIconModeColored == g_lastTrayIconState.isIconModeColored &&
+        state.batteryColor == g_lastTrayIconState.batteryColor) {
+        ProcessMetrics::Increment(ProcessCounter::TRAY_ICON_REUSED);
+        return;
+    }
+
     HICON newIcon = TrayIconRenderer::CreateBatteryIcon(batteryLevel, isCharging, isOnline, isUpdating);
+    LatencyTrace::Mark(LatencyStage::ICON_RENDERED);
 
     if (newIcon) {
         if (g_notifyIconData.hIcon) {
@@ -950,10 +1005,17 @@ void UpdateTrayIcon() {
             if (isCharging) {
                 tooltip += L" (Charging)";
             }
+            if (isStale) {
+                tooltip += L" (Last known)";
+            }
             wcscpy_s(g_notifyIconData.szTip, tooltip.c_str());
         }
 
         Shell_NotifyIcon(NIM_MODIFY, &g_notifyIconData);
+        LatencyTrace::Mark(LatencyStage::SHELL_NOTIFIED);
+
+        g_lastTrayIconState = state;
+        g_hasTrayIconState = true;
     }
 }
 
@@ -979,6 +1041,10 @@ void ShowContextMenu(HWND hWnd, POINT pt) {
     }
     AppendMenuW(hMenu, notificationFlags, ID_ENABLE_NOTIFICATIONS, L"Enable Notifications");
 
+    if (LatencyTrace::IsEnabled()) {
+        AppendMenuW(hMenu, MF_STRING, ID_DUMP_LATENCY, L"Dump Latency Stats");
+    }
+
     AppendMenuW(hMenu, MF_SEPARATOR, 0, NULL);
     AppendMenuW(hMenu, MF_STRING, IDM_ABOUT, L"About");
     AppendMenuW(hMenu, MF_STRING, ID_EXIT, L"Exit");
@@ -991,6 +1057,15 @@ void ShowContextMenu(HWND hWnd, POINT pt) {
     DestroyMenu(hMenu);
 }
 
+void DumpLatencyStats() {
+    std::string report = LatencyTrace::FormatReport();
+    OutputDebugStringA(report.c_str());
+
+    if (!LatencyTrace::DumpToFile("LatencyTrace.txt")) {
+        OutputDebugStringA("Failed to write LatencyTrace.txt\n");
+    }
+}
+
 void ShowHideWindow(HWND hWnd) {
     if (g_isWindowVisible) {
         MinimizeToTray(hWnd);
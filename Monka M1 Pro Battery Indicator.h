@@ -1,3 +1,8 @@
 #pragma once
 
 #include "resource.h"
+
+bool IsLaunchAtStartupEnabled();
+void SetLaunchAtStartup(bool enable);
+void LoadStartupSettings();
+void SaveStartupSettings();
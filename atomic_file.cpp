@@ -0,0 +1,82 @@
+#include "atomic_file.h"
+#include "trace_events.h"
+#include <cstdio>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+static bool SyncFile(FILE* file) {
+    if (fflush(file) != 0) return false;
+#ifdef _WIN32
+    HANDLE handle = reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(file)));
+    return handle != INVALID_HANDLE_VALUE && FlushFileBuffers(handle) != FALSE;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+#ifndef _WIN32
+static bool SyncParentDirectory(const std::string& path) {
+    size_t slash = path.find_last_of('/');
+    std::string directory = slash == std::string::npos ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+
+    int fd = open(directory.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+
+    bool synced = fsync(fd) == 0;
+    close(fd);
+    return synced;
+}
+#endif
+
+bool AtomicFile::Replace(const std::string& path, std::string_view content, FileSync sync) {
+    TRACE_SCOPE("AtomicFile::Replace", "io");
+    std::string temporaryPath = path + ".tmp";
+
+    FILE* file = nullptr;
+#ifdef _MSC_VER
+    if (fopen_s(&file, temporaryPath.c_str(), "wb") != 0) {
+        file = nullptr;
+    }
+#else
+    file = fopen(temporaryPath.c_str(), "wb");
+#endif
+    if (!file) {
+        return false;
+    }
+
+    bool written = fwrite(content.data(), 1, content.size(), file) == content.size();
+    if (written && sync != FileSync::NONE) {
+        written = SyncFile(file);
+    }
+    written = (fclose(file) == 0) && written;
+    if (!written) {
+        remove(temporaryPath.c_str());
+        return false;
+    }
+
+#ifdef _WIN32
+    DWORD flags = MOVEFILE_REPLACE_EXISTING;
+    if (sync == FileSync::FILE_AND_DIRECTORY) flags |= MOVEFILE_WRITE_THROUGH;
+    bool renamed = MoveFileExA(temporaryPath.c_str(), path.c_str(), flags) != FALSE;
+#else
+    bool renamed = rename(temporaryPath.c_str(), path.c_str()) == 0;
+#endif
+    if (!renamed) {
+        remove(temporaryPath.c_str());
+        return false;
+    }
+
+#ifndef _WIN32
+    // THE DATA IS DURABLE EITHER WAY; A FAILED DIRECTORY SYNC ONLY RISKS THE NAME POINTING AT THE OLD FILE
+    if (sync == FileSync::FILE_AND_DIRECTORY) {
+        SyncParentDirectory(path);
+    }
+#endif
+    return true;
+}
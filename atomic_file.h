@@ -0,0 +1,16 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+enum class FileSync {
+    NONE,               // RENAME ONLY: READERS NEVER SEE A TORN FILE, A POWER CUT MAY LOSE THE UPDATE
+    FILE,               // FLUSH THE NEW FILE TO DISK BEFORE IT REPLACES THE OLD ONE
+    FILE_AND_DIRECTORY  // ALSO FLUSH THE RENAME ITSELF (POSIX DIRECTORY fsync, WRITE-THROUGH MOVE ON WINDOWS)
+};
+
+// WHOLE-FILE REPLACE THROUGH path.tmp AND A RENAME. A CRASH LEAVES EITHER THE OLD FILE OR THE NEW ONE
+class AtomicFile {
+public:
+    static bool Replace(const std::string& path, std::string_view content, FileSync sync);
+};
@@ -0,0 +1,152 @@
+#include "base64.h"
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BASE64_SSE2 1
+#endif
+
+static const uint8_t INVALID = 0xFF;
+
+struct DecodeTable {
+    uint8_t values[256];
+};
+
+static constexpr DecodeTable BuildDecodeTable() {
+    DecodeTable table = {};
+    for (int i = 0; i < 256; i++) table.values[i] = INVALID;
+    for (int i = 0; i < 26; i++) {
+        table.values['A' + i] = static_cast<uint8_t>(i);
+        table.values['a' + i] = static_cast<uint8_t>(26 + i);
+    }
+    for (int i = 0; i < 10; i++) table.values['0' + i] = static_cast<uint8_t>(52 + i);
+    table.values['+'] = 62;
+    table.values['/'] = 63;
+    return table;
+}
+
+static constexpr DecodeTable DECODE = BuildDecodeTable();
+
+bool Base64::forceScalar = false;
+
+bool Base64::IsSimd() {
+#ifdef BASE64_SSE2
+    return !forceScalar;
+#else
+    return false;
+#endif
+}
+
+static inline uint8_t Value(char c) {
+    return DECODE.values[static_cast<unsigned char>(c)];
+}
+
+static inline void Store24(char* out, uint32_t bits) {
+    out[0] = static_cast<char>(bits >> 16);
+    out[1] = static_cast<char>(bits >> 8);
+    out[2] = static_cast<char>(bits);
+}
+
+#ifdef BASE64_SSE2
+static inline __m128i InRange(__m128i chars, char low, char high) {
+    return _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8(static_cast<char>(low - 1))),
+                         _mm_cmplt_epi8(chars, _mm_set1_epi8(static_cast<char>(high + 1))));
+}
+
+// 16 CHARACTERS TO 12 BYTES. RANGE COMPARES PICK EACH BYTE'S OFFSET INTO THE ALPHABET (BYTES >= 0x80 ARE NEGATIVE
+// AND MATCH NO RANGE); SHIFTS MERGE THE SEXTETS INTO ONE 24-BIT GROUP PER 32-BIT LANE. FALSE ON ANY INVALID CHARACTER
+static bool DecodeBlockSse2(const char* in, char* out) {
+    __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+
+    __m128i upper = InRange(chars, 'A', 'Z');
+    __m128i lower = InRange(chars, 'a', 'z');
+    __m128i digit = InRange(chars, '0', '9');
+    __m128i plus = _mm_cmpeq_epi8(chars, _mm_set1_epi8('+'));
+    __m128i slash = _mm_cmpeq_epi8(chars, _mm_set1_epi8('/'));
+
+    __m128i valid = _mm_or_si128(_mm_or_si128(upper, lower), _mm_or_si128(_mm_or_si128(digit, plus), slash));
+    if (_mm_movemask_epi8(valid) != 0xFFFF) return false;
+
+    __m128i offset = _mm_and_si128(upper, _mm_set1_epi8(-'A'));
+    offset = _mm_or_si128(offset, _mm_and_si128(lower, _mm_set1_epi8(26 - 'a')));
+    offset = _mm_or_si128(offset, _mm_and_si128(digit, _mm_set1_epi8(52 - '0')));
+    offset = _mm_or_si128(offset, _mm_and_si128(plus, _mm_set1_epi8(62 - '+')));
+    offset = _mm_or_si128(offset, _mm_and_si128(slash, _mm_set1_epi8(63 - '/')));
+    __m128i sextets = _mm_add_epi8(chars, offset);
+
+    // [a b c d] PER LANE -> (a << 6 | b), (c << 6 | d) -> (a << 18 | b << 12 | c << 6 | d)
+    __m128i pairs = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(sextets, _mm_set1_epi16(0x00FF)), 6), _mm_srli_epi16(sextets, 8));
+    __m128i groups = _mm_or_si128(_mm_slli_epi32(_mm_and_si128(pairs, _mm_set1_epi32(0xFFFF)), 12), _mm_srli_epi32(pairs, 16));
+
+    alignas(16) uint32_t lanes[4];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes), groups);
+    for (int i = 0; i < 4; i++) {
+        Store24(out + i * 3, lanes[i]);
+    }
+    return true;
+}
+#endif
+
+bool Base64::Decode(std::string_view encoded, std::string& out) {
+    out.clear();
+
+    size_t length = encoded.size();
+    size_t padding = 0;
+    while (padding < 2 && length > 0 && encoded[length - 1] == '=') {
+        length--;
+        padding++;
+    }
+    // PADDED INPUT COMES IN WHOLE QUADS; A SINGLE LEFTOVER CHARACTER CARRIES ONLY 6 BITS, NEVER A BYTE
+    if ((padding > 0 && (length + padding) % 4 != 0) || length % 4 == 1) {
+        return false;
+    }
+
+    size_t tail = length % 4;
+    out.resize(length / 4 * 3 + (tail ? tail - 1 : 0));
+
+    const char* in = encoded.data();
+    char* write = &out[0];
+    size_t position = 0;
+
+#ifdef BASE64_SSE2
+    if (!forceScalar) {
+        for (; position + 16 <= length; position += 16, write += 12) {
+            if (!DecodeBlockSse2(in + position, write)) {
+                out.clear();
+                return false;
+            }
+        }
+    }
+#endif
+
+    for (; position + 4 <= length; position += 4, write += 3) {
+        uint8_t a = Value(in[position]);
+        uint8_t b = Value(in[position + 1]);
+        uint8_t c = Value(in[position + 2]);
+        uint8_t d = Value(in[position + 3]);
+        if ((a | b | c | d) & 0x80) {
+            out.clear();
+            return false;
+        }
+        Store24(write, (uint32_t(a) << 18) | (uint32_t(b) << 12) | (uint32_t(c) << 6) | d);
+    }
+
+    if (tail) {
+        uint8_t a = Value(in[position]);
+        uint8_t b = Value(in[position + 1]);
+        uint8_t c = tail == 3 ? Value(in[position + 2]) : 0;
+        // THE BITS PAST THE LAST WHOLE BYTE MUST BE ZERO, OR TWO ENCODINGS WOULD DECODE THE SAME
+        uint8_t unused = tail == 3 ? (c & 0x03) : (b & 0x0F);
+        if (((a | b | c) & 0x80) || unused) {
+            out.clear();
+            return false;
+        }
+
+        write[0] = static_cast<char>((a << 2) | (b >> 4));
+        if (tail == 3) {
+            write[1] = static_cast<char>((b << 4) | (c >> 2));
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+// RFC 4648 BASE64 DECODING FOR THE OBFUSCATED Config.ini VALUES (VID, M_PID, D_PID, CID, ...). A COMPILE-TIME
+// REVERSE TABLE FOR THE SCALAR PATH; SSE2 TRANSLATES AND VALIDATES 16 CHARACTERS AT A TIME ON LONGER INPUT
+class Base64 {
+public:
+    // FALSE, WITH out CLEARED, FOR A CHARACTER OUTSIDE THE ALPHABET, A MISPLACED OR THIRD '=', A LENGTH NO ENCODER
+    // PRODUCES, OR NON-ZERO BITS UNDER THE PADDING. THE '=' PADDING ITSELF MAY BE LEFT OFF
+    static bool Decode(std::string_view encoded, std::string& out);
+
+    static bool IsSimd();
+    // FOR COMPARING THE TWO PATHS
+    static void ForceScalar(bool scalar) { forceScalar = scalar; }
+
+private:
+    static bool forceScalar;
+};
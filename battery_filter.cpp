@@ -0,0 +1,111 @@
+#include "battery_filter.h"
+#include "trace_events.h"
+#include "config_file.h"
+
+void BatteryFilter::LoadSettings(const std::string& configPath) {
+    TRACE_SCOPE("BatteryFilter::LoadSettings", "config");
+    std::shared_ptr<const ConfigFile> config = ConfigFile::Open(configPath);
+
+    if (config->Has(ConfigKey::FILTER_WINDOW)) {
+        SetWindow(static_cast<int>(config->GetInt(ConfigKey::FILTER_WINDOW, 0)));
+    }
+    if (config->Has(ConfigKey::FILTER_HYSTERESIS)) {
+        SetHysteresis(static_cast<int>(config->GetInt(ConfigKey::FILTER_HYSTERESIS, 0)));
+    }
+}
+
+void BatteryFilter::SetWindow(int samples) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (samples < 1) samples = 1;
+    if (samples > MAX_WINDOW) samples = MAX_WINDOW;
+    window = samples;
+
+    for (auto& filter : filters) {
+        filter.count = 0;
+        filter.next = 0;
+    }
+}
+
+void BatteryFilter::EnsureDevice(DeviceId deviceId) {
+    if (deviceId < filters.size()) return;
+
+    DeviceFilter empty = {};
+    empty.published = -1;
+    filters.resize(static_cast<size_t>(deviceId) + 1, empty);
+}
+
+int BatteryFilter::Median(const DeviceFilter& filter) const {
+    uint8_t sorted[MAX_WINDOW];
+    int count = filter.count;
+
+    for (int i = 0; i < count; i++) {
+        uint8_t value = filter.samples[i];
+        int j = i;
+        while (j > 0 && sorted[j - 1] > value) {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = value;
+    }
+
+    return sorted[count / 2];
+}
+
+bool BatteryFilter::Update(DeviceId deviceId, int rawLevel, bool isCharging, int& publishedLevel) {
+    std::lock_guard<std::mutex> lock(mutex);
+    EnsureDevice(deviceId);
+
+    if (rawLevel < 0) rawLevel = 0;
+    if (rawLevel > 100) rawLevel = 100;
+
+    DeviceFilter& filter = filters[deviceId];
+
+    // FIRST READING OR CHARGER PLUGGED/UNPLUGGED: THE OLD WINDOW NO LONGER APPLIES
+    if (filter.published < 0 || (filter.isCharging != 0) != isCharging) {
+        filter.samples[0] = static_cast<uint8_t>(rawLevel);
+        filter.count = 1;
+        filter.next = 1 % window;
+        filter.isCharging = isCharging ? 1 : 0;
+        filter.published = static_cast<int16_t>(rawLevel);
+        publishedLevel = rawLevel;
+        return true;
+    }
+
+    filter.samples[filter.next] = static_cast<uint8_t>(rawLevel);
+    filter.next = static_cast<uint8_t>((filter.next + 1) % window);
+    if (filter.count < window) filter.count++;
+
+    int median = Median(filter);
+    int delta = median - filter.published;
+    if (delta < 0) delta = -delta;
+
+    bool changed = delta >= hysteresis ||
+                   (delta > 0 && (median == 0 || median == 100));
+    if (changed) {
+        filter.published = static_cast<int16_t>(median);
+    }
+
+    publishedLevel = filter.published;
+    return changed;
+}
+
+int BatteryFilter::GetPublished(DeviceId deviceId) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (deviceId >= filters.size()) return -1;
+    return filters[deviceId].published;
+}
+
+void BatteryFilter::Reset(DeviceId deviceId) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (deviceId >= filters.size()) return;
+
+    filters[deviceId].count = 0;
+    filters[deviceId].next = 0;
+    filters[deviceId].published = -1;
+}
+
+void BatteryFilter::Clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    filters.clear();
+}
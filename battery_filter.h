@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <mutex>
+#include "device_registry.h"
+
+// MEDIAN OVER THE LAST FEW READINGS, PUBLISHED ONLY WHEN IT LEAVES THE HYSTERESIS BAND
+class BatteryFilter {
+private:
+    static const int MAX_WINDOW = 9;
+
+    struct DeviceFilter {
+        uint8_t samples[MAX_WINDOW];
+        uint8_t count;
+        uint8_t next;
+        uint8_t isCharging;
+        int16_t published;
+    };
+
+    mutable std::mutex mutex;
+    int window;
+    int hysteresis;
+    std::vector<DeviceFilter> filters;
+
+    void EnsureDevice(DeviceId deviceId);
+    int Median(const DeviceFilter& filter) const;
+
+public:
+    BatteryFilter() : window(5), hysteresis(2) {}
+
+    void LoadSettings(const std::string& configPath);
+    void SetWindow(int samples);
+    void SetHysteresis(int percent) { hysteresis = percent > 0 ? percent : 1; }
+
+    bool Update(DeviceId deviceId, int rawLevel, bool isCharging, int& publishedLevel);
+    int GetPublished(DeviceId deviceId) const;
+
+    void Reset(DeviceId deviceId);
+    void Clear();
+};
@@ -0,0 +1,339 @@
+#include "battery_service.h"
+#include "device_simulator.h"
+#include "fleet_monitor.h"
+#include "status_page.h"
+#include "trace_events.h"
+#include "process_metrics.h"
+#include "config_file.h"
+#include <chrono>
+#include <thread>
+#include <iostream>
+#include <cstdlib>
+#include <cstdio>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include "device_discovery.h"
+#else
+#include <signal.h>
+#include <sys/resource.h>
+#endif
+
+static const int64_t HEADLESS_TICK_MS = 50;
+static const int64_t TEXTFILE_INTERVAL_MS = 5000;
+static const int64_t DEFAULT_FLEET_REPORT_MS = 5000;
+static const uint32_t FLEET_MISS_LIMIT = 3;
+static const size_t SMALL_FLEET = 64;
+static const int64_t FLEET_PUBLISH_MS = 1000;
+static const int64_t FLEET_STATS_MS = 10000;
+
+StatusServer BatteryService::statusServer;
+HttpServer BatteryService::dashboardServer;
+MulticastPublisher BatteryService::multicastPublisher;
+MetricsExporter BatteryService::metricsExporter;
+std::string BatteryService::metricsTextfile;
+int64_t BatteryService::lastTextfileMs = 0;
+int64_t BatteryService::fleetReportMs = 0;
+bool BatteryService::fleetStats = false;
+std::atomic<bool> BatteryService::stopRequested{false};
+
+bool BatteryService::StartStatusServer(const std::string& endpoint) {
+    if (statusServer.IsRunning()) {
+        return true;
+    }
+
+    if (!statusServer.Start(endpoint)) {
+        std::cerr << "Failed to start status server on " << (endpoint.empty() ? StatusServer::DefaultEndpoint() : endpoint) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void BatteryService::StopStatusServer() {
+    statusServer.Stop();
+}
+
+bool BatteryService::IsStatusServerRunning() {
+    return statusServer.IsRunning();
+}
+
+void BatteryService::PublishSnapshot(const StatusSnapshot& snapshot) {
+    TRACE_SCOPE("BatteryService::PublishSnapshot", "ipc");
+    statusServer.Publish(snapshot);
+    dashboardServer.Publish(snapshot);
+    multicastPublisher.Publish(snapshot, SteadyNowMs());
+    metricsExporter.Update(snapshot);
+}
+
+void BatteryService::PublishDeviceCounters(const std::vector<DeviceCounters>& counters) {
+    metricsExporter.UpdateCounters(counters);
+}
+
+void BatteryService::Tick(int64_t nowMs) {
+    multicastPublisher.Tick(nowMs);
+
+    if (!metricsTextfile.empty() && nowMs - lastTextfileMs >= TEXTFILE_INTERVAL_MS) {
+        lastTextfileMs = nowMs;
+        metricsExporter.WriteTextfile(metricsTextfile);
+    }
+}
+
+static bool ParsePort(long long value, int& port) {
+    if (value <= 0 || value >= 65536) return false;
+    port = static_cast<int>(value);
+    return true;
+}
+
+DashboardSettings BatteryService::LoadDashboardSettings(const std::string& configPath) {
+    TRACE_SCOPE("BatteryService::LoadDashboardSettings", "config");
+    DashboardSettings settings = { false, 8765, "docs" };
+    std::shared_ptr<const ConfigFile> config = ConfigFile::Open(configPath);
+
+    settings.enabled = config->GetBool(ConfigKey::DASHBOARD_ENABLED, settings.enabled);
+    ParsePort(config->GetInt(ConfigKey::DASHBOARD_PORT, 0), settings.port);
+
+    std::string_view documentRoot = config->GetString(ConfigKey::DASHBOARD_DOC_ROOT);
+    if (!documentRoot.empty()) settings.documentRoot = std::string(documentRoot);
+
+    return settings;
+}
+
+MulticastSettings BatteryService::LoadMulticastSettings(const std::string& configPath) {
+    TRACE_SCOPE("BatteryService::LoadMulticastSettings", "config");
+    MulticastSettings settings = MulticastPublisher::DefaultSettings();
+    std::shared_ptr<const ConfigFile> config = ConfigFile::Open(configPath);
+
+    settings.enabled = config->GetBool(ConfigKey::MULTICAST_ENABLED, settings.enabled);
+    ParsePort(config->GetInt(ConfigKey::MULTICAST_PORT, 0), settings.port);
+
+    std::string_view group = config->GetString(ConfigKey::MULTICAST_GROUP);
+    if (!group.empty()) settings.group = std::string(group);
+
+    long long ttl = config->GetInt(ConfigKey::MULTICAST_TTL, 0);
+    if (ttl > 0 && ttl < 256) settings.ttl = static_cast<int>(ttl);
+
+    settings.interfaceAddress = std::string(config->GetString(ConfigKey::MULTICAST_INTERFACE, settings.interfaceAddress));
+
+    long long heartbeat = config->GetInt(ConfigKey::MULTICAST_HEARTBEAT_MS, 0);
+    if (heartbeat >= 500) settings.heartbeatMs = heartbeat;
+
+    return settings;
+}
+
+std::string BatteryService::LoadMetricsTextfile(const std::string& configPath) {
+    return std::string(ConfigFile::Open(configPath)->GetString(ConfigKey::METRICS_TEXTFILE));
+}
+
+bool BatteryService::StartDashboard(const DashboardSettings& settings) {
+    if (dashboardServer.IsRunning()) {
+        return true;
+    }
+
+    dashboardServer.SetMetricsExporter(&metricsExporter);
+
+    if (!dashboardServer.Start(settings.port, settings.documentRoot)) {
+        std::cerr << "Failed to start dashboard on 127.0.0.1:" << settings.port << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void BatteryService::StopDashboard() {
+    dashboardServer.Stop();
+}
+
+bool BatteryService::StartMulticast(const MulticastSettings& settings) {
+    if (multicastPublisher.IsRunning()) {
+        return true;
+    }
+
+    if (!multicastPublisher.Start(settings)) {
+        std::cerr << "Failed to start LAN status broadcast to " << settings.group << ":" << settings.port << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void BatteryService::StopMulticast() {
+    multicastPublisher.Stop();
+}
+
+#ifdef _WIN32
+
+void BatteryService::RequestStop() {
+    stopRequested = true;
+
+    HANDLE stopEvent = OpenEventA(EVENT_MODIFY_STATE, FALSE, StopEventName());
+    if (stopEvent) {
+        SetEvent(stopEvent);
+        CloseHandle(stopEvent);
+    }
+}
+
+int BatteryService::RunHeadless(const std::string& endpoint, size_t simulatedDevices) {
+    TRACE_THREAD_NAME("headless");
+
+    HANDLE stopEvent = CreateEventA(NULL, TRUE, FALSE, StopEventName());
+    if (!stopEvent) {
+        return 1;
+    }
+
+    if (!StartStatusServer(endpoint)) {
+        CloseHandle(stopEvent);
+        return 1;
+    }
+
+    DeviceDiscovery& discovery = GetDeviceDiscovery();
+    bool useHid = discovery.Initialize() && discovery.DiscoverDevices();
+
+    DeviceSimulator simulator(GetTickCount());
+    if (useHid) {
+        DeviceId device = discovery.PickPreferredDevice();
+        if (device != INVALID_DEVICE_ID) {
+            discovery.StartBatteryMonitoring(device);
+        }
+    } else {
+        OutputDebugStringA("Headless: no HID devices, serving simulated data\n");
+        simulator.AddDevices(simulatedDevices > 0 ? simulatedDevices : 1, SteadyNowMs());
+    }
+
+    StatusSnapshot snapshot;
+    std::vector<DeviceCounters> counters;
+    while (!stopRequested && WaitForSingleObject(stopEvent, static_cast<DWORD>(HEADLESS_TICK_MS)) == WAIT_TIMEOUT) {
+        ProcessMetrics::Increment(ProcessCounter::TIMER_HEADLESS);
+        if (useHid) {
+            discovery.TickHeartbeats();
+            discovery.BuildStatusSnapshot(snapshot);
+            discovery.BuildDeviceCounters(snapshot, counters);
+            PublishDeviceCounters(counters);
+        } else {
+            simulator.Step(SteadyNowMs());
+            simulator.BuildSnapshot(snapshot);
+        }
+        discovery.PublishStatusPage(snapshot);
+        PublishSnapshot(snapshot);
+        Tick(SteadyNowMs());
+    }
+
+    if (useHid) {
+        discovery.StopBatteryMonitoring();
+    }
+    discovery.Cleanup();
+
+    StopMulticast();
+    StopDashboard();
+    StopStatusServer();
+    CloseHandle(stopEvent);
+    return 0;
+}
+
+#else
+
+static void HandleStopSignal(int) {
+    BatteryService::RequestStop();
+}
+
+void BatteryService::RequestStop() {
+    stopRequested = true;
+}
+
+// NO HID DLL OFF WINDOWS: THE DAEMON SERVES SIMULATED DEVICES SO CLIENTS CAN BE BUILT AND TESTED
+int BatteryService::RunHeadless(const std::string& endpoint, size_t simulatedDevices) {
+    TRACE_THREAD_NAME("headless");
+
+    struct sigaction action = {};
+    action.sa_handler = HandleStopSignal;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    if (!StartStatusServer(endpoint)) {
+        return 1;
+    }
+
+    int64_t startMs = SteadyNowMs();
+    DeviceSimulator simulator(static_cast<uint32_t>(startMs));
+    simulator.SetReportIntervalMs(fleetReportMs);
+    simulator.AddDevices(simulatedDevices > 0 ? simulatedDevices : 1, startMs);
+
+    DeviceRegistry& registry = simulator.GetRegistry();
+    FleetMonitor fleet(registry);
+    fleet.SetReportInterval(fleetReportMs > 0 ? fleetReportMs : DEFAULT_FLEET_REPORT_MS, FLEET_MISS_LIMIT);
+    fleet.TrackAll(startMs);
+
+    StatusPage statusPage;
+    if (!statusPage.Open(StatusPage::DefaultName())) {
+        std::cerr << "Failed to create shared status page" << std::endl;
+    }
+
+    // A REPORT ONLY REWRITES ITS OWN SHARED-PAGE RECORD. FULL SNAPSHOTS (IPC, DASHBOARD, LAN) GO OUT EVERY TICK
+    // FOR A HANDFUL OF MICE AND AT MOST ONCE A SECOND FOR A FLEET, SO THE COST PER REPORT STAYS CONSTANT
+    StatusSnapshot snapshot;
+    std::vector<DeviceId> reported;
+    std::vector<DeviceId> changed;
+    bool dirty = true;
+    int64_t lastFullMs = 0;
+
+    uint64_t windowReports = 0;
+    uint64_t windowChanges = 0;
+    int64_t windowStartMs = startMs;
+    rusage usageStart = {};
+    getrusage(RUSAGE_SELF, &usageStart);
+
+    while (!stopRequested) {
+        ProcessMetrics::Increment(ProcessCounter::TIMER_HEADLESS);
+        int64_t nowMs = SteadyNowMs();
+
+        reported.clear();
+        simulator.Step(nowMs, &reported);
+        for (DeviceId id : reported) {
+            BatteryStatus sample = registry.GetSample(id);
+            fleet.OnReport(id, sample, nowMs);
+            statusPage.UpdateSample(id, sample, nowMs);
+        }
+        fleet.Tick(nowMs);
+
+        if (fleet.DrainChanged(changed) > 0) dirty = true;
+        windowReports += reported.size();
+        windowChanges += changed.size();
+
+        if (dirty && (simulator.Size() <= SMALL_FLEET || nowMs - lastFullMs >= FLEET_PUBLISH_MS)) {
+            simulator.BuildSnapshot(snapshot);
+            fleet.ApplyLinkStates(snapshot);
+            statusPage.Publish(snapshot);
+            PublishSnapshot(snapshot);
+            dirty = false;
+            lastFullMs = nowMs;
+        }
+        Tick(nowMs);
+
+        if (fleetStats && nowMs - windowStartMs >= FLEET_STATS_MS) {
+            rusage usage = {};
+            getrusage(RUSAGE_SELF, &usage);
+            double cpuSeconds = (usage.ru_utime.tv_sec - usageStart.ru_utime.tv_sec) + (usage.ru_stime.tv_sec - usageStart.ru_stime.tv_sec) +
+                                ((usage.ru_utime.tv_usec - usageStart.ru_utime.tv_usec) + (usage.ru_stime.tv_usec - usageStart.ru_stime.tv_usec)) / 1e6;
+            double seconds = (nowMs - windowStartMs) / 1000.0;
+
+            FleetSummary summary;
+            fleet.Summarize(summary);
+            fprintf(stderr, "fleet: %zu devices (%zu online, %zu suspect, %zu offline, %zu low, avg %u%%) %.0f reports/s %.0f changes/s cpu %.2f%%\n",
+                    summary.devices, summary.online, summary.suspect, summary.offline, summary.low,
+                    static_cast<unsigned>(summary.averageLevel), windowReports / seconds, windowChanges / seconds,
+                    cpuSeconds * 100.0 / seconds);
+
+            windowReports = 0;
+            windowChanges = 0;
+            windowStartMs = nowMs;
+            usageStart = usage;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(HEADLESS_TICK_MS));
+    }
+
+    StopMulticast();
+    StopDashboard();
+    StopStatusServer();
+    return 0;
+}
+
+#endif
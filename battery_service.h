@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include "status_server.h"
+#include "http_server.h"
+#include "multicast_publisher.h"
+#include "metrics_exporter.h"
+
+struct DashboardSettings {
+    bool enabled;
+    int port;
+    std::string documentRoot;
+};
+
+// OWNS THE LOCAL STATUS ENDPOINT. THE TRAY APP PUBLISHES INTO IT; -headless RUNS IT WITHOUT A WINDOW
+class BatteryService {
+private:
+    static StatusServer statusServer;
+    static HttpServer dashboardServer;
+    static MulticastPublisher multicastPublisher;
+    static MetricsExporter metricsExporter;
+    static std::string metricsTextfile;
+    static int64_t lastTextfileMs;
+    static int64_t fleetReportMs;
+    static bool fleetStats;
+    static std::atomic<bool> stopRequested;
+
+public:
+    static bool StartStatusServer(const std::string& endpoint);
+    static void StopStatusServer();
+    static bool IsStatusServerRunning();
+    static void PublishSnapshot(const StatusSnapshot& snapshot);
+    static void PublishDeviceCounters(const std::vector<DeviceCounters>& counters);
+    // PERIODIC WORK THAT IS NOT DRIVEN BY A CHANGE (LAN HEARTBEATS). CALLED FROM THE HEARTBEAT TIMER
+    static void Tick(int64_t nowMs);
+
+    static DashboardSettings LoadDashboardSettings(const std::string& configPath);
+    static bool StartDashboard(const DashboardSettings& settings);
+    static void StopDashboard();
+
+    static MulticastSettings LoadMulticastSettings(const std::string& configPath);
+    static bool StartMulticast(const MulticastSettings& settings);
+    static void StopMulticast();
+
+    // [Metrics] Textfile=PATH: REWRITTEN FROM Tick FOR node_exporter's TEXTFILE COLLECTOR. /metrics IS ALWAYS ON THE DASHBOARD
+    static std::string LoadMetricsTextfile(const std::string& configPath);
+    static void SetMetricsTextfile(const std::string& path) { metricsTextfile = path; }
+    static MetricsExporter& GetMetricsExporter() { return metricsExporter; }
+
+    // FLEET MODE (SIMULATED DEVICES): FIXED PER-DEVICE REPORT INTERVAL, 0 FOR THE DEFAULT JITTER; stats PRINTS LOAD TO stderr
+    static void SetFleetOptions(int64_t reportIntervalMs, bool stats) { fleetReportMs = reportIntervalMs; fleetStats = stats; }
+
+    // BLOCKS UNTIL RequestStop (OR THE NAMED STOP EVENT / SIGTERM). FALLS BACK TO SIMULATED DEVICES WITHOUT HID
+    static int RunHeadless(const std::string& endpoint, size_t simulatedDevices);
+    static void RequestStop();
+
+    static const char* StopEventName() { return "MonkaM1ProBatteryIndicator_Stop"; }
+};
@@ -1,7 +1,9 @@
 #include "color_picker_dialog.h"
 #include "resource.h"
-#include <fstream>
-#include <sstream>
+#include "trace_events.h"
+#include "config_file.h"
+#include "settings_store.h"
+#include <cstdio>
 #include <vector>
 
 ColorSettings ColorPickerDialog::s_colorSettings;
@@ -83,158 +85,47 @@ bool ColorPickerDialog::IsColorCustomized(int colorIndex) {
 }
 
 void ColorPickerDialog::LoadColorSettings() {
-    std::ifstream configFile("Config.ini");
-    if (!configFile.is_open()) {
-        return;
-    }
-
-    std::string line;
-    bool inColorSettings = false;
+    TRACE_SCOPE("ColorPickerDialog::LoadColorSettings", "config");
+    const ConfigKey keys[] = {ConfigKey::COLOR_CUSTOM_PRIMARY, ConfigKey::COLOR_CUSTOM_SUCCESS, ConfigKey::COLOR_CUSTOM_WARNING, ConfigKey::COLOR_CUSTOM_CRITICAL};
 
-    while (std::getline(configFile, line)) {
-        line.erase(0, line.find_first_not_of(" \t"));
-        line.erase(line.find_last_not_of(" \t") + 1);
-
-        if (line == "[ColorSettings]") {
-            inColorSettings = true;
-            continue;
-        }
-
-        if (line.empty() || line[0] == '[') {
-            inColorSettings = false;
+    for (int i = 0; i < 4; i++) {
+        // ALSO RUNS ON A HOT RELOAD, WHERE A KEY THAT IS GONE MEANS BACK TO THE THEME COLOR
+        std::string value;
+        if (!SettingsStore::Get(keys[i], value)) {
+            s_colorSettings.useCustomColors[i] = false;
             continue;
         }
 
-        if (inColorSettings) {
-            size_t equalPos = line.find('=');
-            if (equalPos != std::string::npos) {
-                std::string key = line.substr(0, equalPos);
-                std::string value = line.substr(equalPos + 1);
-
-                if (key == "CustomPrimary") {
-                    s_colorSettings.useCustomColors[0] = true;
-                    std::stringstream ss(value);
-                    std::string token;
-                    int rgb[3] = {0};
-                    int i = 0;
-                    while (std::getline(ss, token, ',') && i < 3) {
-                        rgb[i++] = std::stoi(token);
-                    }
-                    s_colorSettings.customColors[0] = Gdiplus::Color(255, rgb[0], rgb[1], rgb[2]);
-                }
-                else if (key == "CustomSuccess") {
-                    s_colorSettings.useCustomColors[1] = true;
-                    std::stringstream ss(value);
-                    std::string token;
-                    int rgb[3] = {0};
-                    int i = 0;
-                    while (std::getline(ss, token, ',') && i < 3) {
-                        rgb[i++] = std::stoi(token);
-                    }
-                    s_colorSettings.customColors[1] = Gdiplus::Color(255, rgb[0], rgb[1], rgb[2]);
-                }
-                else if (key == "CustomWarning") {
-                    s_colorSettings.useCustomColors[2] = true;
-                    std::stringstream ss(value);
-                    std::string token;
-                    int rgb[3] = {0};
-                    int i = 0;
-                    while (std::getline(ss, token, ',') && i < 3) {
-                        rgb[i++] = std::stoi(token);
-                    }
-                    s_colorSettings.customColors[2] = Gdiplus::Color(255, rgb[0], rgb[1], rgb[2]);
-                }
-                else if (key == "CustomCritical") {
-                    s_colorSettings.useCustomColors[3] = true;
-                    std::stringstream ss(value);
-                    std::string token;
-                    int rgb[3] = {0};
-                    int i = 0;
-                    while (std::getline(ss, token, ',') && i < 3) {
-                        rgb[i++] = std::stoi(token);
-                    }
-                    s_colorSettings.customColors[3] = Gdiplus::Color(255, rgb[0], rgb[1], rgb[2]);
-                }
+        int rgb[3] = {0};
+        int component = 0;
+        ConfigFile::ForEachItem(value, ',', [&rgb, &component](std::string_view token) {
+            long long parsed = 0;
+            if (component < 3 && ConfigFile::ParseInt(token, parsed)) {
+                rgb[component] = static_cast<int>(parsed);
             }
-        }
-    }
+            component++;
+        });
 
-    configFile.close();
+        s_colorSettings.useCustomColors[i] = true;
+        s_colorSettings.customColors[i] = Gdiplus::Color(255, rgb[0], rgb[1], rgb[2]);
+    }
 }
 
 void ColorPickerDialog::SaveColorSettings() {
-    std::ifstream configFile("Config.ini");
-    std::vector<std::string> lines;
-    std::string line;
-
-    while (configFile.is_open() && std::getline(configFile, line)) {
-        lines.push_back(line);
-    }
-    configFile.close();
-
-    bool colorSectionFound = false;
-    int colorSectionEnd = -1;
-
-    for (size_t i = 0; i < lines.size(); i++) {
-        std::string trimmedLine = lines[i];
-        trimmedLine.erase(0, trimmedLine.find_first_not_of(" \t"));
-        trimmedLine.erase(trimmedLine.find_last_not_of(" \t") + 1);
-
-        if (trimmedLine == "[ColorSettings]") {
-            colorSectionFound = true;
-
-            size_t j = i + 1;
-            while (j < lines.size()) {
-                std::string nextLine = lines[j];
-                nextLine.erase(0, nextLine.find_first_not_of(" \t"));
-                nextLine.erase(nextLine.find_last_not_of(" \t") + 1);
-
-                if (nextLine.empty() || nextLine[0] == '[') {
-                    colorSectionEnd = j;
-                    break;
-                }
-
-                if (nextLine.find("Custom") == 0) {
-                    lines.erase(lines.begin() + j);
-                } else {
-                    j++;
-                }
-            }
-
-            if (colorSectionEnd == -1) {
-                colorSectionEnd = lines.size();
-            }
-            break;
-        }
-    }
-
-    if (!colorSectionFound) {
-        lines.push_back("[ColorSettings]");
-        colorSectionEnd = lines.size();
-    }
-
-    std::vector<std::string> colorLines;
-    const char* colorNames[] = {"Primary", "Success", "Warning", "Critical"};
+    TRACE_SCOPE("ColorPickerDialog::SaveColorSettings", "config");
+    const ConfigKey keys[] = {ConfigKey::COLOR_CUSTOM_PRIMARY, ConfigKey::COLOR_CUSTOM_SUCCESS, ConfigKey::COLOR_CUSTOM_WARNING, ConfigKey::COLOR_CUSTOM_CRITICAL};
 
     for (int i = 0; i < 4; i++) {
-        if (s_colorSettings.useCustomColors[i]) {
-            Gdiplus::Color color = s_colorSettings.customColors[i];
-            std::stringstream ss;
-            ss << "Custom" << colorNames[i] << "="
-               << (int)color.GetR() << ","
-               << (int)color.GetG() << ","
-               << (int)color.GetB();
-            colorLines.push_back(ss.str());
+        if (!s_colorSettings.useCustomColors[i]) {
+            SettingsStore::Remove(keys[i]);
+            continue;
         }
-    }
-
-    lines.insert(lines.begin() + colorSectionEnd, colorLines.begin(), colorLines.end());
 
-    std::ofstream outFile("Config.ini");
-    for (const auto& fileLine : lines) {
-        outFile << fileLine << "\n";
+        Gdiplus::Color color = s_colorSettings.customColors[i];
+        char rgb[16];
+        snprintf(rgb, sizeof(rgb), "%d,%d,%d", (int)color.GetR(), (int)color.GetG(), (int)color.GetB());
+        SettingsStore::Set(keys[i], rgb);
     }
-    outFile.close();
 }
 
 COLORREF ColorPickerDialog::GdiplusColorToColorRef(const Gdiplus::Color& color) {
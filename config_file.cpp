@@ -0,0 +1,809 @@
+#include "config_file.h"
+#include "trace_events.h"
+#include "atomic_file.h"
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <intrin.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CONFIG_SCAN_SSE2 1
+#endif
+
+
+struct CachedConfig {
+    std::string path;
+    long long size;
+    long long writeTime;
+    std::shared_ptr<const ConfigFile> config;
+};
+
+static std::mutex cacheMutex;
+static std::vector<CachedConfig> cache;
+
+// WRITE TIMES IN THE FINEST UNIT THE PLATFORM KEEPS: 100 ns FILETIME TICKS ON WINDOWS, NANOSECONDS ELSEWHERE
+#ifdef _WIN32
+static const long long FILE_TICKS_PER_SECOND = 10000000;
+#else
+static const long long FILE_TICKS_PER_SECOND = 1000000000;
+#endif
+
+static bool StatFile(const std::string& path, long long& size, long long& writeTime) {
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), FILE_READ_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                              NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER fileSize;
+    FILETIME lastWrite;
+    bool found = GetFileSizeEx(file, &fileSize) && GetFileTime(file, NULL, NULL, &lastWrite);
+    CloseHandle(file);
+    if (!found) return false;
+
+    size = static_cast<long long>(fileSize.QuadPart);
+    writeTime = static_cast<long long>((uint64_t(lastWrite.dwHighDateTime) << 32) | lastWrite.dwLowDateTime);
+#else
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) return false;
+    size = static_cast<long long>(info.st_size);
+#ifdef __APPLE__
+    writeTime = static_cast<long long>(info.st_mtimespec.tv_sec) * FILE_TICKS_PER_SECOND + info.st_mtimespec.tv_nsec;
+#else
+    writeTime = static_cast<long long>(info.st_mtim.tv_sec) * FILE_TICKS_PER_SECOND + info.st_mtim.tv_nsec;
+#endif
+#endif
+    return true;
+}
+
+// A FILE WRITTEN IN THE LAST TWO SECONDS CAN STILL CHANGE WITHOUT ITS SIZE OR WRITE TIME MOVING: FAT KEEPS 2 s, SOME
+// FILESYSTEMS 1 s, AND THE CLOCK BEHIND THE STAMP TICKS COARSER THAN ITS UNIT. UNTIL THEN ONLY THE CONTENT VOUCHES FOR IT
+static bool IsRacy(long long writeTime) {
+#ifdef _WIN32
+    FILETIME now;
+    GetSystemTimeAsFileTime(&now);
+    long long nowTicks = static_cast<long long>((uint64_t(now.dwHighDateTime) << 32) | now.dwLowDateTime);
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    long long nowTicks = static_cast<long long>(now.tv_sec) * FILE_TICKS_PER_SECOND + now.tv_nsec;
+#endif
+    // A STAMP IN THE FUTURE (CLOCK STEPPED BACK, FILE FROM ANOTHER MACHINE) IS NO PROOF EITHER
+    return nowTicks - writeTime < 2 * FILE_TICKS_PER_SECOND;
+}
+
+bool ConfigFile::forceScalar = false;
+
+static int LowestBit(uint64_t mask) {
+#ifdef _MSC_VER
+    unsigned long index;
+#ifdef _M_X64
+    _BitScanForward64(&index, mask);
+#else
+    if (static_cast<uint32_t>(mask) != 0) {
+        _BitScanForward(&index, static_cast<uint32_t>(mask));
+    } else {
+        _BitScanForward(&index, static_cast<uint32_t>(mask >> 32));
+        index += 32;
+    }
+#endif
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(mask);
+#endif
+}
+
+// STAGE ONE: ONE BIT PER BYTE FOR '\n' AND FOR '=' OVER A 64-BYTE BLOCK. BYTES PAST count STAY ZERO
+struct BlockMasks {
+    uint64_t newlines;
+    uint64_t equals;
+};
+
+static BlockMasks ScanBlockScalar(const char* block, size_t count) {
+    BlockMasks masks = { 0, 0 };
+    for (size_t i = 0; i < count; i++) {
+        if (block[i] == '\n') masks.newlines |= 1ull << i;
+        else if (block[i] == '=') masks.equals |= 1ull << i;
+    }
+    return masks;
+}
+
+#ifdef CONFIG_SCAN_SSE2
+static BlockMasks ScanBlockSse2(const char* block) {
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i equals = _mm_set1_epi8('=');
+
+    BlockMasks masks = { 0, 0 };
+    for (int lane = 0; lane < 4; lane++) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + lane * 16));
+        uint64_t newlineBits = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline)));
+        uint64_t equalsBits = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, equals)));
+        masks.newlines |= newlineBits << (lane * 16);
+        masks.equals |= equalsBits << (lane * 16);
+    }
+    return masks;
+}
+#endif
+
+bool ConfigFile::IsSimdScan() {
+#ifdef CONFIG_SCAN_SSE2
+    return !forceScalar;
+#else
+    return false;
+#endif
+}
+
+ConfigFile::ConfigFile() : data(nullptr), size(0), mappedView(nullptr), mappedSize(0), loaded(false), compiled(false) {
+}
+
+ConfigFile::~ConfigFile() {
+    Unmap();
+}
+
+static bool IsBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+std::string_view ConfigFile::Trim(std::string_view text) {
+    size_t begin = 0;
+    size_t end = text.size();
+    while (begin < end && IsBlank(text[begin])) begin++;
+    while (end > begin && IsBlank(text[end - 1])) end--;
+    return text.substr(begin, end - begin);
+}
+
+bool ConfigFile::ParseInt(std::string_view text, long long& value) {
+    text = Trim(text);
+    if (!text.empty() && text[0] == '+') text.remove_prefix(1);
+
+    // TRAILING TEXT IS IGNORED, AS strtol/stoi DID ("5000ms" IS 5000)
+    std::from_chars_result result = std::from_chars(text.data(), text.data() + text.size(), value);
+    return result.ec == std::errc() && result.ptr != text.data();
+}
+
+void ConfigFile::Clear() {
+    Unmap();
+    buffer.clear();
+    data = nullptr;
+    size = 0;
+    entries.clear();
+    sections.clear();
+    slots.clear();
+    loaded = false;
+    compiled = false;
+}
+
+void ConfigFile::Unmap() {
+    if (!mappedView) return;
+
+#ifndef _WIN32
+    munmap(mappedView, mappedSize);
+#endif
+    mappedView = nullptr;
+    mappedSize = 0;
+    data = nullptr;
+    size = 0;
+}
+
+// POSIX MAPS THE FILE: A REPLACEMENT RENAMED OVER IT LEAVES THIS VIEW ALONE. WINDOWS WON'T TRUNCATE OR RENAME OVER A
+// MAPPED FILE, SO A SAVE WOULD FAIL FOR AS LONG AS ANY PARSE OF IT IS ALIVE. THERE IT IS READ IN ONE GO, SHARING DELETE
+// SO A CONCURRENT RENAME STILL GOES THROUGH
+bool ConfigFile::MapFile(const std::string& path) {
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                              NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    bool read = false;
+    if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0 && fileSize.QuadPart <= 0x7FFFFFFF) {
+        buffer.resize(static_cast<size_t>(fileSize.QuadPart));
+        DWORD bytesRead = 0;
+        read = ReadFile(file, &buffer[0], static_cast<DWORD>(buffer.size()), &bytesRead, NULL) && bytesRead == buffer.size();
+    }
+    CloseHandle(file);
+    if (!read) {
+        buffer.clear();
+        return false;
+    }
+
+    data = buffer.data();
+    size = buffer.size();
+    return true;
+#else
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat info;
+    void* view = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        view = mmap(NULL, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (view == MAP_FAILED) {
+        return false;
+    }
+
+    mappedView = view;
+    size = static_cast<size_t>(info.st_size);
+    mappedSize = size;
+    data = static_cast<const char*>(mappedView);
+    return true;
+#endif
+}
+
+// path.cache: HEADER, ENTRY TABLE, SECTION TABLE, HASH SLOTS, THEN THE SOURCE TEXT ITSELF. EVERY TABLE IS 8-BYTE
+// ALIGNED SO THE MAPPED FILE IS READ IN PLACE; STRINGS ARE (OFFSET, LENGTH) INTO THE TEXT. NATIVE BYTE ORDER, WHICH
+// byteOrder CHECKS: A CACHE FROM ANOTHER MACHINE IS JUST A MISS
+static const char COMPILED_MAGIC[4] = {'M', 'K', 'C', 'C'};
+static const uint16_t COMPILED_VERSION = 2;   // 2: sourceWriteTime IN FILE TICKS, NOT SECONDS
+static const uint16_t COMPILED_BYTE_ORDER = 0x0102;
+
+struct CompiledHeader {
+    char magic[4];
+    uint16_t version;
+    uint16_t byteOrder;
+    uint64_t sourceSize;
+    int64_t sourceWriteTime;
+    uint64_t sourceHash;
+    uint32_t entryCount;
+    uint32_t sectionCount;
+    uint32_t slotCount;
+    uint32_t reserved;
+    uint64_t entriesOffset;
+    uint64_t sectionsOffset;
+    uint64_t slotsOffset;
+    uint64_t textOffset;
+};
+
+struct CompiledEntry {
+    uint64_t hash;
+    uint32_t section;
+    uint32_t sectionLength;
+    uint32_t key;
+    uint32_t keyLength;
+    uint32_t value;
+    uint32_t valueLength;
+    uint32_t lineBegin;
+    uint32_t lineEnd;
+};
+
+static_assert(sizeof(CompiledEntry) == 40, "CompiledEntry LAYOUT IS PART OF THE FILE FORMAT");
+
+struct CompiledSection {
+    uint32_t name;
+    uint32_t nameLength;
+    uint32_t insertAt;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(CompiledHeader) == 80, "CompiledHeader LAYOUT IS PART OF THE FILE FORMAT");
+
+static size_t AlignUp(size_t offset) {
+    return (offset + 7) & ~static_cast<size_t>(7);
+}
+
+static bool ReadCompiledHeader(const std::string& cachePath, CompiledHeader& header) {
+    FILE* file = nullptr;
+#ifdef _MSC_VER
+    if (fopen_s(&file, cachePath.c_str(), "rb") != 0) {
+        file = nullptr;
+    }
+#else
+    file = fopen(cachePath.c_str(), "rb");
+#endif
+    if (!file) {
+        return false;
+    }
+
+    bool read = fread(&header, sizeof(header), 1, file) == 1;
+    fclose(file);
+    return read && memcmp(header.magic, COMPILED_MAGIC, sizeof(COMPILED_MAGIC)) == 0 &&
+           header.version == COMPILED_VERSION && header.byteOrder == COMPILED_BYTE_ORDER;
+}
+
+bool ConfigFile::LoadCompiled(const std::string& cachePath, long long sourceSize, long long sourceWriteTime, const uint64_t* sourceHash) {
+    TRACE_SCOPE("ConfigFile::LoadCompiled", "config");
+    if (!MapFile(cachePath)) {
+        return false;
+    }
+
+    const char* blob = data;
+    size_t blobSize = size;
+    CompiledHeader header;
+    if (blobSize < sizeof(header)) {
+        Clear();
+        return false;
+    }
+    memcpy(&header, blob, sizeof(header));
+
+    bool stamped = header.sourceWriteTime == sourceWriteTime || (sourceHash && header.sourceHash == *sourceHash);
+    bool valid = memcmp(header.magic, COMPILED_MAGIC, sizeof(COMPILED_MAGIC)) == 0 &&
+                 header.version == COMPILED_VERSION && header.byteOrder == COMPILED_BYTE_ORDER &&
+                 header.sourceSize == static_cast<uint64_t>(sourceSize) && stamped &&
+                 header.entriesOffset >= sizeof(header) &&
+                 header.entriesOffset + uint64_t(header.entryCount) * sizeof(CompiledEntry) <= header.sectionsOffset &&
+                 header.sectionsOffset + uint64_t(header.sectionCount) * sizeof(CompiledSection) <= header.slotsOffset &&
+                 header.slotsOffset + uint64_t(header.slotCount) * sizeof(uint32_t) <= header.textOffset &&
+                 header.textOffset + header.sourceSize == blobSize &&
+                 header.slotCount >= 16 && (header.slotCount & (header.slotCount - 1)) == 0 &&
+                 header.entriesOffset % 8 == 0 && header.sectionsOffset % 8 == 0 && header.slotsOffset % 8 == 0;
+    if (!valid) {
+        Clear();
+        return false;
+    }
+
+    data = blob + header.textOffset;
+    size = static_cast<size_t>(header.sourceSize);
+
+    // A TORN OR HAND-EDITED CACHE MUST NOT HAND OUT VIEWS PAST THE TEXT
+    auto inText = [this](uint32_t offset, uint32_t length) { return uint64_t(offset) + length <= size; };
+
+    const CompiledEntry* compiledEntries = reinterpret_cast<const CompiledEntry*>(blob + header.entriesOffset);
+    entries.resize(header.entryCount);
+    for (uint32_t i = 0; i < header.entryCount; i++) {
+        const CompiledEntry& source = compiledEntries[i];
+        if (!inText(source.section, source.sectionLength) || !inText(source.key, source.keyLength) ||
+            !inText(source.value, source.valueLength) || source.lineBegin > source.lineEnd || source.lineEnd > size) {
+            Clear();
+            return false;
+        }
+
+        Entry& entry = entries[i];
+        entry.section = std::string_view(data + source.section, source.sectionLength);
+        entry.key = std::string_view(data + source.key, source.keyLength);
+        entry.value = std::string_view(data + source.value, source.valueLength);
+        entry.hash = source.hash;
+        entry.lineBegin = source.lineBegin;
+        entry.lineEnd = source.lineEnd;
+    }
+
+    const CompiledSection* compiledSections = reinterpret_cast<const CompiledSection*>(blob + header.sectionsOffset);
+    sections.resize(header.sectionCount);
+    for (uint32_t i = 0; i < header.sectionCount; i++) {
+        const CompiledSection& source = compiledSections[i];
+        if (!inText(source.name, source.nameLength) || source.insertAt > size) {
+            Clear();
+            return false;
+        }
+        sections[i].name = std::string_view(data + source.name, source.nameLength);
+        sections[i].insertAt = source.insertAt;
+    }
+
+    const uint32_t* compiledSlots = reinterpret_cast<const uint32_t*>(blob + header.slotsOffset);
+    slots.assign(compiledSlots, compiledSlots + header.slotCount);
+    for (uint32_t slot : slots) {
+        if (slot > header.entryCount) {
+            Clear();
+            return false;
+        }
+    }
+
+    loaded = true;
+    compiled = true;
+    return true;
+}
+
+bool ConfigFile::SaveCompiled(const std::string& cachePath, long long sourceWriteTime, uint64_t sourceHash) const {
+    TRACE_SCOPE("ConfigFile::SaveCompiled", "config");
+    CompiledHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, COMPILED_MAGIC, sizeof(COMPILED_MAGIC));
+    header.version = COMPILED_VERSION;
+    header.byteOrder = COMPILED_BYTE_ORDER;
+    header.sourceSize = size;
+    header.sourceWriteTime = sourceWriteTime;
+    header.sourceHash = sourceHash;
+    header.entryCount = static_cast<uint32_t>(entries.size());
+    header.sectionCount = static_cast<uint32_t>(sections.size());
+    header.slotCount = static_cast<uint32_t>(slots.size());
+    header.entriesOffset = sizeof(header);
+    header.sectionsOffset = AlignUp(header.entriesOffset + entries.size() * sizeof(CompiledEntry));
+    header.slotsOffset = AlignUp(header.sectionsOffset + sections.size() * sizeof(CompiledSection));
+    header.textOffset = AlignUp(header.slotsOffset + slots.size() * sizeof(uint32_t));
+
+    std::string blob(static_cast<size_t>(header.textOffset) + size, '\0');
+    memcpy(&blob[0], &header, sizeof(header));
+
+    auto offsetOf = [this](std::string_view text) { return static_cast<uint32_t>(text.data() - data); };
+
+    CompiledEntry* compiledEntries = reinterpret_cast<CompiledEntry*>(&blob[static_cast<size_t>(header.entriesOffset)]);
+    for (size_t i = 0; i < entries.size(); i++) {
+        const Entry& entry = entries[i];
+        CompiledEntry& target = compiledEntries[i];
+        target.hash = entry.hash;
+        target.section = offsetOf(entry.section);
+        target.sectionLength = static_cast<uint32_t>(entry.section.size());
+        target.key = offsetOf(entry.key);
+        target.keyLength = static_cast<uint32_t>(entry.key.size());
+        target.value = offsetOf(entry.value);
+        target.valueLength = static_cast<uint32_t>(entry.value.size());
+        target.lineBegin = entry.lineBegin;
+        target.lineEnd = entry.lineEnd;
+    }
+
+    CompiledSection* compiledSections = reinterpret_cast<CompiledSection*>(&blob[static_cast<size_t>(header.sectionsOffset)]);
+    for (size_t i = 0; i < sections.size(); i++) {
+        compiledSections[i].name = offsetOf(sections[i].name);
+        compiledSections[i].nameLength = static_cast<uint32_t>(sections[i].name.size());
+        compiledSections[i].insertAt = sections[i].insertAt;
+    }
+
+    if (!slots.empty()) {
+        memcpy(&blob[static_cast<size_t>(header.slotsOffset)], slots.data(), slots.size() * sizeof(uint32_t));
+    }
+    if (size > 0) {
+        memcpy(&blob[static_cast<size_t>(header.textOffset)], data, size);
+    }
+
+    // BEST EFFORT: A READ-ONLY DIRECTORY ONLY COSTS A REPARSE
+    return AtomicFile::Replace(cachePath, blob, FileSync::NONE);
+}
+
+bool ConfigFile::ReadSource(const std::string& path, long long fileSize) {
+    // A SMALL FILE IS ONE read(); MAPPING ONLY PAYS OFF ONCE THE PAGE-FAULT AND munmap COST IS AMORTIZED
+    if (fileSize >= static_cast<long long>(MAP_THRESHOLD) && MapFile(path)) {
+        return true;
+    }
+
+    FILE* file = nullptr;
+#ifdef _MSC_VER
+    if (fopen_s(&file, path.c_str(), "rb") != 0) {
+        file = nullptr;
+    }
+#else
+    file = fopen(path.c_str(), "rb");
+#endif
+    if (!file) {
+        return false;
+    }
+
+    bool read = fseek(file, 0, SEEK_END) == 0;
+    long length = read ? ftell(file) : -1;
+    read = read && length >= 0 && fseek(file, 0, SEEK_SET) == 0;
+    if (read) {
+        buffer.resize(static_cast<size_t>(length));
+        read = fread(&buffer[0], 1, buffer.size(), file) == buffer.size();
+    }
+    fclose(file);
+
+    if (!read) {
+        buffer.clear();
+        return false;
+    }
+
+    data = buffer.data();
+    size = buffer.size();
+    return true;
+}
+
+bool ConfigFile::Load(const std::string& path) {
+    TRACE_SCOPE("ConfigFile::Load", "config");
+    Clear();
+
+    long long fileSize = 0;
+    long long writeTime = 0;
+    bool compile = StatFile(path, fileSize, writeTime) && fileSize >= static_cast<long long>(COMPILE_THRESHOLD);
+    std::string cachePath = compile ? path + ".cache" : std::string();
+
+    // SIZE AND WRITE TIME ALONE ONLY PROVE A SETTLED FILE UNCHANGED. A RACY ONE IS HASHED, AND ITS CACHE IS STAMPED
+    // WITH NO TIME AT ALL, SO A SAME-SIZE EDIT IN THE SAME CLOCK TICK CAN NEVER BE SERVED THE OLD INDEX LATER
+    bool racy = compile && IsRacy(writeTime);
+    long long stamp = racy ? 0 : writeTime;
+    if (compile && !racy && LoadCompiled(cachePath, fileSize, writeTime, nullptr)) {
+        return true;
+    }
+
+    if (!ReadSource(path, fileSize)) {
+        return false;
+    }
+    if (!compile) {
+        Parse();
+        return true;
+    }
+
+    // SAME SIZE, NEW TIMESTAMP (TOUCHED, COPIED, CHECKED OUT AGAIN): IF THE BYTES HASH THE SAME THE INDEX STILL HOLDS
+    uint64_t hash = ConfigHashBytes(CONFIG_FNV_OFFSET, GetText());
+    CompiledHeader header;
+    if (ReadCompiledHeader(cachePath, header) && header.sourceSize == static_cast<uint64_t>(size) && header.sourceHash == hash) {
+        Clear();
+        if (LoadCompiled(cachePath, fileSize, writeTime, &hash)) {
+            if (header.sourceWriteTime != stamp) SaveCompiled(cachePath, stamp, hash);
+            return true;
+        }
+        if (!ReadSource(path, fileSize)) {
+            return false;
+        }
+    }
+
+    Parse();
+    if (static_cast<long long>(size) == fileSize) {
+        SaveCompiled(cachePath, stamp, hash);
+    }
+    return true;
+}
+
+bool ConfigFile::LoadFromString(std::string content) {
+    Clear();
+    buffer = std::move(content);
+    data = buffer.data();
+    size = buffer.size();
+    Parse();
+    return true;
+}
+
+void ConfigFile::Parse() {
+    // STAGE ONE: NEWLINE AND '=' BITMAPS FOR THE WHOLE BUFFER, 64 BYTES PER STEP
+    size_t blockCount = (size + 63) / 64;
+    std::vector<BlockMasks> masks(blockCount);
+    size_t lineCount = 1;
+
+    bool simd = IsSimdScan();
+    for (size_t block = 0; block < blockCount; block++) {
+        size_t offset = block * 64;
+        size_t count = size - offset < 64 ? size - offset : 64;
+#ifdef CONFIG_SCAN_SSE2
+        masks[block] = (simd && count == 64) ? ScanBlockSse2(data + offset) : ScanBlockScalar(data + offset, count);
+#else
+        (void)simd;
+        masks[block] = ScanBlockScalar(data + offset, count);
+#endif
+        uint64_t newlines = masks[block].newlines;
+        while (newlines) {
+            newlines &= newlines - 1;
+            lineCount++;
+        }
+    }
+    entries.reserve(lineCount);
+
+    // STAGE TWO: WALK THE NEWLINE BITS; THE FIRST '=' BIT INSIDE A LINE SPLITS KEY FROM VALUE
+    std::string_view section;
+    uint64_t sectionHash = ConfigHashSection(section);
+    size_t lineStart = 0;
+    size_t block = 0;
+    uint64_t newlineBits = blockCount > 0 ? masks[0].newlines : 0;
+
+    while (lineStart < size) {
+        while (newlineBits == 0 && ++block < blockCount) {
+            newlineBits = masks[block].newlines;
+        }
+        size_t lineEnd = newlineBits ? block * 64 + LowestBit(newlineBits) : size;
+        newlineBits &= newlineBits ? newlineBits - 1 : 0;
+
+        size_t equalPos = std::string_view::npos;
+        for (size_t equalsBlock = lineStart / 64; equalsBlock < blockCount && equalsBlock * 64 < lineEnd; equalsBlock++) {
+            uint64_t equalsBits = masks[equalsBlock].equals;
+            if (equalsBlock == lineStart / 64) {
+                equalsBits &= ~0ull << (lineStart % 64);
+            }
+            if (equalsBits) {
+                size_t position = equalsBlock * 64 + LowestBit(equalsBits);
+                if (position < lineEnd) equalPos = position;
+                break;
+            }
+        }
+
+        std::string_view rawLine(data + lineStart, lineEnd - lineStart);
+        size_t rawStart = lineStart;
+        lineStart = lineEnd + 1;
+        uint32_t nextLine = static_cast<uint32_t>(lineEnd < size ? lineEnd + 1 : size);
+
+        std::string_view line = Trim(rawLine);
+        if (line.empty() || line[0] == '#' || line[0] == ';') continue;
+
+        if (line[0] == '[') {
+            // AN UNTERMINATED HEADER STILL ENDS THE PREVIOUS SECTION; ITS NAME JUST NEVER MATCHES A QUERY
+            section = line.back() == ']' ? Trim(line.substr(1, line.size() - 2)) : line;
+            sectionHash = ConfigHashSection(section);
+
+            Section header;
+            header.name = section;
+            header.insertAt = nextLine;
+            sections.push_back(header);
+            continue;
+        }
+
+        if (equalPos == std::string_view::npos) continue;
+
+        const char* equal = data + equalPos;
+        Entry entry;
+        entry.section = section;
+        entry.key = Trim(std::string_view(data + rawStart, static_cast<size_t>(equal - (data + rawStart))));
+        entry.value = Trim(std::string_view(equal + 1, static_cast<size_t>(data + lineEnd - (equal + 1))));
+        entry.hash = ConfigHashBytes(sectionHash, entry.key);
+        entry.lineBegin = static_cast<uint32_t>(rawStart);
+        entry.lineEnd = nextLine;
+        entries.push_back(entry);
+
+        if (!sections.empty()) sections.back().insertAt = nextLine;
+    }
+
+    BuildIndex();
+    loaded = true;
+}
+
+void ConfigFile::BuildIndex() {
+    size_t capacity = 16;
+    while (capacity < entries.size() * 2) {
+        capacity <<= 1;
+    }
+    slots.assign(capacity, 0);
+
+    size_t mask = capacity - 1;
+    for (uint32_t i = 0; i < entries.size(); i++) {
+        const Entry& entry = entries[i];
+        size_t slot = static_cast<size_t>(entry.hash) & mask;
+
+        while (slots[slot] != 0) {
+            const Entry& existing = entries[slots[slot] - 1];
+            if (existing.hash == entry.hash && existing.section == entry.section && existing.key == entry.key) {
+                break;
+            }
+            slot = (slot + 1) & mask;
+        }
+        slots[slot] = i + 1;
+    }
+}
+
+const ConfigFile::Entry* ConfigFile::Find(std::string_view section, std::string_view key) const {
+    return FindHashed(ConfigKeyHash(section, key), section, key);
+}
+
+const ConfigFile::Entry* ConfigFile::Find(ConfigKey key) const {
+    const ConfigKeyDef& def = ConfigSchema::Def(key);
+    return FindHashed(def.hash, def.section, def.key);
+}
+
+const ConfigFile::Entry* ConfigFile::FindHashed(uint64_t hash, std::string_view section, std::string_view key) const {
+    if (slots.empty()) return nullptr;
+
+    size_t mask = slots.size() - 1;
+    for (size_t slot = static_cast<size_t>(hash) & mask; slots[slot] != 0; slot = (slot + 1) & mask) {
+        const Entry& entry = entries[slots[slot] - 1];
+        if (entry.hash == hash && entry.section == section && entry.key == key) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+bool ConfigFile::HasSection(std::string_view section) const {
+    return FindSection(section) != nullptr;
+}
+
+const ConfigFile::Section* ConfigFile::FindSection(std::string_view section) const {
+    for (size_t i = sections.size(); i > 0; i--) {
+        if (sections[i - 1].name == section) return &sections[i - 1];
+    }
+    return nullptr;
+}
+
+void ConfigFile::Diff(const ConfigFile& before, const ConfigFile& after, std::vector<KeyChange>& changes) {
+    changes.clear();
+
+    for (const Entry& entry : after.entries) {
+        if (after.FindHashed(entry.hash, entry.section, entry.key) != &entry) continue;
+
+        const Entry* previous = before.FindHashed(entry.hash, entry.section, entry.key);
+        if (previous && previous->value == entry.value) continue;
+
+        KeyChange change = { entry.section, entry.key, previous ? previous->value : std::string_view(), entry.value, entry.hash, !previous, false };
+        changes.push_back(change);
+    }
+
+    for (const Entry& entry : before.entries) {
+        if (before.FindHashed(entry.hash, entry.section, entry.key) != &entry || after.FindHashed(entry.hash, entry.section, entry.key)) continue;
+
+        KeyChange change = { entry.section, entry.key, entry.value, std::string_view(), entry.hash, false, true };
+        changes.push_back(change);
+    }
+}
+
+static bool EntryValue(const ConfigFile::Entry* entry, std::string_view& value) {
+    if (!entry) return false;
+
+    value = entry->value;
+    return true;
+}
+
+static long long EntryInt(const ConfigFile::Entry* entry, long long fallback) {
+    long long value = 0;
+    return (entry && ConfigFile::ParseInt(entry->value, value)) ? value : fallback;
+}
+
+static bool EntryBool(const ConfigFile::Entry* entry, bool fallback) {
+    if (!entry) return fallback;
+
+    if (entry->value == "1" || entry->value == "true") return true;
+    if (entry->value == "0" || entry->value == "false") return false;
+    return fallback;
+}
+
+bool ConfigFile::Get(std::string_view section, std::string_view key, std::string_view& value) const {
+    return EntryValue(Find(section, key), value);
+}
+
+std::string_view ConfigFile::GetString(std::string_view section, std::string_view key, std::string_view fallback) const {
+    const Entry* entry = Find(section, key);
+    return entry ? entry->value : fallback;
+}
+
+long long ConfigFile::GetInt(std::string_view section, std::string_view key, long long fallback) const {
+    return EntryInt(Find(section, key), fallback);
+}
+
+bool ConfigFile::GetBool(std::string_view section, std::string_view key, bool fallback) const {
+    return EntryBool(Find(section, key), fallback);
+}
+
+bool ConfigFile::Get(ConfigKey key, std::string_view& value) const {
+    return EntryValue(Find(key), value);
+}
+
+std::string_view ConfigFile::GetString(ConfigKey key, std::string_view fallback) const {
+    const Entry* entry = Find(key);
+    return entry ? entry->value : fallback;
+}
+
+long long ConfigFile::GetInt(ConfigKey key, long long fallback) const {
+    return EntryInt(Find(key), fallback);
+}
+
+bool ConfigFile::GetBool(ConfigKey key, bool fallback) const {
+    return EntryBool(Find(key), fallback);
+}
+
+std::shared_ptr<const ConfigFile> ConfigFile::Open(const std::string& path) {
+    long long size = 0;
+    long long writeTime = 0;
+    bool exists = StatFile(path, size, writeTime);
+
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    auto cached = std::find_if(cache.begin(), cache.end(), [&path](const CachedConfig& entry) { return entry.path == path; });
+
+    if (!exists) {
+        if (cached != cache.end()) cache.erase(cached);
+        return std::make_shared<ConfigFile>();
+    }
+    // THE SAME RULE AS THE COMPILED CACHE: A RECENTLY WRITTEN FILE IS RELOADED EVEN WHEN ITS STAMP MATCHES
+    if (cached != cache.end() && cached->size == size && cached->writeTime == writeTime && !IsRacy(writeTime)) {
+        return cached->config;
+    }
+
+    std::shared_ptr<ConfigFile> config = std::make_shared<ConfigFile>();
+    if (!config->Load(path)) {
+        return config;
+    }
+
+    if (cached == cache.end()) {
+        cache.push_back(CachedConfig());
+        cached = cache.end() - 1;
+        cached->path = path;
+    }
+    cached->size = size;
+    cached->writeTime = writeTime;
+    cached->config = config;
+    return config;
+}
+
+void ConfigFile::Invalidate(const std::string& path) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    cache.erase(std::remove_if(cache.begin(), cache.end(), [&path](const CachedConfig& entry) { return entry.path == path; }), cache.end());
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "config_schema.h"
+
+// Config.ini PARSED ONCE. THE FILE IS READ (OR MAPPED) INTO ONE BUFFER AND INDEXED IN PLACE: SECTIONS, KEYS AND VALUES
+// ARE string_views INTO THAT BUFFER, FOUND THROUGH AN OPEN-ADDRESSED HASH OF (SECTION, KEY). NO ALLOCATION PER LINE
+class ConfigFile {
+public:
+    struct Entry {
+        std::string_view section;
+        std::string_view key;
+        std::string_view value;
+        uint64_t hash;
+        uint32_t lineBegin;   // BYTE OFFSETS OF THE WHOLE LINE, lineEnd PAST ITS '\n'
+        uint32_t lineEnd;
+    };
+
+    struct Section {
+        std::string_view name;
+        uint32_t insertAt;    // PAST THE LAST key=value LINE (OR THE HEADER): WHERE A NEW KEY GOES
+    };
+
+    // ONE KEY THAT DIFFERS BETWEEN TWO PARSES. VIEWS POINT INTO BOTH DOCUMENTS, WHICH MUST OUTLIVE THE CHANGE
+    struct KeyChange {
+        std::string_view section;
+        std::string_view key;
+        std::string_view oldValue;
+        std::string_view newValue;
+        uint64_t hash;        // ConfigKeyHash(section, key), FOR ConfigSchema::Identify
+        bool added;
+        bool removed;
+    };
+
+private:
+    // FILES FROM THIS SIZE UP ARE MAPPED INSTEAD OF READ (WINDOWS STILL READS: IT WON'T REPLACE A MAPPED FILE). A MAPPED
+    // FILE MUST BE REPLACED BY RENAME, NEVER TRUNCATED
+    static const size_t MAP_THRESHOLD = 64 * 1024;
+    // FROM THIS SIZE UP THE PARSED INDEX IS ALSO KEPT IN path.cache AND MAPPED ON THE NEXT LOAD INSTEAD OF REPARSING
+    static const size_t COMPILE_THRESHOLD = 64 * 1024;
+
+    std::string buffer;
+    const char* data;
+    size_t size;
+    void* mappedView;
+    size_t mappedSize;
+    std::vector<Entry> entries;
+    std::vector<Section> sections;
+    std::vector<uint32_t> slots;   // ENTRY INDEX + 1, 0 IS EMPTY
+    bool loaded;
+    bool compiled;
+
+    static bool forceScalar;
+
+    bool MapFile(const std::string& path);
+    void Unmap();
+    bool ReadSource(const std::string& path, long long fileSize);
+    bool LoadCompiled(const std::string& cachePath, long long sourceSize, long long sourceWriteTime, const uint64_t* sourceHash);
+    bool SaveCompiled(const std::string& cachePath, long long sourceWriteTime, uint64_t sourceHash) const;
+    void Parse();
+    void BuildIndex();
+    const Entry* FindHashed(uint64_t hash, std::string_view section, std::string_view key) const;
+
+public:
+    ConfigFile();
+    ~ConfigFile();
+
+    bool Load(const std::string& path);
+    bool LoadFromString(std::string content);
+    void Clear();
+    bool IsLoaded() const { return loaded; }
+
+    const Entry* Find(std::string_view section, std::string_view key) const;
+    bool HasSection(std::string_view section) const;
+    bool Has(std::string_view section, std::string_view key) const { return Find(section, key) != nullptr; }
+
+    // A KEY REPEATED IN ONE SECTION RESOLVES TO ITS LAST OCCURRENCE, LIKE THE LINE-BY-LINE READERS DID
+    bool Get(std::string_view section, std::string_view key, std::string_view& value) const;
+    std::string_view GetString(std::string_view section, std::string_view key, std::string_view fallback = std::string_view()) const;
+    long long GetInt(std::string_view section, std::string_view key, long long fallback) const;
+    // "1"/"true" AND "0"/"false"; ANYTHING ELSE KEEPS THE FALLBACK
+    bool GetBool(std::string_view section, std::string_view key, bool fallback) const;
+
+    // SCHEMA KEYS BRING THEIR HASH FROM COMPILE TIME: ONE PROBE AND ONE CONFIRMING COMPARE, NO HASHING
+    const Entry* Find(ConfigKey key) const;
+    bool Has(ConfigKey key) const { return Find(key) != nullptr; }
+    bool Get(ConfigKey key, std::string_view& value) const;
+    std::string_view GetString(ConfigKey key, std::string_view fallback = std::string_view()) const;
+    long long GetInt(ConfigKey key, long long fallback) const;
+    bool GetBool(ConfigKey key, bool fallback) const;
+
+    // EVERY key=value OF A SECTION IN FILE ORDER
+    template <typename Visitor>
+    void ForEach(std::string_view section, Visitor visit) const {
+        for (const Entry& entry : entries) {
+            if (entry.section == section) visit(entry.key, entry.value);
+        }
+    }
+
+    const std::vector<Entry>& GetEntries() const { return entries; }
+    const std::vector<Section>& GetSections() const { return sections; }
+    // THE LAST [section] OF THAT NAME, THE ONE A REPEATED KEY RESOLVES TO
+    const Section* FindSection(std::string_view section) const;
+    std::string_view GetText() const { return std::string_view(data, size); }
+
+    // THE STRUCTURAL SCAN USES SSE2 WHERE THE TARGET HAS IT; FORCING THE SCALAR PATH IS FOR COMPARING THE TWO
+    static bool IsSimdScan();
+    static void ForceScalarScan(bool scalar) { forceScalar = scalar; }
+    // TRUE WHEN THE LAST Load CAME FROM path.cache RATHER THAN A PARSE
+    bool IsCompiled() const { return compiled; }
+
+    // KEY-LEVEL DIFF OF THE RESOLVED VALUES (LAST OCCURRENCE WINS), O(ENTRIES) THROUGH BOTH INDEXES
+    static void Diff(const ConfigFile& before, const ConfigFile& after, std::vector<KeyChange>& changes);
+
+    static std::string_view Trim(std::string_view text);
+    static bool ParseInt(std::string_view text, long long& value);
+
+    // CALLS visit FOR EVERY NON-EMPTY, TRIMMED ITEM OF "a,b,c"
+    template <typename Visitor>
+    static void ForEachItem(std::string_view list, char separator, Visitor visit) {
+        while (!list.empty()) {
+            size_t end = list.find(separator);
+            std::string_view item = Trim(list.substr(0, end));
+            if (!item.empty()) visit(item);
+            if (end == std::string_view::npos) break;
+            list.remove_prefix(end + 1);
+        }
+    }
+
+    // SHARED PARSE OF A FILE FOR EVERY READER. REPARSED WHEN ITS SIZE OR WRITE TIME CHANGES, OR AFTER Invalidate;
+    // A MISSING FILE GIVES AN EMPTY, NOT-LOADED CONFIG RATHER THAN nullptr
+    static std::shared_ptr<const ConfigFile> Open(const std::string& path);
+    static void Invalidate(const std::string& path);
+
+private:
+    // ENTRIES POINT INTO buffer; A COPY WOULD DANGLE
+    ConfigFile(const ConfigFile&);
+    ConfigFile& operator=(const ConfigFile&);
+};
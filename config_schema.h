@@ -0,0 +1,164 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// FNV-1a OVER THE SECTION, A 0xFF SEPARATOR SO ("ab", "c") AND ("a", "bc") DIFFER, THEN THE KEY. ConfigFile INDEXES
+// WITH THESE SAME FUNCTIONS, SO A HASH FOLDED AT COMPILE TIME FINDS THE PARSED ENTRY WITHOUT HASHING AGAIN
+const uint64_t CONFIG_FNV_OFFSET = 14695981039346656037ull;
+const uint64_t CONFIG_FNV_PRIME = 1099511628211ull;
+
+constexpr uint64_t ConfigHashBytes(uint64_t hash, std::string_view bytes) {
+    for (char c : bytes) {
+        hash = (hash ^ static_cast<uint8_t>(c)) * CONFIG_FNV_PRIME;
+    }
+    return hash;
+}
+
+constexpr uint64_t ConfigHashSection(std::string_view section) {
+    return (ConfigHashBytes(CONFIG_FNV_OFFSET, section) ^ 0xFFu) * CONFIG_FNV_PRIME;
+}
+
+constexpr uint64_t ConfigKeyHash(std::string_view section, std::string_view key) {
+    return ConfigHashBytes(ConfigHashSection(section), key);
+}
+
+// EVERY FIXED Config.ini KEY THE APP READS OR WRITES. READERS, WRITERS AND RELOAD DISPATCH ALL NAME KEYS THROUGH THIS,
+// SO A KEY SPELLED ONE WAY ON SAVE CAN'T BE LOOKED UP ANOTHER WAY ON LOAD. [DeviceN] KEYS LIVE IN device_profile.cpp:
+// THEIR SECTION NAME IS ONLY KNOWN AT RUN TIME
+enum class ConfigKey : uint16_t {
+    OPTION_VID,
+    OPTION_M_PID,
+    OPTION_D_PID,
+    OPTION_INTERFACE_ID,
+    OPTION_DEVICE_ID,
+    OPTION_ENABLE_NOTIFICATIONS,
+    UI_ICON_MODE,
+    COLOR_CUSTOM_PRIMARY,
+    COLOR_CUSTOM_SUCCESS,
+    COLOR_CUSTOM_WARNING,
+    COLOR_CUSTOM_CRITICAL,
+    HEARTBEAT_WIRED_CADENCE_MS,
+    HEARTBEAT_DONGLE_CADENCE_MS,
+    HEARTBEAT_BLUETOOTH_CADENCE_MS,
+    HEARTBEAT_MISS_LIMIT,
+    HEARTBEAT_TICK_MS,
+    FILTER_WINDOW,
+    FILTER_HYSTERESIS,
+    DASHBOARD_ENABLED,
+    DASHBOARD_PORT,
+    DASHBOARD_DOC_ROOT,
+    MULTICAST_ENABLED,
+    MULTICAST_GROUP,
+    MULTICAST_PORT,
+    MULTICAST_TTL,
+    MULTICAST_INTERFACE,
+    MULTICAST_HEARTBEAT_MS,
+    METRICS_TEXTFILE,
+    UNKNOWN
+};
+
+struct ConfigKeyDef {
+    ConfigKey id;
+    std::string_view section;
+    std::string_view key;
+    uint64_t hash;
+
+    constexpr ConfigKeyDef(ConfigKey id, std::string_view section, std::string_view key)
+        : id(id), section(section), key(key), hash(ConfigKeyHash(section, key)) {}
+};
+
+// IN ConfigKey ORDER
+constexpr ConfigKeyDef CONFIG_KEYS[] = {
+    { ConfigKey::OPTION_VID, "Option", "VID" },
+    { ConfigKey::OPTION_M_PID, "Option", "M_PID" },
+    { ConfigKey::OPTION_D_PID, "Option", "D_PID" },
+    { ConfigKey::OPTION_INTERFACE_ID, "Option", "Interfaceid" },
+    { ConfigKey::OPTION_DEVICE_ID, "Option", "Deviceid" },
+    { ConfigKey::OPTION_ENABLE_NOTIFICATIONS, "Option", "EnableNotifications" },
+    { ConfigKey::UI_ICON_MODE, "UISettings", "IconMode" },
+    { ConfigKey::COLOR_CUSTOM_PRIMARY, "ColorSettings", "CustomPrimary" },
+    { ConfigKey::COLOR_CUSTOM_SUCCESS, "ColorSettings", "CustomSuccess" },
+    { ConfigKey::COLOR_CUSTOM_WARNING, "ColorSettings", "CustomWarning" },
+    { ConfigKey::COLOR_CUSTOM_CRITICAL, "ColorSettings", "CustomCritical" },
+    { ConfigKey::HEARTBEAT_WIRED_CADENCE_MS, "Heartbeat", "WiredCadenceMs" },
+    { ConfigKey::HEARTBEAT_DONGLE_CADENCE_MS, "Heartbeat", "DongleCadenceMs" },
+    { ConfigKey::HEARTBEAT_BLUETOOTH_CADENCE_MS, "Heartbeat", "BluetoothCadenceMs" },
+    { ConfigKey::HEARTBEAT_MISS_LIMIT, "Heartbeat", "MissLimit" },
+    { ConfigKey::HEARTBEAT_TICK_MS, "Heartbeat", "TickMs" },
+    { ConfigKey::FILTER_WINDOW, "BatteryFilter", "Window" },
+    { ConfigKey::FILTER_HYSTERESIS, "BatteryFilter", "Hysteresis" },
+    { ConfigKey::DASHBOARD_ENABLED, "Dashboard", "Enabled" },
+    { ConfigKey::DASHBOARD_PORT, "Dashboard", "Port" },
+    { ConfigKey::DASHBOARD_DOC_ROOT, "Dashboard", "DocRoot" },
+    { ConfigKey::MULTICAST_ENABLED, "Multicast", "Enabled" },
+    { ConfigKey::MULTICAST_GROUP, "Multicast", "Group" },
+    { ConfigKey::MULTICAST_PORT, "Multicast", "Port" },
+    { ConfigKey::MULTICAST_TTL, "Multicast", "Ttl" },
+    { ConfigKey::MULTICAST_INTERFACE, "Multicast", "Interface" },
+    { ConfigKey::MULTICAST_HEARTBEAT_MS, "Multicast", "HeartbeatMs" },
+    { ConfigKey::METRICS_TEXTFILE, "Metrics", "Textfile" },
+};
+
+const size_t CONFIG_KEY_COUNT = static_cast<size_t>(ConfigKey::UNKNOWN);
+static_assert(sizeof(CONFIG_KEYS) / sizeof(CONFIG_KEYS[0]) == CONFIG_KEY_COUNT, "ONE CONFIG_KEYS ROW PER ConfigKey");
+
+class ConfigSchema {
+public:
+    static constexpr const ConfigKeyDef& Def(ConfigKey id) { return CONFIG_KEYS[static_cast<size_t>(id)]; }
+
+    // A SWITCH ON THE PRECOMPUTED HASH, THEN ONE CONFIRMING COMPARE. AN UNKNOWN KEY COSTS THE HASH IT ALREADY HAS.
+    // TWO SCHEMA KEYS THAT COLLIDE WOULD BE DUPLICATE CASE LABELS: A COMPILE ERROR, NOT A SILENT MISMATCH
+    static constexpr ConfigKey Identify(uint64_t hash, std::string_view section, std::string_view key) {
+        ConfigKey id = ConfigKey::UNKNOWN;
+        switch (hash) {
+        case Def(ConfigKey::OPTION_VID).hash: id = ConfigKey::OPTION_VID; break;
+        case Def(ConfigKey::OPTION_M_PID).hash: id = ConfigKey::OPTION_M_PID; break;
+        case Def(ConfigKey::OPTION_D_PID).hash: id = ConfigKey::OPTION_D_PID; break;
+        case Def(ConfigKey::OPTION_INTERFACE_ID).hash: id = ConfigKey::OPTION_INTERFACE_ID; break;
+        case Def(ConfigKey::OPTION_DEVICE_ID).hash: id = ConfigKey::OPTION_DEVICE_ID; break;
+        case Def(ConfigKey::OPTION_ENABLE_NOTIFICATIONS).hash: id = ConfigKey::OPTION_ENABLE_NOTIFICATIONS; break;
+        case Def(ConfigKey::UI_ICON_MODE).hash: id = ConfigKey::UI_ICON_MODE; break;
+        case Def(ConfigKey::COLOR_CUSTOM_PRIMARY).hash: id = ConfigKey::COLOR_CUSTOM_PRIMARY; break;
+        case Def(ConfigKey::COLOR_CUSTOM_SUCCESS).hash: id = ConfigKey::COLOR_CUSTOM_SUCCESS; break;
+        case Def(ConfigKey::COLOR_CUSTOM_WARNING).hash: id = ConfigKey::COLOR_CUSTOM_WARNING; break;
+        case Def(ConfigKey::COLOR_CUSTOM_CRITICAL).hash: id = ConfigKey::COLOR_CUSTOM_CRITICAL; break;
+        case Def(ConfigKey::HEARTBEAT_WIRED_CADENCE_MS).hash: id = ConfigKey::HEARTBEAT_WIRED_CADENCE_MS; break;
+        case Def(ConfigKey::HEARTBEAT_DONGLE_CADENCE_MS).hash: id = ConfigKey::HEARTBEAT_DONGLE_CADENCE_MS; break;
+        case Def(ConfigKey::HEARTBEAT_BLUETOOTH_CADENCE_MS).hash: id = ConfigKey::HEARTBEAT_BLUETOOTH_CADENCE_MS; break;
+        case Def(ConfigKey::HEARTBEAT_MISS_LIMIT).hash: id = ConfigKey::HEARTBEAT_MISS_LIMIT; break;
+        case Def(ConfigKey::HEARTBEAT_TICK_MS).hash: id = ConfigKey::HEARTBEAT_TICK_MS; break;
+        case Def(ConfigKey::FILTER_WINDOW).hash: id = ConfigKey::FILTER_WINDOW; break;
+        case Def(ConfigKey::FILTER_HYSTERESIS).hash: id = ConfigKey::FILTER_HYSTERESIS; break;
+        case Def(ConfigKey::DASHBOARD_ENABLED).hash: id = ConfigKey::DASHBOARD_ENABLED; break;
+        case Def(ConfigKey::DASHBOARD_PORT).hash: id = ConfigKey::DASHBOARD_PORT; break;
+        case Def(ConfigKey::DASHBOARD_DOC_ROOT).hash: id = ConfigKey::DASHBOARD_DOC_ROOT; break;
+        case Def(ConfigKey::MULTICAST_ENABLED).hash: id = ConfigKey::MULTICAST_ENABLED; break;
+        case Def(ConfigKey::MULTICAST_GROUP).hash: id = ConfigKey::MULTICAST_GROUP; break;
+        case Def(ConfigKey::MULTICAST_PORT).hash: id = ConfigKey::MULTICAST_PORT; break;
+        case Def(ConfigKey::MULTICAST_TTL).hash: id = ConfigKey::MULTICAST_TTL; break;
+        case Def(ConfigKey::MULTICAST_INTERFACE).hash: id = ConfigKey::MULTICAST_INTERFACE; break;
+        case Def(ConfigKey::MULTICAST_HEARTBEAT_MS).hash: id = ConfigKey::MULTICAST_HEARTBEAT_MS; break;
+        case Def(ConfigKey::METRICS_TEXTFILE).hash: id = ConfigKey::METRICS_TEXTFILE; break;
+        default: return ConfigKey::UNKNOWN;
+        }
+        return Def(id).section == section && Def(id).key == key ? id : ConfigKey::UNKNOWN;
+    }
+
+    static constexpr ConfigKey Identify(std::string_view section, std::string_view key) {
+        return Identify(ConfigKeyHash(section, key), section, key);
+    }
+
+    // EVERY ROW SITS AT ITS OWN ConfigKey AND COMES BACK OUT OF Identify: A KEY ADDED TO THE TABLE BUT NOT THE SWITCH
+    // (OR THE OTHER WAY ROUND) FAILS THE static_assert BELOW
+    static constexpr bool IsConsistent() {
+        for (size_t i = 0; i < CONFIG_KEY_COUNT; i++) {
+            const ConfigKeyDef& def = CONFIG_KEYS[i];
+            if (static_cast<size_t>(def.id) != i || Identify(def.hash, def.section, def.key) != def.id) return false;
+        }
+        return true;
+    }
+};
+
+static_assert(ConfigSchema::IsConsistent(), "CONFIG_KEYS AND ConfigSchema::Identify DISAGREE");
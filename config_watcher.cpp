@@ -0,0 +1,295 @@
+#include "config_watcher.h"
+#include "trace_events.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/inotify.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+enum class WatchEvent {
+    CHANGED,
+    TIMEOUT,
+    STOPPED
+};
+
+static void SplitPath(const std::string& path, std::string& directory, std::string& fileName) {
+#ifdef _WIN32
+    size_t slash = path.find_last_of("/\\");
+#else
+    size_t slash = path.find_last_of('/');
+#endif
+    if (slash == std::string::npos) {
+        directory = ".";
+        fileName = path;
+    } else {
+        directory = slash == 0 ? path.substr(0, 1) : path.substr(0, slash);
+        fileName = path.substr(slash + 1);
+    }
+}
+
+struct ConfigWatcher::Impl {
+    std::string path;
+    std::string fileName;
+    ChangeCallback callback;
+    int64_t settleMs;
+    std::shared_ptr<const ConfigFile> current;
+
+    std::thread thread;
+    std::atomic<bool> running;
+    std::atomic<uint64_t> reloadCount;
+
+#ifdef _WIN32
+    HANDLE directoryHandle;
+    HANDLE stopEvent;
+    OVERLAPPED overlapped;
+    std::wstring wideFileName;
+    DWORD buffer[1024];   // FILE_NOTIFY_INFORMATION NEEDS DWORD ALIGNMENT
+
+    Impl() : settleMs(0), running(false), reloadCount(0), directoryHandle(INVALID_HANDLE_VALUE), stopEvent(NULL) {
+        ZeroMemory(&overlapped, sizeof(overlapped));
+    }
+#else
+    int inotifyFd;
+    int wakePipe[2];
+
+    Impl() : settleMs(0), running(false), reloadCount(0), inotifyFd(-1) {
+        wakePipe[0] = wakePipe[1] = -1;
+    }
+#endif
+
+    bool Open(const std::string& directory);
+    void Close();
+    WatchEvent Wait(int64_t timeoutMs);
+    void Reload();
+    void Loop();
+};
+
+#ifdef _WIN32
+
+bool ConfigWatcher::Impl::Open(const std::string& directory) {
+    int length = MultiByteToWideChar(CP_ACP, 0, fileName.c_str(), -1, NULL, 0);
+    wideFileName.assign(length > 0 ? length - 1 : 0, L'\0');
+    if (length > 1) {
+        MultiByteToWideChar(CP_ACP, 0, fileName.c_str(), -1, &wideFileName[0], length);
+    }
+
+    directoryHandle = CreateFileA(directory.c_str(), FILE_LIST_DIRECTORY,
+                                  FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING,
+                                  FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+    if (directoryHandle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    stopEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+    overlapped.hEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+    if (!stopEvent || !overlapped.hEvent) {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void ConfigWatcher::Impl::Close() {
+    if (directoryHandle != INVALID_HANDLE_VALUE) {
+        CancelIo(directoryHandle);
+        CloseHandle(directoryHandle);
+        directoryHandle = INVALID_HANDLE_VALUE;
+    }
+    if (overlapped.hEvent) {
+        CloseHandle(overlapped.hEvent);
+        overlapped.hEvent = NULL;
+    }
+    if (stopEvent) {
+        CloseHandle(stopEvent);
+        stopEvent = NULL;
+    }
+}
+
+WatchEvent ConfigWatcher::Impl::Wait(int64_t timeoutMs) {
+    while (true) {
+        ResetEvent(overlapped.hEvent);
+        // A REPLACE BY RENAME SHOWS UP AS FILE_NAME, AN IN-PLACE SAVE AS LAST_WRITE
+        if (!ReadDirectoryChangesW(directoryHandle, buffer, sizeof(buffer), FALSE,
+                                   FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE,
+                                   NULL, &overlapped, NULL)) {
+            return WatchEvent::STOPPED;
+        }
+
+        HANDLE handles[2] = { stopEvent, overlapped.hEvent };
+        DWORD waited = WaitForMultipleObjects(2, handles, FALSE, timeoutMs < 0 ? INFINITE : static_cast<DWORD>(timeoutMs));
+        if (waited != WAIT_OBJECT_0 + 1) {
+            CancelIo(directoryHandle);
+            GetOverlappedResult(directoryHandle, &overlapped, NULL, TRUE);
+            return waited == WAIT_TIMEOUT ? WatchEvent::TIMEOUT : WatchEvent::STOPPED;
+        }
+
+        DWORD bytes = 0;
+        if (!GetOverlappedResult(directoryHandle, &overlapped, &bytes, FALSE)) {
+            return WatchEvent::STOPPED;
+        }
+        // ZERO BYTES: THE KERNEL BUFFER OVERFLOWED, SO ASSUME OUR FILE WAS AMONG THE CHANGES
+        if (bytes == 0) {
+            return WatchEvent::CHANGED;
+        }
+
+        const BYTE* cursor = reinterpret_cast<const BYTE*>(buffer);
+        while (true) {
+            const FILE_NOTIFY_INFORMATION* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(cursor);
+            int nameLength = static_cast<int>(info->FileNameLength / sizeof(WCHAR));
+            if (CompareStringOrdinal(info->FileName, nameLength, wideFileName.c_str(), static_cast<int>(wideFileName.size()), TRUE) == CSTR_EQUAL) {
+                return WatchEvent::CHANGED;
+            }
+            if (info->NextEntryOffset == 0) break;
+            cursor += info->NextEntryOffset;
+        }
+    }
+}
+
+#else
+
+bool ConfigWatcher::Impl::Open(const std::string& directory) {
+    inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd < 0) {
+        return false;
+    }
+    // CLOSE_WRITE FOR AN IN-PLACE SAVE, MOVED_TO FOR A REPLACE BY RENAME (AtomicFile, MOST EDITORS)
+    if (inotify_add_watch(inotifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0 || pipe(wakePipe) != 0) {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void ConfigWatcher::Impl::Close() {
+    if (inotifyFd >= 0) {
+        close(inotifyFd);
+        inotifyFd = -1;
+    }
+    for (int i = 0; i < 2; i++) {
+        if (wakePipe[i] >= 0) {
+            close(wakePipe[i]);
+            wakePipe[i] = -1;
+        }
+    }
+}
+
+WatchEvent ConfigWatcher::Impl::Wait(int64_t timeoutMs) {
+    alignas(struct inotify_event) char events[4096];
+
+    while (true) {
+        pollfd fds[2] = { { wakePipe[0], POLLIN, 0 }, { inotifyFd, POLLIN, 0 } };
+        int ready = poll(fds, 2, timeoutMs < 0 ? -1 : static_cast<int>(timeoutMs));
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            return WatchEvent::STOPPED;
+        }
+        if (ready == 0) return WatchEvent::TIMEOUT;
+        if (fds[0].revents) return WatchEvent::STOPPED;
+
+        bool matched = false;
+        ssize_t length;
+        while ((length = read(inotifyFd, events, sizeof(events))) > 0) {
+            for (char* cursor = events; cursor < events + length;) {
+                const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(cursor);
+                if ((event->mask & IN_Q_OVERFLOW) || (event->len > 0 && fileName == event->name)) {
+                    matched = true;
+                }
+                cursor += sizeof(struct inotify_event) + event->len;
+            }
+        }
+        if (matched) return WatchEvent::CHANGED;
+    }
+}
+
+#endif
+
+void ConfigWatcher::Impl::Reload() {
+    TRACE_SCOPE("ConfigWatcher::Reload", "config");
+    // SAME SIZE AND SAME MTIME TICK WOULD OTHERWISE LOOK UNCHANGED TO THE CACHE
+    ConfigFile::Invalidate(path);
+    std::shared_ptr<const ConfigFile> config = ConfigFile::Open(path);
+
+    // MISSING FOR A MOMENT (DELETED, OR MID-REPLACE BY A TOOL THAT DOESN'T RENAME): KEEP THE LAST GOOD PARSE
+    if (!config->IsLoaded()) return;
+    if (current && current->GetText() == config->GetText()) return;
+
+    current = config;
+    reloadCount++;
+    callback(config);
+}
+
+void ConfigWatcher::Impl::Loop() {
+    TRACE_THREAD_NAME("config-watcher");
+
+    while (running) {
+        WatchEvent event = Wait(-1);
+        if (event == WatchEvent::STOPPED) break;
+        if (event != WatchEvent::CHANGED) continue;
+
+        // EDITORS SAVE IN SEVERAL STEPS; REPARSE ONCE, AFTER THE LAST ONE
+        while ((event = Wait(settleMs)) == WatchEvent::CHANGED) {
+        }
+        if (event == WatchEvent::STOPPED) break;
+
+        Reload();
+    }
+}
+
+ConfigWatcher::ConfigWatcher() : impl(new Impl()) {
+}
+
+ConfigWatcher::~ConfigWatcher() {
+    Stop();
+}
+
+bool ConfigWatcher::Start(const std::string& path, ChangeCallback callback, int64_t settleMs) {
+    TRACE_SCOPE("ConfigWatcher::Start", "config");
+    Stop();
+
+    std::string directory;
+    SplitPath(path, directory, impl->fileName);
+    impl->path = path;
+    impl->callback = callback;
+    impl->settleMs = settleMs;
+    impl->current = ConfigFile::Open(path);
+
+    if (!impl->Open(directory)) {
+        return false;
+    }
+
+    impl->running = true;
+    impl->thread = std::thread(&ConfigWatcher::Impl::Loop, impl.get());
+    return true;
+}
+
+void ConfigWatcher::Stop() {
+    if (!impl->running.exchange(false)) return;
+
+#ifdef _WIN32
+    SetEvent(impl->stopEvent);
+#else
+    char wake = 1;
+    if (write(impl->wakePipe[1], &wake, 1) < 0) {}
+#endif
+
+    if (impl->thread.joinable()) {
+        impl->thread.join();
+    }
+    impl->Close();
+}
+
+bool ConfigWatcher::IsRunning() const {
+    return impl->running;
+}
+
+uint64_t ConfigWatcher::GetReloadCount() const {
+    return impl->reloadCount;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include "config_file.h"
+
+// WATCHES ONE CONFIG FILE'S DIRECTORY (ReadDirectoryChangesW ON WINDOWS, inotify ELSEWHERE). AFTER A BURST OF WRITES
+// SETTLES IT REPARSES THE FILE AND, IF THE BYTES CHANGED, HANDS THE NEW PARSE TO THE CALLBACK ON THE WATCHER THREAD
+class ConfigWatcher {
+public:
+    typedef std::function<void(const std::shared_ptr<const ConfigFile>& config)> ChangeCallback;
+
+    static const int64_t DEFAULT_SETTLE_MS = 150;
+
+    ConfigWatcher();
+    ~ConfigWatcher();
+
+    bool Start(const std::string& path, ChangeCallback callback, int64_t settleMs = DEFAULT_SETTLE_MS);
+    void Stop();
+    bool IsRunning() const;
+
+    uint64_t GetReloadCount() const;
+
+private:
+    ConfigWatcher(const ConfigWatcher&);
+    ConfigWatcher& operator=(const ConfigWatcher&);
+
+    struct Impl;
+    std::unique_ptr<Impl> impl;
+};
@@ -0,0 +1,168 @@
+#include "config_writer.h"
+#include "trace_events.h"
+#include <algorithm>
+
+#ifdef _WIN32
+static const char* DEFAULT_LINE_END = "\r\n";
+#else
+static const char* DEFAULT_LINE_END = "\n";
+#endif
+
+// KEEP WHATEVER THE FILE ALREADY USES
+static std::string_view LineEndOf(std::string_view text) {
+    size_t newline = text.find('\n');
+    if (newline == std::string_view::npos) return DEFAULT_LINE_END;
+    return (newline > 0 && text[newline - 1] == '\r') ? std::string_view("\r\n") : std::string_view("\n");
+}
+
+static bool EndsWithNewline(const std::string& text) {
+    return !text.empty() && text.back() == '\n';
+}
+
+static bool EndsWithBlankLine(const std::string& text) {
+    if (!EndsWithNewline(text)) return false;
+
+    size_t previous = text.find_last_of('\n', text.size() - 2);
+    size_t lineStart = previous == std::string::npos ? 0 : previous + 1;
+    return text.find_first_not_of(" \t\r", lineStart) >= text.size() - 1;
+}
+
+ConfigWriter::ConfigWriter(const std::string& path) : path(path), base(ConfigFile::Open(path)), seeded(false) {
+}
+
+void ConfigWriter::SeedIfMissing(std::string content) {
+    if (base->IsLoaded()) return;
+
+    std::shared_ptr<ConfigFile> seededConfig = std::make_shared<ConfigFile>();
+    seededConfig->LoadFromString(std::move(content));
+    base = seededConfig;
+    seeded = true;
+}
+
+void ConfigWriter::AddPatch(std::string_view section, std::string_view key, std::string_view value, bool remove) {
+    for (auto& patch : patches) {
+        if (patch.section == section && patch.key == key) {
+            patch.value.assign(value.data(), value.size());
+            patch.remove = remove;
+            return;
+        }
+    }
+
+    Patch patch;
+    patch.section.assign(section.data(), section.size());
+    patch.key.assign(key.data(), key.size());
+    patch.value.assign(value.data(), value.size());
+    patch.remove = remove;
+    patches.push_back(std::move(patch));
+}
+
+void ConfigWriter::Set(std::string_view section, std::string_view key, std::string_view value) {
+    AddPatch(section, key, value, false);
+}
+
+void ConfigWriter::Remove(std::string_view section, std::string_view key) {
+    AddPatch(section, key, std::string_view(), true);
+}
+
+std::string ConfigWriter::Render() const {
+    std::string_view text = base->GetText();
+    std::string_view lineEnd = LineEndOf(text);
+
+    std::vector<Splice> splices;
+    std::vector<const Patch*> newSections;
+
+    for (const auto& patch : patches) {
+        const ConfigFile::Entry* entry = base->Find(patch.section, patch.key);
+
+        if (entry && patch.remove) {
+            splices.push_back(Splice{ entry->lineBegin, entry->lineEnd - entry->lineBegin, std::string() });
+        } else if (entry) {
+            if (entry->value == patch.value) continue;
+            size_t valueOffset = static_cast<size_t>(entry->value.data() - text.data());
+            splices.push_back(Splice{ valueOffset, entry->value.size(), patch.value });
+        } else if (!patch.remove) {
+            const ConfigFile::Section* section = base->FindSection(patch.section);
+            if (!section) {
+                newSections.push_back(&patch);
+                continue;
+            }
+
+            Splice insert{ section->insertAt, 0, std::string() };
+            if (insert.offset == text.size() && !text.empty() && text.back() != '\n') {
+                insert.text.append(lineEnd.data(), lineEnd.size());
+            }
+            insert.text += patch.key;
+            insert.text += '=';
+            insert.text += patch.value;
+            insert.text.append(lineEnd.data(), lineEnd.size());
+            splices.push_back(std::move(insert));
+        }
+    }
+
+    // INSERTS AT ONE OFFSET KEEP THE ORDER THEY WERE MADE IN
+    std::stable_sort(splices.begin(), splices.end(), [](const Splice& a, const Splice& b) { return a.offset < b.offset; });
+
+    std::string out;
+    out.reserve(text.size() + 64 * patches.size());
+
+    size_t copied = 0;
+    for (const auto& splice : splices) {
+        out.append(text.data() + copied, splice.offset - copied);
+        out += splice.text;
+        copied = splice.offset + splice.length;
+    }
+    out.append(text.data() + copied, text.size() - copied);
+
+    for (size_t i = 0; i < newSections.size(); i++) {
+        const std::string& name = newSections[i]->section;
+        bool firstOfSection = true;
+        for (size_t j = 0; j < i; j++) {
+            if (newSections[j]->section == name) firstOfSection = false;
+        }
+        if (!firstOfSection) continue;
+
+        // A BLANK LINE BEFORE THE NEW HEADER, AS THE FILE'S OWN SECTIONS ARE LAID OUT
+        if (!out.empty() && !EndsWithNewline(out)) out.append(lineEnd.data(), lineEnd.size());
+        if (!out.empty() && !EndsWithBlankLine(out)) out.append(lineEnd.data(), lineEnd.size());
+
+        out += '[';
+        out += name;
+        out += ']';
+        out.append(lineEnd.data(), lineEnd.size());
+
+        for (size_t j = i; j < newSections.size(); j++) {
+            if (newSections[j]->section != name) continue;
+
+            out += newSections[j]->key;
+            out += '=';
+            out += newSections[j]->value;
+            out.append(lineEnd.data(), lineEnd.size());
+        }
+    }
+
+    return out;
+}
+
+bool ConfigWriter::Commit(FileSync sync) {
+    TRACE_SCOPE("ConfigWriter::Commit", "config");
+    if (patches.empty()) {
+        return true;
+    }
+
+    std::string rendered = Render();
+    // A SEEDED DEFAULT STILL HAS TO REACH THE DISK EVEN WHEN THE EDITS CHANGE NOTHING
+    if (!seeded && base->IsLoaded() && rendered == base->GetText()) {
+        patches.clear();
+        return true;
+    }
+
+    if (!AtomicFile::Replace(path, rendered, sync)) {
+        return false;
+    }
+
+    ConfigFile::Invalidate(path);
+    patches.clear();
+    base = ConfigFile::Open(path);
+    seeded = false;
+    return true;
+}
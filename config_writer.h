@@ -0,0 +1,48 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "atomic_file.h"
+#include "config_file.h"
+
+// KEY-LEVEL EDITS TO Config.ini. PATCHES ARE SPLICED INTO THE ORIGINAL BYTES AT THE PARSER'S OFFSETS, SO COMMENTS,
+// ORDER AND UNTOUCHED LINES SURVIVE BYTE FOR BYTE; THE RESULT REPLACES THE FILE THROUGH AtomicFile
+class ConfigWriter {
+private:
+    struct Patch {
+        std::string section;
+        std::string key;
+        std::string value;
+        bool remove;
+    };
+
+    struct Splice {
+        size_t offset;
+        size_t length;
+        std::string text;
+    };
+
+    std::string path;
+    std::shared_ptr<const ConfigFile> base;
+    std::vector<Patch> patches;
+    bool seeded;
+
+    void AddPatch(std::string_view section, std::string_view key, std::string_view value, bool remove);
+
+public:
+    explicit ConfigWriter(const std::string& path);
+
+    // STARTS FROM content (THE EMBEDDED DEFAULT) WHEN THE FILE DOES NOT EXIST YET
+    void SeedIfMissing(std::string content);
+
+    // A LATER EDIT OF THE SAME KEY REPLACES AN EARLIER ONE. NEW KEYS GO AFTER THE LAST KEY OF THEIR SECTION,
+    // NEW SECTIONS AT THE END OF THE FILE
+    void Set(std::string_view section, std::string_view key, std::string_view value);
+    void Remove(std::string_view section, std::string_view key);
+
+    // WRITES ONLY WHEN THE BYTES CHANGE. THE WORK BEYOND ONE COPY OF THE FILE IS PROPORTIONAL TO THE EDITS
+    bool Commit(FileSync sync = FileSync::FILE);
+    std::string Render() const;
+};
@@ -0,0 +1,135 @@
+#include "device_cache.h"
+#include "trace_events.h"
+#include <fstream>
+#include <cstring>
+
+static const char CACHE_MAGIC[4] = {'M', 'K', 'D', 'C'};
+static const uint16_t CACHE_VERSION = 1;
+static const uint16_t MAX_CACHED_DEVICES = 256;
+
+enum CachedDeviceFlags : uint8_t {
+    CACHED_FLAG_MONITORED = 0x01,
+    CACHED_FLAG_ONLINE = 0x02
+};
+
+static void WriteU16(std::string& out, uint16_t value) {
+    out.push_back(static_cast<char>(value & 0xFF));
+    out.push_back(static_cast<char>((value >> 8) & 0xFF));
+}
+
+static void WriteString(std::string& out, const std::string& value) {
+    uint16_t length = static_cast<uint16_t>(value.size() > 0xFFFF ? 0xFFFF : value.size());
+    WriteU16(out, length);
+    out.append(value.data(), length);
+}
+
+static bool ReadU16(const std::string& in, size_t& pos, uint16_t& value) {
+    if (pos + 2 > in.size()) return false;
+    value = static_cast<uint16_t>(static_cast<uint8_t>(in[pos]) | (static_cast<uint8_t>(in[pos + 1]) << 8));
+    pos += 2;
+    return true;
+}
+
+static bool ReadString(const std::string& in, size_t& pos, std::string& value) {
+    uint16_t length = 0;
+    if (!ReadU16(in, pos, length)) return false;
+    if (pos + length > in.size()) return false;
+    value.assign(in, pos, length);
+    pos += length;
+    return true;
+}
+
+bool DeviceCache::Load(const std::string& filePath, std::vector<CachedDevice>& devices) {
+    TRACE_SCOPE("DeviceCache::Load", "config");
+    devices.clear();
+
+    std::ifstream file(filePath, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    file.close();
+
+    if (data.size() < 8 || memcmp(data.data(), CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0) {
+        return false;
+    }
+
+    size_t pos = 4;
+    uint16_t version = 0;
+    uint16_t count = 0;
+    if (!ReadU16(data, pos, version) || version != CACHE_VERSION) return false;
+    if (!ReadU16(data, pos, count) || count > MAX_CACHED_DEVICES) return false;
+
+    for (uint16_t i = 0; i < count; i++) {
+        if (pos + 6 > data.size()) {
+            devices.clear();
+            return false;
+        }
+
+        CachedDevice device;
+        uint8_t connectionType = static_cast<uint8_t>(data[pos++]);
+        uint8_t flags = static_cast<uint8_t>(data[pos++]);
+        device.status.level = static_cast<uint8_t>(data[pos++]);
+        device.status.isCharging = static_cast<uint8_t>(data[pos++]);
+        ReadU16(data, pos, device.status.BatVoltage);
+
+        device.connectionType = connectionType <= static_cast<uint8_t>(ConnectionType::UNKNOWN)
+            ? static_cast<ConnectionType>(connectionType) : ConnectionType::UNKNOWN;
+        device.isMonitored = (flags & CACHED_FLAG_MONITORED) != 0;
+        device.isOnline = (flags & CACHED_FLAG_ONLINE) != 0;
+
+        if (!ReadString(data, pos, device.name) ||
+            !ReadString(data, pos, device.imagePath) ||
+            !ReadString(data, pos, device.devicePath) ||
+            !ReadString(data, pos, device.vid) ||
+            !ReadString(data, pos, device.pid)) {
+            devices.clear();
+            return false;
+        }
+
+        devices.push_back(device);
+    }
+
+    return !devices.empty();
+}
+
+bool DeviceCache::Save(const std::string& filePath, const std::vector<CachedDevice>& devices) {
+    TRACE_SCOPE("DeviceCache::Save", "config");
+    std::string data;
+    data.reserve(64 + devices.size() * 192);
+
+    data.append(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    WriteU16(data, CACHE_VERSION);
+
+    uint16_t count = static_cast<uint16_t>(devices.size() > MAX_CACHED_DEVICES ? MAX_CACHED_DEVICES : devices.size());
+    WriteU16(data, count);
+
+    for (uint16_t i = 0; i < count; i++) {
+        const CachedDevice& device = devices[i];
+
+        uint8_t flags = 0;
+        if (device.isMonitored) flags |= CACHED_FLAG_MONITORED;
+        if (device.isOnline) flags |= CACHED_FLAG_ONLINE;
+
+        data.push_back(static_cast<char>(device.connectionType));
+        data.push_back(static_cast<char>(flags));
+        data.push_back(static_cast<char>(device.status.level));
+        data.push_back(static_cast<char>(device.status.isCharging));
+        WriteU16(data, device.status.BatVoltage);
+
+        WriteString(data, device.name);
+        WriteString(data, device.imagePath);
+        WriteString(data, device.devicePath);
+        WriteString(data, device.vid);
+        WriteString(data, device.pid);
+    }
+
+    std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    file.write(data.data(), static_cast<std::streamsize>(data.size()));
+    return file.good();
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "device_registry.h"
+
+struct CachedDevice {
+    std::string name;
+    std::string imagePath;
+    std::string devicePath;
+    std::string vid;
+    std::string pid;
+    ConnectionType connectionType;
+    bool isMonitored;
+    bool isOnline;
+    BatteryStatus status;
+};
+
+class DeviceCache {
+public:
+    static bool Load(const std::string& filePath, std::vector<CachedDevice>& devices);
+    static bool Save(const std::string& filePath, const std::vector<CachedDevice>& devices);
+
+    static const char* DefaultPath() { return "DeviceCache.bin"; }
+};
@@ -0,0 +1,428 @@
+#include "device_catalog.h"
+#include "atomic_file.h"
+#include "trace_events.h"
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// HEADER, ENTRY TABLE, (VID, PID) HASH SLOTS, ASSET TABLE, CURVE POINTS, THEN THE STRING POOL. EVERY TABLE IS 8-BYTE
+// ALIGNED AND READ IN PLACE. NATIVE BYTE ORDER, WHICH byteOrder CHECKS
+static const char CATALOG_MAGIC[4] = {'M', 'K', 'D', 'C'};
+static const uint16_t CATALOG_VERSION = 1;
+static const uint16_t CATALOG_BYTE_ORDER = 0x0102;
+static const uint16_t NO_ASSET = 0xFFFF;
+
+struct CatalogHeader {
+    char magic[4];
+    uint16_t version;
+    uint16_t byteOrder;
+    uint32_t entryCount;
+    uint32_t slotCount;
+    uint32_t assetCount;
+    uint32_t curvePointCount;
+    uint32_t stringBytes;
+    uint32_t reserved;
+    uint64_t entriesOffset;
+    uint64_t slotsOffset;
+    uint64_t assetsOffset;
+    uint64_t curvesOffset;
+    uint64_t stringsOffset;
+};
+
+struct CatalogEntry {
+    uint16_t vid;
+    uint16_t pid;
+    uint8_t kind;
+    uint8_t reserved;
+    uint16_t imageAsset;   // INDEX INTO THE ASSET TABLE, NO_ASSET FOR NONE
+    uint32_t name;         // OFFSET INTO THE STRING POOL
+    uint16_t nameLength;
+    uint16_t cadenceMs;
+    uint32_t curve;        // FIRST POINT IN THE CURVE TABLE
+    uint16_t curveCount;
+    uint16_t reserved2;
+};
+
+struct CatalogAsset {
+    uint32_t path;
+    uint32_t pathLength;
+};
+
+static_assert(sizeof(CatalogHeader) == 72, "CatalogHeader LAYOUT IS PART OF THE FILE FORMAT");
+static_assert(sizeof(CatalogEntry) == 24, "CatalogEntry LAYOUT IS PART OF THE FILE FORMAT");
+
+static size_t AlignUp(size_t offset) {
+    return (offset + 7) & ~static_cast<size_t>(7);
+}
+
+static uint32_t KeyOf(uint16_t vid, uint16_t pid) {
+    return (uint32_t(vid) << 16) | pid;
+}
+
+static size_t HomeSlot(uint32_t key, uint32_t slotCount) {
+    return static_cast<size_t>((key * 0x9E3779B1u) >> 8) & (slotCount - 1);
+}
+
+DeviceCatalog::DeviceCatalog() : data(nullptr), size(0), mappedView(nullptr), slots(nullptr), slotCount(0), loaded(false) {
+}
+
+DeviceCatalog::~DeviceCatalog() {
+    Unmap();
+}
+
+void DeviceCatalog::Clear() {
+    Unmap();
+    buffer.clear();
+    data = nullptr;
+    size = 0;
+    devices.clear();
+    slots = nullptr;
+    slotCount = 0;
+    loaded = false;
+}
+
+void DeviceCatalog::Unmap() {
+#ifndef _WIN32
+    if (mappedView) {
+        munmap(mappedView, size);
+        mappedView = nullptr;
+        data = nullptr;
+        size = 0;
+    }
+#endif
+}
+
+// POSIX MAPS THE FILE: A REPLACEMENT RENAMED OVER IT LEAVES THIS VIEW ALONE. WINDOWS REFUSES TO REPLACE A MAPPED FILE,
+// SO THERE THE (SMALL) CATALOG IS READ IN ONE GO INSTEAD, KEEPING THE FILE FREE FOR A DROP-IN UPDATE
+bool DeviceCatalog::MapFile(const std::string& path) {
+#ifdef _WIN32
+    FILE* file = nullptr;
+    if (fopen_s(&file, path.c_str(), "rb") != 0 || !file) {
+        return false;
+    }
+
+    bool read = false;
+    if (_fseeki64(file, 0, SEEK_END) == 0) {
+        long long fileSize = _ftelli64(file);
+        if (fileSize > 0 && _fseeki64(file, 0, SEEK_SET) == 0) {
+            buffer.resize(static_cast<size_t>(fileSize));
+            read = fread(&buffer[0], 1, buffer.size(), file) == buffer.size();
+        }
+    }
+    fclose(file);
+    if (!read) {
+        buffer.clear();
+        return false;
+    }
+
+    data = buffer.data();
+    size = buffer.size();
+#else
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat info;
+    void* view = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        view = mmap(NULL, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (view == MAP_FAILED) {
+        return false;
+    }
+
+    mappedView = view;
+    data = static_cast<const char*>(view);
+    size = static_cast<size_t>(info.st_size);
+#endif
+    return true;
+}
+
+bool DeviceCatalog::Load(const std::string& path) {
+    TRACE_SCOPE("DeviceCatalog::Load", "config");
+    Clear();
+    if (!MapFile(path) || !Index()) {
+        Clear();
+        return false;
+    }
+    return true;
+}
+
+bool DeviceCatalog::LoadFromBlob(std::string blob) {
+    Clear();
+    buffer = std::move(blob);
+    data = buffer.data();
+    size = buffer.size();
+    if (!Index()) {
+        Clear();
+        return false;
+    }
+    return true;
+}
+
+bool DeviceCatalog::LoadBuiltIn() {
+    return LoadFromBlob(Build(BuiltInRecords()));
+}
+
+// VALIDATES EVERY OFFSET BEFORE ANY VIEW IS HANDED OUT: A TRUNCATED OR FOREIGN FILE IS REJECTED, NOT READ PAST
+bool DeviceCatalog::Index() {
+    CatalogHeader header;
+    if (size < sizeof(header)) {
+        return false;
+    }
+    memcpy(&header, data, sizeof(header));
+
+    // OFFSETS COME FROM THE FILE: NEVER ADD TO THEM, ONLY COMPARE A LENGTH AGAINST THE ROOM LEFT AFTER ONE
+    auto fits = [](uint64_t offset, uint64_t count, uint64_t elemSize, uint64_t end) {
+        return offset <= end && count * elemSize <= end - offset;
+    };
+
+    bool valid = memcmp(header.magic, CATALOG_MAGIC, sizeof(CATALOG_MAGIC)) == 0 &&
+                 header.version == CATALOG_VERSION && header.byteOrder == CATALOG_BYTE_ORDER &&
+                 header.slotCount >= 16 && (header.slotCount & (header.slotCount - 1)) == 0 &&
+                 header.slotCount >= header.entryCount &&
+                 header.entriesOffset >= sizeof(header) &&
+                 header.stringsOffset <= size &&
+                 fits(header.entriesOffset, header.entryCount, sizeof(CatalogEntry), header.slotsOffset) &&
+                 fits(header.slotsOffset, header.slotCount, sizeof(uint32_t), header.assetsOffset) &&
+                 fits(header.assetsOffset, header.assetCount, sizeof(CatalogAsset), header.curvesOffset) &&
+                 fits(header.curvesOffset, header.curvePointCount, sizeof(uint16_t), header.stringsOffset) &&
+                 fits(header.stringsOffset, header.stringBytes, 1, size) &&
+                 header.entriesOffset % 8 == 0 && header.slotsOffset % 8 == 0 &&
+                 header.assetsOffset % 8 == 0 && header.curvesOffset % 8 == 0;
+    if (!valid) {
+        return false;
+    }
+
+    const CatalogEntry* entries = reinterpret_cast<const CatalogEntry*>(data + header.entriesOffset);
+    const CatalogAsset* assets = reinterpret_cast<const CatalogAsset*>(data + header.assetsOffset);
+    const uint16_t* curves = reinterpret_cast<const uint16_t*>(data + header.curvesOffset);
+    const char* strings = data + header.stringsOffset;
+    auto inStrings = [&header](uint32_t offset, uint32_t length) { return uint64_t(offset) + length <= header.stringBytes; };
+
+    devices.resize(header.entryCount);
+    for (uint32_t i = 0; i < header.entryCount; i++) {
+        const CatalogEntry& entry = entries[i];
+        if (entry.kind > static_cast<uint8_t>(DeviceKind::UNKNOWN) || !inStrings(entry.name, entry.nameLength) ||
+            uint64_t(entry.curve) + entry.curveCount > header.curvePointCount ||
+            (entry.imageAsset != NO_ASSET && entry.imageAsset >= header.assetCount)) {
+            return false;
+        }
+
+        CatalogDevice& device = devices[i];
+        device.vid = entry.vid;
+        device.pid = entry.pid;
+        device.kind = static_cast<DeviceKind>(entry.kind);
+        device.cadenceMs = entry.cadenceMs;
+        device.name = std::string_view(strings + entry.name, entry.nameLength);
+        device.imagePath = std::string_view();
+        if (entry.imageAsset != NO_ASSET) {
+            const CatalogAsset& asset = assets[entry.imageAsset];
+            if (!inStrings(asset.path, asset.pathLength)) return false;
+            device.imagePath = std::string_view(strings + asset.path, asset.pathLength);
+        }
+        device.voltageLut = DeviceProfiles::BuildVoltageLut(std::vector<uint16_t>(curves + entry.curve, curves + entry.curve + entry.curveCount));
+    }
+
+    slots = reinterpret_cast<const uint32_t*>(data + header.slotsOffset);
+    slotCount = header.slotCount;
+    for (uint32_t i = 0; i < slotCount; i++) {
+        if (slots[i] > header.entryCount) return false;
+    }
+
+    loaded = true;
+    return true;
+}
+
+const CatalogDevice* DeviceCatalog::Find(uint16_t vid, uint16_t pid) const {
+    if (!slotCount) {
+        return nullptr;
+    }
+
+    uint32_t key = KeyOf(vid, pid);
+    for (size_t slot = HomeSlot(key, slotCount), probes = 0; slots[slot] != 0 && probes < slotCount;
+         slot = (slot + 1) & (slotCount - 1), probes++) {
+        const CatalogDevice& device = devices[slots[slot] - 1];
+        if (device.vid == vid && device.pid == pid) {
+            return &device;
+        }
+    }
+    return nullptr;
+}
+
+const CatalogDevice* DeviceCatalog::Find(std::string_view vid, std::string_view pid) const {
+    uint16_t vidValue = 0;
+    uint16_t pidValue = 0;
+    if (!DeviceProfiles::ParsePid(vid, vidValue) || !DeviceProfiles::ParsePid(pid, pidValue)) {
+        return nullptr;
+    }
+    return Find(vidValue, pidValue);
+}
+
+std::string DeviceCatalog::Build(const std::vector<CatalogRecord>& records) {
+    std::string strings;
+    std::vector<CatalogEntry> entries;
+    std::vector<CatalogAsset> assets;
+    std::unordered_map<std::string, uint16_t> assetIds;
+    std::vector<uint16_t> curves;
+
+    entries.reserve(records.size());
+    for (const CatalogRecord& record : records) {
+        CatalogEntry entry;
+        memset(&entry, 0, sizeof(entry));
+        entry.vid = record.vid;
+        entry.pid = record.pid;
+        entry.kind = static_cast<uint8_t>(record.kind);
+        entry.cadenceMs = record.cadenceMs;
+
+        entry.name = static_cast<uint32_t>(strings.size());
+        entry.nameLength = static_cast<uint16_t>(record.name.size());
+        strings += record.name;
+
+        entry.imageAsset = NO_ASSET;
+        if (!record.imagePath.empty()) {
+            auto inserted = assetIds.emplace(record.imagePath, static_cast<uint16_t>(assets.size()));
+            if (inserted.second) {
+                assets.push_back(CatalogAsset{static_cast<uint32_t>(strings.size()), static_cast<uint32_t>(record.imagePath.size())});
+                strings += record.imagePath;
+            }
+            entry.imageAsset = inserted.first->second;
+        }
+
+        entry.curve = static_cast<uint32_t>(curves.size());
+        entry.curveCount = static_cast<uint16_t>(record.batteryCurve.size());
+        curves.insert(curves.end(), record.batteryCurve.begin(), record.batteryCurve.end());
+
+        entries.push_back(entry);
+    }
+
+    // HALF FULL AT MOST, SO A MISS ENDS ON AN EMPTY SLOT WITHIN A PROBE OR TWO
+    uint32_t slotCount = 16;
+    while (slotCount < entries.size() * 2) slotCount *= 2;
+    std::vector<uint32_t> slotTable(slotCount, 0);
+    for (size_t i = 0; i < entries.size(); i++) {
+        uint32_t key = KeyOf(entries[i].vid, entries[i].pid);
+        size_t slot = HomeSlot(key, slotCount);
+        bool duplicate = false;
+        for (; slotTable[slot] != 0; slot = (slot + 1) & (slotCount - 1)) {
+            const CatalogEntry& existing = entries[slotTable[slot] - 1];
+            if (KeyOf(existing.vid, existing.pid) == key) {
+                duplicate = true;   // THE FIRST RECORD OF A (VID, PID) WINS
+                break;
+            }
+        }
+        if (!duplicate) slotTable[slot] = static_cast<uint32_t>(i + 1);
+    }
+
+    CatalogHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CATALOG_MAGIC, sizeof(CATALOG_MAGIC));
+    header.version = CATALOG_VERSION;
+    header.byteOrder = CATALOG_BYTE_ORDER;
+    header.entryCount = static_cast<uint32_t>(entries.size());
+    header.slotCount = slotCount;
+    header.assetCount = static_cast<uint32_t>(assets.size());
+    header.curvePointCount = static_cast<uint32_t>(curves.size());
+    header.stringBytes = static_cast<uint32_t>(strings.size());
+    header.entriesOffset = sizeof(header);
+    header.slotsOffset = AlignUp(header.entriesOffset + entries.size() * sizeof(CatalogEntry));
+    header.assetsOffset = AlignUp(header.slotsOffset + slotTable.size() * sizeof(uint32_t));
+    header.curvesOffset = AlignUp(header.assetsOffset + assets.size() * sizeof(CatalogAsset));
+    header.stringsOffset = AlignUp(header.curvesOffset + curves.size() * sizeof(uint16_t));
+
+    std::string blob(static_cast<size_t>(header.stringsOffset) + strings.size(), '\0');
+    memcpy(&blob[0], &header, sizeof(header));
+    if (!entries.empty()) memcpy(&blob[static_cast<size_t>(header.entriesOffset)], entries.data(), entries.size() * sizeof(CatalogEntry));
+    memcpy(&blob[static_cast<size_t>(header.slotsOffset)], slotTable.data(), slotTable.size() * sizeof(uint32_t));
+    if (!assets.empty()) memcpy(&blob[static_cast<size_t>(header.assetsOffset)], assets.data(), assets.size() * sizeof(CatalogAsset));
+    if (!curves.empty()) memcpy(&blob[static_cast<size_t>(header.curvesOffset)], curves.data(), curves.size() * sizeof(uint16_t));
+    if (!strings.empty()) memcpy(&blob[static_cast<size_t>(header.stringsOffset)], strings.data(), strings.size());
+    return blob;
+}
+
+bool DeviceCatalog::Save(const std::string& path, const std::vector<CatalogRecord>& records) {
+    return AtomicFile::Replace(path, Build(records), FileSync::FILE);
+}
+
+bool DeviceCatalog::ParseSource(const ConfigFile& source, std::vector<CatalogRecord>& records, std::string& error) {
+    records.clear();
+
+    for (const ConfigFile::Section& section : source.GetSections()) {
+        if (source.FindSection(section.name) != &section) continue;
+
+        size_t colon = section.name.find(':');
+        CatalogRecord record;
+        if (colon == std::string_view::npos || !DeviceProfiles::ParsePid(section.name.substr(0, colon), record.vid) ||
+            !DeviceProfiles::ParsePid(section.name.substr(colon + 1), record.pid)) {
+            error = "[" + std::string(section.name) + "] is not [VID:PID]";
+            return false;
+        }
+
+        std::string_view kind = source.GetString(section.name, "Kind");
+        if (kind == "mouse") record.kind = DeviceKind::MOUSE;
+        else if (kind == "dongle") record.kind = DeviceKind::DONGLE;
+        else {
+            error = "[" + std::string(section.name) + "] Kind must be mouse or dongle";
+            return false;
+        }
+
+        record.name = std::string(source.GetString(section.name, "Name"));
+        record.imagePath = std::string(source.GetString(section.name, "Image"));
+        if (record.name.size() > 0xFFFF) {
+            error = "[" + std::string(section.name) + "] Name is too long";
+            return false;
+        }
+
+        long long cadence = source.GetInt(section.name, "CadenceMs", 0);
+        record.cadenceMs = static_cast<uint16_t>(cadence > 0 && cadence <= 0xFFFF ? cadence : 0);
+
+        bool curveValid = true;
+        ConfigFile::ForEachItem(source.GetString(section.name, "BatteryCurve"), ',', [&record, &curveValid](std::string_view item) {
+            long long millivolts = 0;
+            if (ConfigFile::ParseInt(item, millivolts) && millivolts > 0 && millivolts <= 0xFFFF) {
+                record.batteryCurve.push_back(static_cast<uint16_t>(millivolts));
+            } else {
+                curveValid = false;
+            }
+        });
+        if (!curveValid || (!record.batteryCurve.empty() && !DeviceProfiles::BuildVoltageLut(record.batteryCurve))) {
+            error = "[" + std::string(section.name) + "] BatteryCurve must rise strictly, in mV";
+            return false;
+        }
+
+        records.push_back(record);
+    }
+    return true;
+}
+
+// WHAT SHIPS IN THE EXECUTABLE: THE PIDS Config.ini LISTS, PLUS THE EARLIER MODELS THE OLD NAME TABLE KNEW
+const std::vector<CatalogRecord>& DeviceCatalog::BuiltInRecords() {
+    static const char* M1_PRO_IMAGE = "assets/pngs/mouse/m1_pro.png";
+    static const std::vector<uint16_t> M1_PRO_CURVE = {
+        3050, 3420, 3480, 3540, 3600, 3660, 3720, 3760, 3800, 3840,
+        3880, 3920, 3940, 3960, 3980, 4000, 4020, 4040, 4060, 4080, 4110
+    };
+
+    static const std::vector<CatalogRecord> records = {
+        { MONKA_VID, 0xF511, DeviceKind::MOUSE, "Monka M1 Pro", M1_PRO_IMAGE, M1_PRO_CURVE, 0 },
+        { MONKA_VID, 0xF5E5, DeviceKind::MOUSE, "Monka Mouse", M1_PRO_IMAGE, M1_PRO_CURVE, 0 },
+        { MONKA_VID, 0xF512, DeviceKind::DONGLE, "Monka Dongle", M1_PRO_IMAGE, {}, 0 },
+        { MONKA_VID, 0xF5E4, DeviceKind::DONGLE, "Monka Dongle", M1_PRO_IMAGE, {}, 0 },
+        { MONKA_VID, 0xF5E7, DeviceKind::DONGLE, "Monka Dongle", M1_PRO_IMAGE, {}, 0 },
+        { MONKA_VID, 0xB00E, DeviceKind::MOUSE, "Monka M1 Pro", M1_PRO_IMAGE, M1_PRO_CURVE, 0 },
+        { MONKA_VID, 0xB00F, DeviceKind::MOUSE, "Monka M2 Pro", M1_PRO_IMAGE, M1_PRO_CURVE, 0 },
+        { MONKA_VID, 0xB010, DeviceKind::MOUSE, "Monka M3 Pro", M1_PRO_IMAGE, M1_PRO_CURVE, 0 },
+        { MONKA_VID, 0xB012, DeviceKind::DONGLE, "Monka Dongle", M1_PRO_IMAGE, {}, 0 },
+        { MONKA_VID, 0xB013, DeviceKind::DONGLE, "Monka Dongle Pro", M1_PRO_IMAGE, {}, 0 },
+    };
+    return records;
+}
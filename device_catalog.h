@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "config_file.h"
+#include "device_profile.h"
+
+enum class DeviceKind : uint8_t {
+    MOUSE,
+    DONGLE,
+    UNKNOWN
+};
+
+// ONE MODEL AS WRITTEN INTO A CATALOG
+struct CatalogRecord {
+    uint16_t vid;
+    uint16_t pid;
+    DeviceKind kind;
+    std::string name;
+    std::string imagePath;
+    std::vector<uint16_t> batteryCurve;   // mV AT EVEN PERCENT STEPS; EMPTY FOR A DONGLE
+    uint16_t cadenceMs;                   // FASTEST THE MODEL ANSWERS A BATTERY REQUEST; 0 IS NO LIMIT
+};
+
+// ONE MODEL AS LOOKED UP: VIEWS INTO THE LOADED CATALOG, VALID WHILE IT IS
+struct CatalogDevice {
+    uint16_t vid;
+    uint16_t pid;
+    DeviceKind kind;
+    uint16_t cadenceMs;
+    std::string_view name;
+    std::string_view imagePath;
+    std::shared_ptr<const VoltageLut> voltageLut;   // nullptr WITHOUT A USABLE CURVE
+};
+
+// WHAT DISCOVERY KNOWS ABOUT EACH MONKA MODEL, KEYED BY (VID, PID). DeviceCatalog.bin NEXT TO Config.ini OVERRIDES
+// THE BUILT-IN COPY, SO A NEW MODEL NEEDS A NEW FILE, NOT A NEW BUILD (monka-battery --compile-catalog WRITES ONE).
+// IMMUTABLE ONCE LOADED; DISCOVERY SWAPS WHOLE CATALOGS
+class DeviceCatalog {
+public:
+    static const uint16_t MONKA_VID = 0x3554;
+
+    DeviceCatalog();
+    ~DeviceCatalog();
+
+    static const char* DefaultPath() { return "DeviceCatalog.bin"; }
+
+    // FALSE, LEAVING THE CATALOG EMPTY, FOR A MISSING FILE OR ONE THAT FAILS ANY CHECK
+    bool Load(const std::string& path);
+    bool LoadFromBlob(std::string blob);
+    bool LoadBuiltIn();
+    void Clear();
+    bool IsLoaded() const { return loaded; }
+
+    // ONE PROBE OF THE (VID, PID) TABLE
+    const CatalogDevice* Find(uint16_t vid, uint16_t pid) const;
+    // HEX TEXT, AS Config.ini AND THE REGISTRY CARRY THEM
+    const CatalogDevice* Find(std::string_view vid, std::string_view pid) const;
+    const std::vector<CatalogDevice>& GetDevices() const { return devices; }
+
+    static std::string Build(const std::vector<CatalogRecord>& records);
+    static bool Save(const std::string& path, const std::vector<CatalogRecord>& records);
+    // [VVVV:PPPP] SECTIONS WITH Kind=mouse|dongle, Name, Image, BatteryCurve, CadenceMs. FALSE ON A BAD SECTION
+    static bool ParseSource(const ConfigFile& source, std::vector<CatalogRecord>& records, std::string& error);
+    static const std::vector<CatalogRecord>& BuiltInRecords();
+
+private:
+    std::string buffer;
+    const char* data;
+    size_t size;
+    void* mappedView;
+    std::vector<CatalogDevice> devices;
+    const uint32_t* slots;   // ENTRY INDEX + 1, 0 IS EMPTY
+    uint32_t slotCount;
+    bool loaded;
+
+    bool MapFile(const std::string& path);
+    void Unmap();
+    bool Index();
+
+    // devices AND slots POINT INTO THE BLOB
+    DeviceCatalog(const DeviceCatalog&);
+    DeviceCatalog& operator=(const DeviceCatalog&);
+};
@@ -1,63 +1,14 @@
 #include "device_discovery.h"
 #include "mouse_item.h"
+#include "latency_trace.h"
+#include "trace_events.h"
+#include "config_file.h"
+#include "base64.h"
 #include <iostream>
-#include <fstream>
-#include <sstream>
-#include <map>
+#include <cstdio>
+#include <unordered_map>
 #include <algorithm>
 
-static const std::string base64_chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
-                                        "abcdefghijklmnopqrstuvwxyz"
-                                        "0123456789+/";
-
-bool DeviceDiscovery::is_base64(unsigned char c) {
-    return (isalnum(c) || (c == '+') || (c == '/'));
-}
-
-std::string DeviceDiscovery::base64_decode(const std::string& encoded_string) {
-    int in_len = static_cast<int>(encoded_string.size());
-    int i = 0;
-    int j = 0;
-    int in = 0;
-    unsigned char char_array_4[4], char_array_3[3];
-
-    std::string ret;
-
-    while (in_len-- && (encoded_string[in] != '=') && is_base64(encoded_string[in])) {
-        char_array_4[i++] = encoded_string[in];
-        in++;
-        if (i == 4) {
-            for (i = 0; i < 4; i++)
-                char_array_4[i] = static_cast<unsigned char>(base64_chars.find(char_array_4[i]));
-
-            char_array_3[0] = (char_array_4[0] << 2) + ((char_array_4[1] & 0x30) >> 4);
-            char_array_3[1] = ((char_array_4[1] & 0xf) << 4) + ((char_array_4[2] & 0x3c) >> 2);
-            char_array_3[2] = ((char_array_4[2] & 0x3) << 6) + char_array_4[3];
-
-            for (i = 0; (i < 3); i++)
-                ret += char_array_3[i];
-            i = 0;
-        }
-    }
-
-    if (i) {
-        for (j = i; j < 4; j++)
-            char_array_4[j] = 0;
-
-        for (j = 0; j < 4; j++)
-            char_array_4[j] = static_cast<unsigned char>(base64_chars.find(char_array_4[j]));
-
-        char_array_3[0] = (char_array_4[0] << 2) + ((char_array_4[1] & 0x30) >> 4);
-        char_array_3[1] = ((char_array_4[1] & 0xf) << 4) + ((char_array_4[2] & 0x3c) >> 2);
-        char_array_3[2] = ((char_array_4[2] & 0x3) << 6) + char_array_4[3];
-
-        for (j = 0; (j < i - 1); j++)
-            ret += char_array_3[j];
-    }
-
-    return ret;
-}
-
 bool DeviceDiscovery::extractResourceToDisk(int resourceId, const std::wstring& outputPath) {
     HMODULE hModule = GetModuleHandle(NULL);
     if (!hModule) return false;
@@ -116,6 +67,7 @@ DeviceDiscovery::~DeviceDiscovery() {
 }
 
 bool DeviceDiscovery::Initialize() {
+    TRACE_SCOPE("DeviceDiscovery::Initialize", "discovery");
     if (initialized.load()) return true;
 
     CoInitialize(NULL);
@@ -125,6 +77,14 @@ bool DeviceDiscovery::Initialize() {
         return false;
     }
 
+    heartbeat.LoadSettings("Config.ini");
+    batteryFilter.LoadSettings("Config.ini");
+    heartbeat.SetProbeCallback(heartbeatProbeCallback);
+
+    if (!statusPage.Open(StatusPage::DefaultName())) {
+        std::cerr << "Failed to create shared status page" << std::endl;
+    }
+
     if (!loadHidUsbDll()) {
         std::cerr << "Failed to load HID USB DLL - using mock data" << std::endl;
         usingMockData = true;
@@ -146,221 +106,121 @@ void DeviceDiscovery::Cleanup() {
     }
 
     discoveredDevices.clear();
-    lastBatteryUpdate.clear();
-    deviceBatteryStatus.clear();
+    heartbeat.DisarmAll();
+    batteryFilter.Clear();
+    statusPage.Close();
+    registry.Clear();
+    requestTracker.Clear();
+    monitoredDevice = INVALID_DEVICE_ID;
     initialized = false;
 
     CoUninitialize();
 }
 
 bool DeviceDiscovery::loadMonkaConfig() {
-    bool configLoaded = false;
-
-    std::ifstream configFile("Config.ini");
-    if (configFile.is_open()) {
-        configLoaded = parseConfigFromFile(configFile);
-        configFile.close();
-    }
+    TRACE_SCOPE("DeviceDiscovery::loadMonkaConfig", "config");
+    reloadCatalog();
+    std::shared_ptr<const ConfigFile> configFile = ConfigFile::Open("Config.ini");
+    bool configLoaded = configFile->IsLoaded() && parseConfig(*configFile);
 
     if (!configLoaded) {
         std::string configContent = loadResourceAsString(IDR_CONFIG_INI);
         if (!configContent.empty()) {
-            std::istringstream configStream(configContent);
-            configLoaded = parseConfigFromStream(configStream);
+            std::shared_ptr<ConfigFile> embeddedConfig = std::make_shared<ConfigFile>();
+            embeddedConfig->LoadFromString(std::move(configContent));
+            configLoaded = parseConfig(*embeddedConfig);
+            if (configLoaded) configFile = embeddedConfig;
         }
     }
 
-    // DEFAULTS
+    // DEFAULTS: EVERY MONKA MODEL THE CATALOG KNOWS
     if (!configLoaded) {
         config.company = "Monka";
         config.vid = "3554"; // MONKA VID
-        config.m_pids = {"b00e", "b00f"}; // MOUSE PIDs
-        config.d_pids = {"b012", "b013"}; // DONGLE PIDs
+        config.m_pids.clear();
+        config.d_pids.clear();
+        for (const CatalogDevice& device : std::atomic_load(&catalog)->GetDevices()) {
+            if (device.vid != DeviceCatalog::MONKA_VID) continue;
+            char pid[8];
+            snprintf(pid, sizeof(pid), "%04X", device.pid);
+            if (device.kind == DeviceKind::MOUSE) config.m_pids.push_back(pid);
+            else if (device.kind == DeviceKind::DONGLE) config.d_pids.push_back(pid);
+        }
         config.interface_id = 0;
         config.device_id = 0;
     }
 
+    reloadProfiles(*configFile);
     return true;
 }
 
-bool DeviceDiscovery::parseConfigFromFile(std::ifstream& configFile) {
-    config.company = "Monka";
-    std::string line;
-    bool inOptionSection = false;
-    bool inDevice1Section = false;
-
-    while (std::getline(configFile, line)) {
-        line.erase(0, line.find_first_not_of(" \t\r\n"));
-        line.erase(line.find_last_not_of(" \t\r\n") + 1);
-
-        if (line.empty() || line[0] == '#') continue;
-
-        if (line == "[Option]") {
-            inOptionSection = true;
-            continue;
-        } else if (line[0] == '[') {
-            inOptionSection = false;
-            continue;
-        }
-
-        if (!inOptionSection) continue;
-
-        size_t equalPos = line.find('=');
-        if (equalPos == std::string::npos) continue;
-
-        std::string key = line.substr(0, equalPos);
-        std::string value = line.substr(equalPos + 1);
-
-        try {
-            if (key == "VID") {
-                std::string decoded = base64_decode(value);
-                size_t pos = decoded.find(config.company);
-                if (pos != std::string::npos) {
-                    decoded.replace(pos, config.company.length(), "");
-                }
-                config.vid = decoded;
-            } else if (key == "M_PID") {
-                std::string decoded = base64_decode(value);
-                size_t pos = decoded.find(config.company);
-                if (pos != std::string::npos) {
-                    decoded.replace(pos, config.company.length(), "");
-                }
-                std::stringstream ss(decoded);
-                std::string pid;
-                while (std::getline(ss, pid, ',')) {
-                    if (!pid.empty()) {
-                        config.m_pids.push_back(pid);
-                    }
-                }
-            } else if (key == "D_PID") {
-                std::string decoded = base64_decode(value);
-                size_t pos = decoded.find(config.company);
-                if (pos != std::string::npos) {
-                    decoded.replace(pos, config.company.length(), "");
-                }
-                std::stringstream ss(decoded);
-                std::string pid;
-                while (std::getline(ss, pid, ',')) {
-                    if (!pid.empty()) {
-                        config.d_pids.push_back(pid);
-                    }
-                }
-            } else if (key == "Interfaceid") {
-                config.interface_id = std::stoi(value);
-            } else if (key == "Deviceid") {
-                config.device_id = std::stoi(value);
-            } else if (inDevice1Section && key == "BatteryParam") {
-                std::stringstream ss(value);
-                std::string voltage;
-                config.batteryParam.clear();
-                while (std::getline(ss, voltage, ',')) {
-                    if (!voltage.empty()) {
-                        config.batteryParam.push_back(std::stoi(voltage));
-                    }
-                }
-            }
-        } catch (const std::exception& e) {
-            std::cerr << "Error parsing config key " << key << ": " << e.what() << std::endl;
-        }
+// OBFUSCATED [Option] VALUES ARE BASE64 WITH THE COMPANY NAME MIXED IN
+std::string DeviceDiscovery::decodeConfigValue(std::string_view value) {
+    std::string decoded;
+    if (!Base64::Decode(value, decoded)) {
+        std::cerr << "Error decoding config value " << value << std::endl;
+        return decoded;
     }
 
-    configFile.close();
-
-    return !config.vid.empty() && !config.company.empty();
+    size_t pos = decoded.find(config.company);
+    if (pos != std::string::npos) {
+        decoded.replace(pos, config.company.length(), "");
+    }
+    return decoded;
 }
 
-bool DeviceDiscovery::parseConfigFromStream(std::istringstream& configStream) {
+bool DeviceDiscovery::parseConfig(const ConfigFile& configFile) {
     config.company = "Monka";
-    std::string line;
-    bool inOptionSection = false;
-    bool inDevice1Section = false;
-
-    while (std::getline(configStream, line)) {
-        line.erase(0, line.find_first_not_of(" \t\r\n"));
-        line.erase(line.find_last_not_of(" \t\r\n") + 1);
-
-        if (line.empty() || line[0] == '#') continue;
-
-        if (line == "[Option]") {
-            inOptionSection = true;
-            inDevice1Section = false;
-            continue;
-        } else if (line == "[Device1]") {
-            inOptionSection = false;
-            inDevice1Section = true;
-            continue;
-        } else if (line[0] == '[') {
-            inOptionSection = false;
-            inDevice1Section = false;
-            continue;
-        }
+    config.m_pids.clear();
+    config.d_pids.clear();
 
-        if (!inOptionSection && !inDevice1Section) continue;
+    std::string_view value;
+    if (configFile.Get(ConfigKey::OPTION_VID, value)) {
+        config.vid = decodeConfigValue(value);
+    }
 
-        size_t equalPos = line.find('=');
-        if (equalPos == std::string::npos) continue;
+    if (configFile.Get(ConfigKey::OPTION_M_PID, value)) {
+        std::string decoded = decodeConfigValue(value);
+        ConfigFile::ForEachItem(decoded, ',', [this](std::string_view pid) { config.m_pids.emplace_back(pid); });
+    }
 
-        std::string key = line.substr(0, equalPos);
-        std::string value = line.substr(equalPos + 1);
+    if (configFile.Get(ConfigKey::OPTION_D_PID, value)) {
+        std::string decoded = decodeConfigValue(value);
+        ConfigFile::ForEachItem(decoded, ',', [this](std::string_view pid) { config.d_pids.emplace_back(pid); });
+    }
 
-        try {
-            if (inOptionSection) {
-                if (key == "VID") {
-                    std::string decoded = base64_decode(value);
-                    size_t pos = decoded.find(config.company);
-                    if (pos != std::string::npos) {
-                        decoded.replace(pos, config.company.length(), "");
-                    }
-                    config.vid = decoded;
-                } else if (key == "M_PID") {
-                    std::string decoded = base64_decode(value);
-                    size_t pos = decoded.find(config.company);
-                    if (pos != std::string::npos) {
-                        decoded.replace(pos, config.company.length(), "");
-                    }
-                    std::stringstream ss(decoded);
-                    std::string pid;
-                    while (std::getline(ss, pid, ',')) {
-                        if (!pid.empty()) {
-                            config.m_pids.push_back(pid);
-                        }
-                    }
-                } else if (key == "D_PID") {
-                    std::string decoded = base64_decode(value);
-                    size_t pos = decoded.find(config.company);
-                    if (pos != std::string::npos) {
-                        decoded.replace(pos, config.company.length(), "");
-                    }
-                    std::stringstream ss(decoded);
-                    std::string pid;
-                    while (std::getline(ss, pid, ',')) {
-                        if (!pid.empty()) {
-                            config.d_pids.push_back(pid);
-                        }
-                    }
-                } else if (key == "Interfaceid") {
-                    config.interface_id = std::stoi(value);
-                } else if (key == "Deviceid") {
-                    config.device_id = std::stoi(value);
-                }
-            } else if (inDevice1Section && key == "BatteryParam") {
-                std::stringstream ss(value);
-                std::string voltage;
-                config.batteryParam.clear();
-                while (std::getline(ss, voltage, ',')) {
-                    if (!voltage.empty()) {
-                        config.batteryParam.push_back(std::stoi(voltage));
-                    }
-                }
-            }
-        } catch (const std::exception& e) {
-            std::cerr << "Error parsing config key " << key << ": " << e.what() << std::endl;
-        }
+    long long number = 0;
+    if (configFile.Get(ConfigKey::OPTION_INTERFACE_ID, value)) {
+        if (ConfigFile::ParseInt(value, number)) config.interface_id = static_cast<int>(number);
+        else std::cerr << "Error parsing config key Interfaceid" << std::endl;
+    }
+    if (configFile.Get(ConfigKey::OPTION_DEVICE_ID, value)) {
+        if (ConfigFile::ParseInt(value, number)) config.device_id = static_cast<int>(number);
+        else std::cerr << "Error parsing config key Deviceid" << std::endl;
     }
 
     return !config.vid.empty() && !config.company.empty();
 }
 
+// THE PID -> MID BINDING FOLLOWS [Option], SO THIS RUNS AFTER parseConfig
+void DeviceDiscovery::reloadProfiles(const ConfigFile& configFile) {
+    std::shared_ptr<DeviceProfiles> loaded = std::make_shared<DeviceProfiles>();
+    loaded->Load(configFile, config.m_pids, config.d_pids);
+    if (loaded->Size() == 0) {
+        std::cerr << "No [DeviceN] profiles in config, using device catalog data" << std::endl;
+    }
+    std::atomic_store(&profiles, std::shared_ptr<const DeviceProfiles>(loaded));
+}
+
+// A DROPPED-IN DeviceCatalog.bin WINS; WITHOUT ONE (OR IF IT FAILS ITS CHECKS) THE COPY BUILT INTO THE EXECUTABLE
+void DeviceDiscovery::reloadCatalog() {
+    std::shared_ptr<DeviceCatalog> loaded = std::make_shared<DeviceCatalog>();
+    if (!loaded->Load(DeviceCatalog::DefaultPath())) {
+        loaded->LoadBuiltIn();
+    }
+    std::atomic_store(&catalog, std::shared_ptr<const DeviceCatalog>(loaded));
+}
+
 bool DeviceDiscovery::loadHidUsbDll() {
     std::wstring tempDllPath = L"hidusb.dll";
     if (extractResourceToDisk(IDR_HIDUSB_DLL, tempDllPath)) {
@@ -409,9 +269,17 @@ bool DeviceDiscovery::isDonglePID(const std::string& pid) {
 }
 
 ConnectionType DeviceDiscovery::determineConnectionType(const std::string& pid, const std::string& devicePath) {
-    if (isDonglePID(pid)) {
+    // THE CATALOG'S KIND FIRST; [Option] LISTS ONLY CLASSIFY A PID THE CATALOG DOESN'T KNOW
+    std::shared_ptr<const DeviceCatalog> current = std::atomic_load(&catalog);
+    const CatalogDevice* model = current ? current->Find(config.vid, pid) : nullptr;
+    DeviceKind kind = model ? model->kind : DeviceKind::UNKNOWN;
+    if (kind == DeviceKind::UNKNOWN) {
+        kind = isDonglePID(pid) ? DeviceKind::DONGLE : isMousePID(pid) ? DeviceKind::MOUSE : DeviceKind::UNKNOWN;
+    }
+
+    if (kind == DeviceKind::DONGLE) {
         return ConnectionType::WIRELESS_DONGLE;
-    } else if (isMousePID(pid)) {
+    } else if (kind == DeviceKind::MOUSE) {
         std::string lowerPath = devicePath;
         std::transform(lowerPath.begin(), lowerPath.end(), lowerPath.begin(), ::tolower);
 
@@ -425,55 +293,62 @@ ConnectionType DeviceDiscovery::determineConnectionType(const std::string& pid,
 }
 
 std::string DeviceDiscovery::getDeviceNameFromPID(const std::string& pid) {
-    static std::map<std::string, std::string> pidToName = {
-        {"b00e", "Monka M1 Pro"},
-        {"b00f", "Monka M2 Pro"},
-        {"b010", "Monka M3 Pro"},
-        {"b012", "Monka Dongle"},
-        {"b013", "Monka Dongle Pro"}
-    };
-
-    auto it = pidToName.find(pid);
-    if (it != pidToName.end()) {
-        return it->second;
+    // A DeviceName IN THE PID'S OWN [DeviceN] WINS OVER THE CATALOG NAME
+    std::shared_ptr<const DeviceProfiles> currentProfiles = std::atomic_load(&profiles);
+    const DeviceProfile* profile = currentProfiles ? currentProfiles->FindByPid(pid) : nullptr;
+    if (profile && !profile->name.empty()) {
+        return profile->name;
+    }
+
+    std::shared_ptr<const DeviceCatalog> currentCatalog = std::atomic_load(&catalog);
+    const CatalogDevice* model = currentCatalog ? currentCatalog->Find(config.vid, pid) : nullptr;
+    if (model && !model->name.empty()) {
+        return std::string(model->name);
     }
     return "Monka Device";
 }
 
 std::string DeviceDiscovery::getDeviceImagePath(const std::string& pid, ConnectionType connectionType) {
+    std::shared_ptr<const DeviceCatalog> current = std::atomic_load(&catalog);
+    const CatalogDevice* model = current ? current->Find(config.vid, pid) : nullptr;
+    if (model && !model->imagePath.empty()) {
+        return std::string(model->imagePath);
+    }
     return "assets/pngs/mouse/m1_pro.png";
 }
 
-int DeviceDiscovery::calculateBatteryPercentage(uint16_t voltage) {
-    static const int BAT_VOLTAGE_TABLE[21] = {
-        3050, 3420, 3480, 3540, 3600, 3660, 3720, 3760, 3800, 3840,
-        3880, 3920, 3940, 3960, 3980, 4000, 4020, 4040, 4060, 4080, 4110
-    };
-
-    if (voltage >= BAT_VOLTAGE_TABLE[20]) {
-        return 100;
-    }
-
-    for (int i = 0; i < 20; i++) {
-        if (voltage < BAT_VOLTAGE_TABLE[i]) {
-            if (i == 0) return 0;
-
-            int prevVoltage = BAT_VOLTAGE_TABLE[i-1];
-            int nextVoltage = BAT_VOLTAGE_TABLE[i];
-            int prevPercent = (i-1) * 5;
-            int nextPercent = i * 5;
-
-            int percentage = prevPercent + ((voltage - prevVoltage) * (nextPercent - prevPercent)) / (nextVoltage - prevVoltage);
-
-            return (percentage < 0) ? 0 : ((percentage > 100) ? 100 : percentage);
+int DeviceDiscovery::calculateBatteryPercentage(DeviceId deviceId, uint16_t voltage) {
+    std::shared_ptr<const DeviceProfiles> currentProfiles = std::atomic_load(&profiles);
+    std::shared_ptr<const DeviceCatalog> currentCatalog = std::atomic_load(&catalog);
+    std::string_view vid = registry.IsValid(deviceId) ? std::string_view(registry.GetVid(deviceId)) : std::string_view();
+    std::string_view pid = registry.IsValid(deviceId) ? std::string_view(registry.GetPid(deviceId)) : std::string_view();
+
+    // THE PID'S OWN [DeviceN] CURVE, THEN ITS CATALOG CURVE, THEN THE DEFAULT PROFILE'S, THEN THE FIRST MONKA MOUSE'S
+    const DeviceProfile* profile = currentProfiles ? currentProfiles->FindByPid(pid) : nullptr;
+    const VoltageLut* lut = profile ? profile->voltageLut.get() : nullptr;
+    if (!lut && currentCatalog) {
+        const CatalogDevice* model = currentCatalog->Find(vid, pid);
+        lut = model ? model->voltageLut.get() : nullptr;
+    }
+    if (!lut && currentProfiles && currentProfiles->Default()) {
+        lut = currentProfiles->Default()->voltageLut.get();
+    }
+    if (!lut && currentCatalog) {
+        for (const CatalogDevice& device : currentCatalog->GetDevices()) {
+            if (device.vid == DeviceCatalog::MONKA_VID && device.kind == DeviceKind::MOUSE && device.voltageLut) {
+                lut = device.voltageLut.get();
+                break;
+            }
         }
     }
-
-    return 0;
+    return DeviceProfiles::LookupPercent(lut, voltage);
 }
 
 bool DeviceDiscovery::DiscoverDevices() {
+    TRACE_SCOPE("DeviceDiscovery::DiscoverDevices", "discovery");
+    reloadCatalog();
     discoveredDevices.clear();
+    registry.ClearFlagForAll(DEVICE_FLAG_DISCOVERED);
 
     if (!hidUsbDll || !CS_UsbFinder_FindHidDevicesByDeviceId) {
         std::cerr << "HID USB DLL not loaded or device discovery function not available" << std::endl;
@@ -486,125 +361,418 @@ bool DeviceDiscovery::DiscoverDevices() {
         size_t colonPos = combination.find(':');
         if (colonPos == std::string::npos) continue;
 
-        std::string vid = combination.substr(0, colonPos);
-        std::string pid = combination.substr(colonPos + 1);
-
-        try {
-            char vidStr[64], pidStr[64];
-            strncpy_s(vidStr, vid.c_str(), sizeof(vidStr) - 1);
-            strncpy_s(pidStr, pid.c_str(), sizeof(pidStr) - 1);
-
-            SAFEARRAY* deviceArray = CS_UsbFinder_FindHidDevicesByDeviceId(
-                vidStr, pidStr, config.interface_id, config.device_id);
-
-            if (deviceArray) {
-                LONG lbound, ubound;
-                if (SUCCEEDED(SafeArrayGetLBound(deviceArray, 1, &lbound)) &&
-                    SUCCEEDED(SafeArrayGetUBound(deviceArray, 1, &ubound))) {
-
-                    for (LONG i = lbound; i <= ubound; i++) {
-                        BSTR devicePath;
-                        if (SUCCEEDED(SafeArrayGetElement(deviceArray, &i, &devicePath))) {
-                            std::wstring wPath(devicePath);
-                            std::string pathStr(wPath.begin(), wPath.end());
-
-                            DeviceInfo device;
-                            device.devicePath = pathStr;
-                            device.vid = vid;
-                            device.pid = pid;
-                            device.name = getDeviceNameFromPID(pid);
-                            device.imagePath = getDeviceImagePath(pid, device.connectionType);
-                            device.connectionType = determineConnectionType(pid, pathStr);
-                            device.batteryLevel = 0;
-                            device.isCharging = false;
-
-                            device.isOnline = false;
-                            if (CS_UsbFinder_GetDeviceOnLine) {
-                                device.isOnline = CS_UsbFinder_GetDeviceOnLine(devicePath);
-                            }
-
-                            discoveredDevices.push_back(device);
-                            SysFreeString(devicePath);
+        discoverVidPid(combination.substr(0, colonPos), combination.substr(colonPos + 1));
+    }
+
+    return !discoveredDevices.empty();
+}
+
+size_t DeviceDiscovery::discoverVidPid(const std::string& vid, const std::string& pid) {
+    size_t before = discoveredDevices.size();
+
+    try {
+        char vidStr[64], pidStr[64];
+        strncpy_s(vidStr, vid.c_str(), sizeof(vidStr) - 1);
+        strncpy_s(pidStr, pid.c_str(), sizeof(pidStr) - 1);
+
+        SAFEARRAY* deviceArray = CS_UsbFinder_FindHidDevicesByDeviceId(
+            vidStr, pidStr, config.interface_id, config.device_id);
+
+        if (deviceArray) {
+            LONG lbound, ubound;
+            if (SUCCEEDED(SafeArrayGetLBound(deviceArray, 1, &lbound)) &&
+                SUCCEEDED(SafeArrayGetUBound(deviceArray, 1, &ubound))) {
+
+                for (LONG i = lbound; i <= ubound; i++) {
+                    BSTR devicePath;
+                    if (SUCCEEDED(SafeArrayGetElement(deviceArray, &i, &devicePath))) {
+                        std::wstring wPath(devicePath);
+                        std::string pathStr(wPath.begin(), wPath.end());
+
+                        DeviceInfo device;
+                        device.id = registry.Intern(pathStr, vid, pid);
+                        device.name = getDeviceNameFromPID(pid);
+                        device.connectionType = determineConnectionType(pid, pathStr);
+                        device.imagePath = getDeviceImagePath(pid, device.connectionType);
+                        device.batteryLevel = 0;
+                        device.isCharging = false;
+
+                        device.isOnline = false;
+                        if (CS_UsbFinder_GetDeviceOnLine) {
+                            device.isOnline = CS_UsbFinder_GetDeviceOnLine(devicePath);
                         }
+                        device.deviceAddress = queryDeviceAddress(devicePath);
+
+                        registry.SetConnectionType(device.id, device.connectionType);
+                        registry.SetFlag(device.id, DEVICE_FLAG_DISCOVERED, true);
+                        registry.SetFlag(device.id, DEVICE_FLAG_FINDER_ONLINE, device.isOnline);
+
+                        discoveredDevices.push_back(device);
+                        SysFreeString(devicePath);
                     }
                 }
-                SafeArrayDestroy(deviceArray);
             }
-        } catch (...) {
+            SafeArrayDestroy(deviceArray);
         }
+    } catch (...) {
     }
 
-    return !discoveredDevices.empty();
+    return discoveredDevices.size() - before;
+}
+
+size_t DeviceDiscovery::DiscoverPids(const std::vector<std::string>& pids) {
+    TRACE_SCOPE("DeviceDiscovery::DiscoverPids", "discovery");
+    if (!hidUsbDll || !CS_UsbFinder_FindHidDevicesByDeviceId) {
+        return 0;
+    }
+
+    size_t found = 0;
+    for (const auto& pid : pids) {
+        found += discoverVidPid(config.vid, pid);
+    }
+    return found;
+}
+
+size_t DeviceDiscovery::ForgetPids(const std::vector<std::string>& pids) {
+    size_t before = discoveredDevices.size();
+
+    auto removed = std::remove_if(discoveredDevices.begin(), discoveredDevices.end(), [this, &pids](const DeviceInfo& device) {
+        if (std::find(pids.begin(), pids.end(), registry.GetPid(device.id)) == pids.end()) return false;
+
+        registry.SetFlag(device.id, DEVICE_FLAG_DISCOVERED, false);
+        heartbeat.Disarm(device.id);
+        return true;
+    });
+    discoveredDevices.erase(removed, discoveredDevices.end());
+
+    DeviceId monitored = monitoredDevice.load();
+    if (monitored != INVALID_DEVICE_ID && std::find(pids.begin(), pids.end(), registry.GetPid(monitored)) != pids.end()) {
+        StopBatteryMonitoring();
+    }
+    return before - discoveredDevices.size();
+}
+
+// ONLY WHAT THE CHANGED KEYS TOUCH IS REBUILT; NOTHING HERE REOPENS THE DLL OR RESETS LIVE DEVICE STATE
+ConfigDelta DeviceDiscovery::ApplyConfigChanges(const ConfigFile& configFile, const std::vector<ConfigFile::KeyChange>& changes) {
+    TRACE_SCOPE("DeviceDiscovery::ApplyConfigChanges", "config");
+    ConfigDelta delta;
+    bool pidsChanged = false;
+
+    for (const auto& change : changes) {
+        switch (ConfigSchema::Identify(change.hash, change.section, change.key)) {
+        case ConfigKey::OPTION_M_PID:
+        case ConfigKey::OPTION_D_PID:
+            pidsChanged = true;
+            break;
+        case ConfigKey::OPTION_VID:
+        case ConfigKey::OPTION_INTERFACE_ID:
+        case ConfigKey::OPTION_DEVICE_ID:
+            delta.rediscover = true;
+            break;
+        case ConfigKey::HEARTBEAT_WIRED_CADENCE_MS:
+        case ConfigKey::HEARTBEAT_DONGLE_CADENCE_MS:
+        case ConfigKey::HEARTBEAT_BLUETOOTH_CADENCE_MS:
+        case ConfigKey::HEARTBEAT_MISS_LIMIT:
+        case ConfigKey::HEARTBEAT_TICK_MS:
+            delta.heartbeatChanged = true;
+            break;
+        case ConfigKey::FILTER_WINDOW:
+        case ConfigKey::FILTER_HYSTERESIS:
+            delta.filterChanged = true;
+            break;
+        default:
+            if (DeviceProfiles::IsProfileSection(change.section)) delta.profilesChanged = true;
+            break;
+        }
+    }
+
+    if (pidsChanged || delta.rediscover) {
+        MonkaConfig previous = config;
+        if (!parseConfig(configFile)) {
+            std::cerr << "Ignoring reloaded device identity: no VID" << std::endl;
+            config = previous;
+            delta.rediscover = false;
+        } else if (!delta.rediscover) {
+            auto collect = [](const std::vector<std::string>& from, const MonkaConfig& other, std::vector<std::string>& out) {
+                for (const auto& pid : from) {
+                    bool known = std::find(other.m_pids.begin(), other.m_pids.end(), pid) != other.m_pids.end() ||
+                                 std::find(other.d_pids.begin(), other.d_pids.end(), pid) != other.d_pids.end();
+                    if (!known) out.push_back(pid);
+                }
+            };
+            collect(config.m_pids, previous, delta.addedPids);
+            collect(config.d_pids, previous, delta.addedPids);
+            collect(previous.m_pids, config, delta.removedPids);
+            collect(previous.d_pids, config, delta.removedPids);
+            ForgetPids(delta.removedPids);
+        }
+    }
+
+    // NEW PIDS REBIND TO THEIR MID TOO
+    if (delta.profilesChanged || pidsChanged || delta.rediscover) {
+        reloadProfiles(configFile);
+        for (auto& device : discoveredDevices) {
+            device.name = getDeviceNameFromPID(registry.GetPid(device.id));
+        }
+    }
+    if (delta.heartbeatChanged) {
+        heartbeat.LoadSettings("Config.ini");
+    }
+    if (delta.filterChanged) {
+        batteryFilter.LoadSettings("Config.ini");
+    }
+
+    return delta;
+}
+
+// THE MOUSE'S OWN ADDRESS AS REPORTED THROUGH THIS ENDPOINT. OPAQUE BYTES: ONLY EVER COMPARED, NEVER INTERPRETED
+std::vector<uint8_t> DeviceDiscovery::queryDeviceAddress(BSTR devicePath) {
+    std::vector<uint8_t> address;
+    if (!CS_UsbFinder_GetDeviceOnLineWithAddress) {
+        return address;
+    }
+
+    SAFEARRAY* result = CS_UsbFinder_GetDeviceOnLineWithAddress(devicePath);
+    if (!result) {
+        return address;
+    }
+
+    LONG lbound, ubound;
+    void* data = nullptr;
+    if (SafeArrayGetDim(result) == 1 && SafeArrayGetElemsize(result) == 1 &&
+        SUCCEEDED(SafeArrayGetLBound(result, 1, &lbound)) &&
+        SUCCEEDED(SafeArrayGetUBound(result, 1, &ubound)) && ubound >= lbound &&
+        SUCCEEDED(SafeArrayAccessData(result, &data))) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        address.assign(bytes, bytes + (ubound - lbound + 1));
+        SafeArrayUnaccessData(result);
+    }
+    SafeArrayDestroy(result);
+
+    // A DONGLE WITH NOTHING PAIRED ANSWERS WITH ZEROS; THAT IS NOT AN IDENTITY
+    bool allZero = std::all_of(address.begin(), address.end(), [](uint8_t b) { return b == 0; });
+    if (allZero) {
+        address.clear();
+    }
+    return address;
 }
 
 std::vector<MouseItem> DeviceDiscovery::GetMouseItems() {
+    // ONE CARD PER PHYSICAL MOUSE: CONNECTIONS SHARING A DEVICE ADDRESS MERGE, IN DISCOVERY ORDER.
+    // ENDPOINTS WITHOUT AN ADDRESS (CACHE SEED, OLDER DLL) STILL GROUP BY NAME
+    std::unordered_map<std::string, size_t> groupByKey;
+    std::vector<size_t> firstDevice;
+    std::vector<std::vector<ConnectionInfo>> groups;
+    groupByKey.reserve(discoveredDevices.size());
+
+    std::string key;
+    for (size_t i = 0; i < discoveredDevices.size(); i++) {
+        const DeviceInfo& device = discoveredDevices[i];
+
+        if (!device.deviceAddress.empty()) {
+            key.assign(1, 'A');
+            key.append(device.deviceAddress.begin(), device.deviceAddress.end());
+        } else {
+            key.assign(1, 'N');
+            key += device.name;
+        }
+
+        auto inserted = groupByKey.emplace(key, groups.size());
+        if (inserted.second) {
+            firstDevice.push_back(i);
+            groups.push_back(std::vector<ConnectionInfo>());
+        }
+
+        groups[inserted.first->second].push_back(ConnectionInfo(
+            device.connectionType,
+            device.id,
+            device.isOnline,
+            device.batteryLevel,
+            device.isCharging
+        ));
+    }
+
     std::vector<MouseItem> mouseItems;
-    std::map<std::string, std::vector<DeviceInfo>> devicesByName;
+    mouseItems.reserve(groups.size());
+    for (size_t g = 0; g < groups.size(); g++) {
+        const DeviceInfo& first = discoveredDevices[firstDevice[g]];
+
+        std::wstring wName(first.name.begin(), first.name.end());
+        std::wstring wImagePath(first.imagePath.begin(), first.imagePath.end());
+        mouseItems.push_back(MouseItem(wName, wImagePath, groups[g]));
+    }
+
+    return mouseItems;
+}
+
+DeviceId DeviceDiscovery::SeedFromCache(const std::vector<CachedDevice>& cachedDevices) {
+    DeviceId preferredDevice = INVALID_DEVICE_ID;
+    discoveredDevices.clear();
+
+    for (const auto& cached : cachedDevices) {
+        DeviceId id = registry.Intern(cached.devicePath, cached.vid, cached.pid);
+        registry.SetConnectionType(id, cached.connectionType);
+        registry.SetFlag(id, DEVICE_FLAG_FINDER_ONLINE, cached.isOnline);
+        registry.StoreSample(id, cached.status, 0);
+
+        DeviceInfo device;
+        device.id = id;
+        device.name = cached.name;
+        device.imagePath = cached.imagePath;
+        device.connectionType = cached.connectionType;
+        device.isOnline = cached.isOnline;
+        device.isCharging = (cached.status.isCharging != 0);
+        if (cached.status.level > 0) {
+            device.batteryLevel = cached.status.level;
+        } else if (cached.status.BatVoltage > 0) {
+            device.batteryLevel = calculateBatteryPercentage(id, cached.status.BatVoltage);
+        } else {
+            device.batteryLevel = 0;
+        }
+
+        discoveredDevices.push_back(device);
+
+        if (cached.isMonitored) {
+            preferredDevice = id;
+        }
+    }
+
+    return preferredDevice;
+}
+
+std::vector<CachedDevice> DeviceDiscovery::BuildCacheSnapshot() {
+    std::vector<CachedDevice> snapshot;
+    snapshot.reserve(discoveredDevices.size());
+
+    DeviceId monitored = monitoredDevice.load();
+
+    for (const auto& device : discoveredDevices) {
+        CachedDevice cached;
+        cached.name = device.name;
+        cached.imagePath = device.imagePath;
+        cached.devicePath = registry.GetPath(device.id);
+        cached.vid = registry.GetVid(device.id);
+        cached.pid = registry.GetPid(device.id);
+        cached.connectionType = device.connectionType;
+        cached.isMonitored = (device.id == monitored);
+        cached.isOnline = device.isOnline || IsDeviceOnline(device.id);
+        cached.status = registry.GetSample(device.id);
+        snapshot.push_back(cached);
+    }
+
+    return snapshot;
+}
+
+void DeviceDiscovery::BuildStatusSnapshot(StatusSnapshot& snapshot) {
+    snapshot.clear();
+    snapshot.reserve(discoveredDevices.size());
+
+    DeviceId monitored = monitoredDevice.load();
 
     for (const auto& device : discoveredDevices) {
-        devicesByName[device.name].push_back(device);
-    }
-
-    for (auto it = devicesByName.begin(); it != devicesByName.end(); ++it) {
-        const std::string& deviceName = it->first;
-        const std::vector<DeviceInfo>& devices = it->second;
-
-        std::vector<ConnectionInfo> connections;
-
-        for (const auto& device : devices) {
-            ConnectionInfo connInfo(
-                device.connectionType,
-                device.devicePath,
-                device.isOnline,
-                device.batteryLevel,
-                device.isCharging,
-                device.vid,
-                device.pid
-            );
-            connections.push_back(connInfo);
+        BatteryStatus sample = registry.GetSample(device.id);
+
+        DeviceStatus status;
+        status.id = device.id;
+        status.name = device.name;
+        status.connectionType = device.connectionType;
+        status.linkState = heartbeat.GetState(device.id);
+        status.level = sample.level;
+        status.isCharging = (sample.isCharging != 0);
+        status.isMonitored = (device.id == monitored);
+        // THE HEARTBEAT IS AUTHORITATIVE FOR THE MONITORED DEVICE ONCE IT HAS AN OPINION
+        if (status.isMonitored && status.linkState != LinkState::UNKNOWN) {
+            status.isOnline = IsDeviceOnline(device.id);
+        } else {
+            status.isOnline = device.isOnline || IsDeviceOnline(device.id);
         }
+        status.voltage = sample.BatVoltage;
+        status.lastUpdateMs = registry.GetLastUpdateMs(device.id);
+        snapshot.push_back(status);
+    }
+}
+
+DeviceId DeviceDiscovery::PickPreferredDevice() const {
+    DeviceId bestDevice = INVALID_DEVICE_ID;
 
-        if (!devices.empty()) {
-            std::wstring wName(deviceName.begin(), deviceName.end());
-            std::wstring wImagePath(devices[0].imagePath.begin(), devices[0].imagePath.end());
+    for (const auto& device : discoveredDevices) {
+        if (!device.isOnline) continue;
 
-            MouseItem item(wName, wImagePath, connections);
-            mouseItems.push_back(item);
+        if (device.connectionType == ConnectionType::USB_WIRED) {
+            return device.id;
+        } else if (bestDevice == INVALID_DEVICE_ID || device.connectionType == ConnectionType::WIRELESS_DONGLE) {
+            bestDevice = device.id;
         }
     }
 
-    return mouseItems;
+    if (bestDevice == INVALID_DEVICE_ID && !discoveredDevices.empty()) {
+        bestDevice = discoveredDevices[0].id;
+    }
+    return bestDevice;
+}
+
+void DeviceDiscovery::BuildDeviceCounters(const StatusSnapshot& snapshot, std::vector<DeviceCounters>& counters) {
+    counters.clear();
+    counters.reserve(snapshot.size());
+
+    for (const auto& status : snapshot) {
+        DeviceCounters entry;
+        entry.id = status.id;
+        entry.requests = requestTracker.GetStats(status.id);
+        entry.reconnects = heartbeat.GetReconnectCount(status.id);
+        counters.push_back(entry);
+    }
 }
 
-bool DeviceDiscovery::IsDeviceOnline(const std::string& devicePath) {
-    auto it = lastBatteryUpdate.find(devicePath);
-    if (it == lastBatteryUpdate.end()) {
+bool DeviceDiscovery::IsDeviceOnline(DeviceId deviceId) {
+    if (!registry.IsValid(deviceId)) {
+        return false;
+    }
+
+    if (heartbeat.IsArmed(deviceId)) {
+        LinkState state = heartbeat.GetState(deviceId);
+        return state == LinkState::ONLINE || state == LinkState::SUSPECT;
+    }
+
+    int64_t lastUpdate = registry.GetLastUpdateMs(deviceId);
+    if (lastUpdate == 0) {
         return false;
     }
 
-    auto now = std::chrono::steady_clock::now();
-    auto timeSinceUpdate = std::chrono::duration_cast<std::chrono::seconds>(now - it->second).count();
-    return timeSinceUpdate < 10;
+    // NOT MONITORED: TRUST THE LAST REPLY FOR AS LONG AS THE HEARTBEAT WOULD HAVE
+    HeartbeatPolicy policy = heartbeat.GetPolicy(registry.GetConnectionType(deviceId));
+    return (SteadyNowMs() - lastUpdate) < policy.cadenceMs * (policy.missLimit + 1);
 }
 
-BatteryStatus DeviceDiscovery::GetBatteryStatus(const std::string& devicePath) {
-    auto it = deviceBatteryStatus.find(devicePath);
-    if (it != deviceBatteryStatus.end()) {
-        return it->second;
+BatteryStatus DeviceDiscovery::GetBatteryStatus(DeviceId deviceId) {
+    if (!registry.IsValid(deviceId)) {
+        return {0, 0, 0};
     }
-    return {0, 0, 0};
+    return registry.GetSample(deviceId);
 }
 
-bool DeviceDiscovery::StartBatteryMonitoring(const std::string& devicePath) {
-    if (!hidUsbDll || !CS_UsbServer_Start) {
+bool DeviceDiscovery::StartBatteryMonitoring(DeviceId deviceId) {
+    if (!hidUsbDll || !CS_UsbServer_Start || !registry.IsValid(deviceId)) {
         return false; 
     }
 
     char devicePathBuffer[512];
-    strncpy_s(devicePathBuffer, devicePath.c_str(), sizeof(devicePathBuffer) - 1);
+    strncpy_s(devicePathBuffer, registry.GetPath(deviceId).c_str(), sizeof(devicePathBuffer) - 1);
 
     CS_UsbServer_Start(devicePathBuffer, devicePathBuffer, reinterpret_cast<void*>(usbDataReceivedCallback));
 
+    DeviceId previous = monitoredDevice.exchange(deviceId);
+    if (previous != INVALID_DEVICE_ID && previous != deviceId) {
+        heartbeat.Disarm(previous);
+    }
+
+    registry.ClearFlagForAll(DEVICE_FLAG_MONITORED);
+    registry.SetFlag(deviceId, DEVICE_FLAG_MONITORED, true);
+
+    std::shared_ptr<const DeviceCatalog> current = std::atomic_load(&catalog);
+    const CatalogDevice* model = current ? current->Find(registry.GetVid(deviceId), registry.GetPid(deviceId)) : nullptr;
+    heartbeat.Arm(deviceId, registry.GetConnectionType(deviceId), SteadyNowMs(), model ? model->cadenceMs : 0);
+
     return true;
 }
 
@@ -612,23 +780,51 @@ void DeviceDiscovery::StopBatteryMonitoring() {
     if (hidUsbDll && CS_UsbServer_Exit) {
         CS_UsbServer_Exit();
     }
+
+    DeviceId previous = monitoredDevice.exchange(INVALID_DEVICE_ID);
+    if (previous != INVALID_DEVICE_ID) {
+        heartbeat.Disarm(previous);
+    }
+
+    registry.ClearFlagForAll(DEVICE_FLAG_MONITORED);
 }
 
-void DeviceDiscovery::RequestBatteryLevel(const std::string& devicePath) {
-    if (!hidUsbDll || !CS_UsbServer_ReadBatteryLevel) {
+void DeviceDiscovery::RequestBatteryLevel(DeviceId deviceId) {
+    if (!hidUsbDll || !CS_UsbServer_ReadBatteryLevel || !registry.IsValid(deviceId)) {
         return; 
     }
 
+    // THE DLL ONLY READS FROM THE ENDPOINT PASSED TO CS_UsbServer_Start
+    if (deviceId != monitoredDevice.load()) {
+        return;
+    }
+
+    requestTracker.OnRequestSent(deviceId, SteadyNowMs());
+
     CS_UsbServer_ReadBatteryLevel();
+}
 
-    lastBatteryUpdate[devicePath] = std::chrono::steady_clock::now();
+void DeviceDiscovery::ExpireBatteryRequests() {
+    uint32_t expired = requestTracker.ExpireRequests(SteadyNowMs());
+    if (expired > 0) {
+        OutputDebugStringA("Battery level request timed out without a reply\n");
+    }
 }
 
 DeviceDiscovery* DeviceDiscovery::instance = nullptr;
 
 void __cdecl DeviceDiscovery::usbDataReceivedCallback(void* pcmd, int cmdLength, void* pdata, int dataLength) {
+    TRACE_SCOPE("DeviceDiscovery::usbDataReceivedCallback", "hid");
     if (instance) {
+        LatencyTrace::Begin();
         instance->handleUsbData(pcmd, cmdLength, pdata, dataLength);
+        LatencyTrace::End();
+    }
+}
+
+void DeviceDiscovery::heartbeatProbeCallback(DeviceId deviceId) {
+    if (instance) {
+        instance->RequestBatteryLevel(deviceId);
     }
 }
 
@@ -639,13 +835,16 @@ void DeviceDiscovery::handleUsbData(void* pcmd, int cmdLength, void* pdata, int
     uint8_t commandId = cmdBytes[1];
 
     if (commandId == 4 && pdata && dataLength > 0) {
-        if (!discoveredDevices.empty()) {
-            processBatteryData(static_cast<uint8_t*>(pdata), dataLength, discoveredDevices[0].devicePath);
+        // NOTHING MONITORED (A REDISCOVERY MAY OWN THE DEVICE LIST): THE REPLY HAS NO DEVICE TO LAND ON
+        DeviceId deviceId = monitoredDevice.load();
+        if (deviceId != INVALID_DEVICE_ID) {
+            processBatteryData(static_cast<uint8_t*>(pdata), dataLength, deviceId);
         }
     }
 }
 
-void DeviceDiscovery::processBatteryData(uint8_t* data, int dataLength, const std::string& devicePath) {
+void DeviceDiscovery::processBatteryData(uint8_t* data, int dataLength, DeviceId deviceId) {
+    TRACE_SCOPE("DeviceDiscovery::processBatteryData", "hid");
     BatteryStatus status = {0, 0, 0};
 
     if (CS_GetDeviceBatteryStatus) {
@@ -658,11 +857,33 @@ void DeviceDiscovery::processBatteryData(uint8_t* data, int dataLength, const st
         }
     }
 
-    deviceBatteryStatus[devicePath] = status;
-    lastBatteryUpdate[devicePath] = std::chrono::steady_clock::now();
+    int64_t now = SteadyNowMs();
+    requestTracker.OnReply(deviceId, now, nullptr);
+    heartbeat.OnReport(deviceId, now);
+
+    // NEITHER A LEVEL NOR A VOLTAGE MEANS NO READING; A LEVEL OF 0 WITH A VOLTAGE IS A REAL EMPTY BATTERY
+    if (status.level == 0 && status.BatVoltage == 0) {
+        return;
+    }
+
+    int rawLevel = 0;
+    if (status.level > 0) {
+        rawLevel = status.level;
+    } else {
+        rawLevel = calculateBatteryPercentage(deviceId, status.BatVoltage);
+    }
+
+    int publishedLevel = rawLevel;
+    bool changed = batteryFilter.Update(deviceId, rawLevel, status.isCharging != 0, publishedLevel);
+
+    BatteryStatus filtered = status;
+    filtered.level = static_cast<uint8_t>(publishedLevel);
+    registry.StoreSample(deviceId, filtered, now);
+    statusPage.UpdateSample(deviceId, filtered, now);
+    LatencyTrace::Mark(LatencyStage::BATTERY_PARSED);
 
-    if (batteryUpdateCallback) {
-        batteryUpdateCallback(devicePath, status);
+    if (changed && batteryUpdateCallback) {
+        batteryUpdateCallback(deviceId, filtered);
     }
 }
 
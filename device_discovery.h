@@ -2,22 +2,28 @@
 
 #include <windows.h>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <map>
 #include <atomic>
 #include <chrono>
 #include <functional>
+#include <memory>
 #include "resource.h"
+#include "device_registry.h"
+#include "device_cache.h"
+#include "request_tracker.h"
+#include "heartbeat_monitor.h"
+#include "battery_filter.h"
+#include "status_protocol.h"
+#include "status_page.h"
+#include "metrics_exporter.h"
+#include "config_file.h"
+#include "device_profile.h"
+#include "device_catalog.h"
 
 struct MouseItem;
 
-enum class ConnectionType {
-    USB_WIRED,
-    WIRELESS_DONGLE,
-    BLUETOOTH,
-    UNKNOWN
-};
-
 struct DeviceInfo {
     std::string name;
     std::string imagePath;
@@ -25,9 +31,7 @@ struct DeviceInfo {
     bool isCharging;
     bool isOnline;
     ConnectionType connectionType;
-    std::string devicePath;
-    std::string vid;
-    std::string pid;
+    DeviceId id;
     std::vector<uint8_t> deviceAddress;
 };
 
@@ -38,16 +42,19 @@ struct MonkaConfig {
     int interface_id;
     int device_id;
     std::string company;
-    std::vector<int> batteryParam; 
 };
 
-struct BatteryStatus {
-    uint8_t level;
-    uint8_t isCharging;
-    uint16_t BatVoltage;
+// WHAT A CONFIG RELOAD STILL NEEDS FROM THE CALLER AFTER ApplyConfigChanges HAS UPDATED DISCOVERY'S OWN STATE
+struct ConfigDelta {
+    std::vector<std::string> addedPids;     // DISCOVER JUST THESE
+    std::vector<std::string> removedPids;   // ALREADY DROPPED FROM THE DEVICE LIST BY ForgetPids
+    bool rediscover = false;                // VID OR HID INTERFACE CHANGED: EVERY EXISTING PATH IS SUSPECT
+    bool profilesChanged = false;           // SOME [DeviceN] KEY: NAMES AND CURVES ARE ALREADY REBUILT
+    bool heartbeatChanged = false;
+    bool filterChanged = false;
 };
 
-typedef void(*BatteryUpdateCallback)(const std::string& devicePath, const BatteryStatus& status);
+typedef void(*BatteryUpdateCallback)(DeviceId deviceId, const BatteryStatus& status);
 
 class DeviceDiscovery {
 private:
@@ -73,19 +80,25 @@ private:
     CS_UsbFinder_GetDeviceOnLineFunc CS_UsbFinder_GetDeviceOnLine;
     CS_UsbFinder_GetDeviceOnLineWithAddressFunc CS_UsbFinder_GetDeviceOnLineWithAddress;
 
-    std::map<std::string, std::chrono::steady_clock::time_point> lastBatteryUpdate;
-    std::map<std::string, BatteryStatus> deviceBatteryStatus;
+    DeviceRegistry registry;
+    RequestTracker requestTracker;
+    HeartbeatMonitor heartbeat;
+    BatteryFilter batteryFilter;
+    StatusPage statusPage;
+    std::atomic<DeviceId> monitoredDevice{INVALID_DEVICE_ID};
     BatteryUpdateCallback batteryUpdateCallback; 
+    std::shared_ptr<const DeviceProfiles> profiles;   // SWAPPED WHOLE (atomic_store) SO THE USB CALLBACK NEVER SEES HALF A SET
+    std::shared_ptr<const DeviceCatalog> catalog;     // LIKEWISE; RE-READ BEFORE EACH FULL DISCOVERY
 
     static DeviceDiscovery* instance;
     static void __cdecl usbDataReceivedCallback(void* pcmd, int cmdLength, void* pdata, int dataLength);
-
-    std::string base64_decode(const std::string& encoded_string);
-    bool is_base64(unsigned char c);
+    static void heartbeatProbeCallback(DeviceId deviceId);
 
     bool loadMonkaConfig();
-    bool parseConfigFromFile(std::ifstream& configFile);
-    bool parseConfigFromStream(std::istringstream& configStream);
+    bool parseConfig(const ConfigFile& configFile);
+    void reloadProfiles(const ConfigFile& configFile);
+    void reloadCatalog();
+    std::string decodeConfigValue(std::string_view value);
     bool loadHidUsbDll();
 
     bool extractResourceToDisk(int resourceId, const std::wstring& outputPath);
@@ -96,7 +109,10 @@ private:
     bool isMousePID(const std::string& pid);
     bool isDonglePID(const std::string& pid);
 
+    size_t discoverVidPid(const std::string& vid, const std::string& pid);
+
     std::string getDeviceNameFromPID(const std::string& pid);
+    std::vector<uint8_t> queryDeviceAddress(BSTR devicePath);
     std::string getDeviceImagePath(const std::string& pid, ConnectionType connectionType);
 
 public:
@@ -106,22 +122,48 @@ public:
     bool Initialize();
     void Cleanup();
     bool DiscoverDevices();
+    // TARGETED: APPEND THE DEVICES OF THESE PIDS ONLY / DROP THEM, LEAVING EVERY OTHER DEVICE UNTOUCHED
+    size_t DiscoverPids(const std::vector<std::string>& pids);
+    size_t ForgetPids(const std::vector<std::string>& pids);
+    ConfigDelta ApplyConfigChanges(const ConfigFile& configFile, const std::vector<ConfigFile::KeyChange>& changes);
     std::vector<MouseItem> GetMouseItems();
 
-    bool StartBatteryMonitoring(const std::string& devicePath);
+    DeviceId SeedFromCache(const std::vector<CachedDevice>& cachedDevices);
+    std::vector<CachedDevice> BuildCacheSnapshot();
+    void BuildStatusSnapshot(StatusSnapshot& snapshot);
+    // WIRED FIRST, THEN DONGLE, THEN ANY ONLINE DEVICE; THE FIRST DISCOVERED ONE IF NONE IS ONLINE
+    DeviceId PickPreferredDevice() const;
+    void BuildDeviceCounters(const StatusSnapshot& snapshot, std::vector<DeviceCounters>& counters);
+    void PublishStatusPage(const StatusSnapshot& snapshot) { statusPage.Publish(snapshot); }
+
+    bool StartBatteryMonitoring(DeviceId deviceId);
     void StopBatteryMonitoring();
-    void RequestBatteryLevel(const std::string& devicePath);
+    void RequestBatteryLevel(DeviceId deviceId);
     void SetBatteryUpdateCallback(BatteryUpdateCallback callback);
+    void SetLinkStateCallback(LinkStateCallback callback) { heartbeat.SetStateCallback(callback); }
+
+    bool IsDeviceOnline(DeviceId deviceId);
+    BatteryStatus GetBatteryStatus(DeviceId deviceId);
+    const std::string& GetDevicePath(DeviceId deviceId) const { return registry.GetPath(deviceId); }
+    DeviceId GetMonitoredDevice() const { return monitoredDevice.load(); }
+    RequestStats GetRequestStats(DeviceId deviceId) const { return requestTracker.GetStats(deviceId); }
+    void ExpireBatteryRequests();
 
-    bool IsDeviceOnline(const std::string& devicePath);
-    BatteryStatus GetBatteryStatus(const std::string& devicePath);
+    void TickHeartbeats() { heartbeat.Tick(SteadyNowMs()); }
+    int64_t GetHeartbeatTickMs() const { return heartbeat.GetTickMs(); }
+    LinkState GetLinkState(DeviceId deviceId) const { return heartbeat.GetState(deviceId); }
+    uint32_t GetReconnectCount(DeviceId deviceId) const { return heartbeat.GetReconnectCount(deviceId); }
 
-    int calculateBatteryPercentage(uint16_t voltage);
+    // THROUGH THE CURVE OF THE DEVICE'S OWN MODEL
+    int calculateBatteryPercentage(DeviceId deviceId, uint16_t voltage);
+    std::shared_ptr<const DeviceProfiles> GetProfiles() const { return std::atomic_load(&profiles); }
+    std::shared_ptr<const DeviceCatalog> GetCatalog() const { return std::atomic_load(&catalog); }
 
     void handleUsbData(void* pcmd, int cmdLength, void* pdata, int dataLength);
-    void processBatteryData(uint8_t* data, int dataLength, const std::string& devicePath);
+    void processBatteryData(uint8_t* data, int dataLength, DeviceId deviceId);
 
     const std::vector<DeviceInfo>& GetDiscoveredDevices() const { return discoveredDevices; }
+    DeviceRegistry& GetRegistry() { return registry; }
     bool IsInitialized() const { return initialized.load(); }
     bool IsUsingMockData() const { return usingMockData; }
 };
@@ -0,0 +1,252 @@
+#include "device_profile.h"
+#include "base64.h"
+#include "trace_events.h"
+#include <algorithm>
+#include <charconv>
+#include <iostream>
+
+// DECIMAL, OR HEX WITH A 0x PREFIX (KeyParam, DPIRange FLAGS)
+static bool ParseNumber(std::string_view text, long long& value) {
+    text = ConfigFile::Trim(text);
+    if (text.size() > 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X')) {
+        std::from_chars_result result = std::from_chars(text.data() + 2, text.data() + text.size(), value, 16);
+        return result.ec == std::errc() && result.ptr == text.data() + text.size();
+    }
+    return ConfigFile::ParseInt(text, value);
+}
+
+template <typename T>
+static void ParseList(std::string_view value, std::vector<T>& out, long long low, long long high) {
+    out.clear();
+    ConfigFile::ForEachItem(value, ',', [&out, low, high](std::string_view item) {
+        long long number = 0;
+        if (ParseNumber(item, number) && number >= low && number <= high) out.push_back(static_cast<T>(number));
+    });
+}
+
+static std::string DecodeText(std::string_view value) {
+    std::string decoded;
+    if (!value.empty() && !Base64::Decode(value, decoded)) {
+        std::cerr << "Error decoding device profile value " << value << std::endl;
+    }
+    return decoded;
+}
+
+bool DeviceProfiles::IsProfileSection(std::string_view section) {
+    static const std::string_view PREFIX = "Device";
+    if (section.size() <= PREFIX.size() || section.substr(0, PREFIX.size()) != PREFIX) {
+        return false;
+    }
+    return std::all_of(section.begin() + PREFIX.size(), section.end(), [](char c) { return c >= '0' && c <= '9'; });
+}
+
+bool DeviceProfiles::ParsePid(std::string_view text, uint16_t& pid) {
+    text = ConfigFile::Trim(text);
+    if (text.empty() || text.size() > 4) {
+        return false;
+    }
+    unsigned value = 0;
+    std::from_chars_result result = std::from_chars(text.data(), text.data() + text.size(), value, 16);
+    if (result.ec != std::errc() || result.ptr != text.data() + text.size()) {
+        return false;
+    }
+    pid = static_cast<uint16_t>(value);
+    return true;
+}
+
+std::shared_ptr<const VoltageLut> DeviceProfiles::BuildVoltageLut(const std::vector<uint16_t>& batteryCurve) {
+    std::vector<int> curve(batteryCurve.begin(), batteryCurve.end());
+    bool usable = curve.size() >= 2 && curve.front() > 0;
+    for (size_t i = 1; usable && i < curve.size(); i++) {
+        usable = curve[i] > curve[i - 1];
+    }
+    if (!usable) {
+        return nullptr;
+    }
+
+    // THE CURVE IS THE VOLTAGE AT EVEN PERCENT STEPS (21 POINTS = EVERY 5%)
+    std::shared_ptr<VoltageLut> lut = std::make_shared<VoltageLut>();
+    lut->baseMv = curve.front();
+    lut->percent.resize(static_cast<size_t>(curve.back() - curve.front()));
+
+    int steps = static_cast<int>(curve.size()) - 1;
+    for (int i = 1; i <= steps; i++) {
+        int prevVoltage = curve[i - 1];
+        int nextVoltage = curve[i];
+        int prevPercent = (i - 1) * 100 / steps;
+        int nextPercent = i * 100 / steps;
+
+        for (int voltage = prevVoltage; voltage < nextVoltage; voltage++) {
+            int percentage = prevPercent + ((voltage - prevVoltage) * (nextPercent - prevPercent)) / (nextVoltage - prevVoltage);
+            lut->percent[voltage - lut->baseMv] = static_cast<uint8_t>(percentage);
+        }
+    }
+    return lut;
+}
+
+int DeviceProfiles::LookupPercent(const VoltageLut* lut, uint16_t voltage) {
+    if (!lut || voltage < lut->baseMv) {
+        return 0;
+    }
+
+    size_t index = static_cast<size_t>(voltage - lut->baseMv);
+    return index < lut->percent.size() ? lut->percent[index] : 100;
+}
+
+static void ParseProfile(const ConfigFile& config, std::string_view section, DeviceProfile& profile) {
+    profile.section.assign(section);
+    profile.name.assign(config.GetString(section, "DeviceName"));
+    profile.sensor = DecodeText(config.GetString(section, "Sensor"));
+    profile.mouseChip = DecodeText(config.GetString(section, "MM"));
+    profile.dongleChip = DecodeText(config.GetString(section, "DM"));
+
+    profile.xIn1 = static_cast<int>(config.GetInt(section, "XIn1", 0));
+    profile.keyNumber = static_cast<int>(config.GetInt(section, "KeyNumber", 0));
+    profile.defaultDpi = static_cast<int>(config.GetInt(section, "DefaultDPI", 0));
+    profile.dpiMaxGrade = static_cast<int>(config.GetInt(section, "DPIMaxGrade", 0));
+    profile.keyDebounceMs = static_cast<int>(config.GetInt(section, "KeyDebounceTime", 0));
+    profile.displayLight = config.GetBool(section, "DisplayLight", false);
+
+    std::vector<uint16_t> range;
+    ParseList(config.GetString(section, "DPIRange"), range, 0, 0xFFFF);
+    profile.dpiRange = DpiRange{0, 0, 0, 0};
+    if (range.size() >= 3) {
+        profile.dpiRange = DpiRange{range[0], range[1], range[2], static_cast<uint8_t>(range.size() > 3 ? range[3] : 0)};
+    }
+
+    ParseList(config.GetString(section, "DPIGrade"), profile.dpiGrades, 1, 0xFFFF);
+
+    // "r,g,b, r,g,b, ..." -> ONE PACKED COLOR PER TRIPLE; A TRAILING PARTIAL TRIPLE IS DROPPED
+    std::vector<uint8_t> channels;
+    ParseList(config.GetString(section, "DPIColor"), channels, 0, 255);
+    profile.dpiColors.clear();
+    for (size_t i = 0; i + 2 < channels.size(); i += 3) {
+        profile.dpiColors.push_back((uint32_t(channels[i]) << 16) | (uint32_t(channels[i + 1]) << 8) | channels[i + 2]);
+    }
+
+    ParseList(config.GetString(section, "SensorUI"), profile.sensorUi, 0, 255);
+    ParseList(config.GetString(section, "LightUI"), profile.lightUi, 0, 255);
+    ParseList(config.GetString(section, "Advanced"), profile.advanced, -32768, 32767);
+
+    // KeyParam1, KeyParam2, ... UNTIL THE FIRST GAP
+    profile.keys.clear();
+    std::string key = "KeyParam";
+    std::vector<uint16_t> fields;
+    for (int n = 1;; n++) {
+        key.resize(8);
+        key += std::to_string(n);
+        std::string_view value;
+        if (!config.Get(section, key, value)) break;
+
+        ParseList(value, fields, 0, 0xFFFF);
+        if (fields.size() < 6) continue;
+
+        KeyParam param;
+        param.x = fields[0];
+        param.y = fields[1];
+        for (int i = 0; i < 4; i++) param.codes[i] = static_cast<uint8_t>(fields[2 + i]);
+        profile.keys.push_back(param);
+    }
+
+    // THE SHIPPED BatteryParam LEADS WITH A 0 FIELD BEFORE THE 21 VOLTAGES; 0 mV IS NEVER A CURVE POINT
+    ParseList(config.GetString(section, "BatteryParam"), profile.batteryCurve, 0, 0xFFFF);
+    if (!profile.batteryCurve.empty() && profile.batteryCurve.front() == 0) {
+        profile.batteryCurve.erase(profile.batteryCurve.begin());
+    }
+    profile.voltageLut = DeviceProfiles::BuildVoltageLut(profile.batteryCurve);
+}
+
+void DeviceProfiles::Load(const ConfigFile& config, const std::vector<std::string>& mousePids, const std::vector<std::string>& donglePids) {
+    TRACE_SCOPE("DeviceProfiles::Load", "config");
+    profiles.clear();
+    midIndex.clear();
+    pidSlots.clear();
+    defaultIndex = 0;
+
+    for (const ConfigFile::Section& section : config.GetSections()) {
+        if (!IsProfileSection(section.name)) continue;
+        // A REPEATED [DeviceN] HEADER RESOLVES TO ITS LAST KEYS ALREADY; ONE PROFILE FOR IT
+        if (config.FindSection(section.name) != &section) continue;
+
+        // MID DEFAULTS TO THE SECTION NUMBER
+        long long sectionNumber = 0;
+        ConfigFile::ParseInt(section.name.substr(6), sectionNumber);
+        long long mid = config.GetInt(section.name, "MID", sectionNumber);
+        if (mid < 0 || mid > 0x7FFF) {
+            std::cerr << "Ignoring [" << section.name << "]: MID out of range" << std::endl;
+            continue;
+        }
+        if (static_cast<size_t>(mid) < midIndex.size() && midIndex[mid] >= 0) {
+            std::cerr << "Ignoring [" << section.name << "]: MID " << mid << " already used" << std::endl;
+            continue;
+        }
+
+        profiles.emplace_back();
+        DeviceProfile& profile = profiles.back();
+        profile.mid = static_cast<int>(mid);
+        ParseProfile(config, section.name, profile);
+
+        if (static_cast<size_t>(mid) >= midIndex.size()) {
+            midIndex.resize(static_cast<size_t>(mid) + 1, -1);
+        }
+        midIndex[mid] = static_cast<int16_t>(profiles.size() - 1);
+        if (profile.mid < profiles[defaultIndex].mid) {
+            defaultIndex = profiles.size() - 1;
+        }
+    }
+
+    size_t slotCount = 16;
+    while (slotCount < (mousePids.size() + donglePids.size()) * 2) slotCount *= 2;
+    pidSlots.assign(slotCount, 0);
+
+    for (size_t i = 0; i < mousePids.size(); i++) BindPid(mousePids[i], static_cast<int>(i) + 1);
+    for (size_t i = 0; i < donglePids.size(); i++) BindPid(donglePids[i], static_cast<int>(i) + 1);
+}
+
+static size_t PidHome(uint16_t pid, size_t mask) {
+    return (pid * 0x9E3779B1u >> 16) & mask;
+}
+
+void DeviceProfiles::BindPid(std::string_view text, int mid) {
+    uint16_t pid = 0;
+    const DeviceProfile* profile = FindByMid(mid);
+    if (!profile || !ParsePid(text, pid)) return;
+
+    uint32_t slotValue = (uint32_t(pid) << 16) | static_cast<uint32_t>(profile - profiles.data() + 1);
+    size_t mask = pidSlots.size() - 1;
+    for (size_t slot = PidHome(pid, mask);; slot = (slot + 1) & mask) {
+        if (pidSlots[slot] == 0) {
+            pidSlots[slot] = slotValue;
+            return;
+        }
+        // THE FIRST LISTING OF A PID WINS
+        if ((pidSlots[slot] >> 16) == pid) return;
+    }
+}
+
+const DeviceProfile* DeviceProfiles::FindByMid(int mid) const {
+    if (mid < 0 || static_cast<size_t>(mid) >= midIndex.size() || midIndex[mid] < 0) {
+        return nullptr;
+    }
+    return &profiles[midIndex[mid]];
+}
+
+const DeviceProfile* DeviceProfiles::FindByPid(std::string_view text) const {
+    uint16_t pid = 0;
+    if (pidSlots.empty() || !ParsePid(text, pid)) {
+        return nullptr;
+    }
+
+    size_t mask = pidSlots.size() - 1;
+    for (size_t slot = PidHome(pid, mask); pidSlots[slot] != 0; slot = (slot + 1) & mask) {
+        if ((pidSlots[slot] >> 16) == pid) {
+            return &profiles[(pidSlots[slot] & 0xFFFF) - 1];
+        }
+    }
+    return nullptr;
+}
+
+const DeviceProfile* DeviceProfiles::Resolve(std::string_view pid) const {
+    const DeviceProfile* profile = FindByPid(pid);
+    return profile ? profile : Default();
+}
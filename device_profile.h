@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "config_file.h"
+
+struct VoltageLut {
+    int baseMv;
+    std::vector<uint8_t> percent;   // [mV - baseMv]; BELOW baseMv IS 0%, PAST THE END 100%
+};
+
+struct DpiRange {
+    uint16_t minDpi;
+    uint16_t maxDpi;
+    uint16_t step;
+    uint8_t flags;
+};
+
+// KeyParamN: WHERE THE BUTTON SITS ON THE DEVICE IMAGE, THEN ITS FOUR RAW CODE BYTES
+struct KeyParam {
+    uint16_t x;
+    uint16_t y;
+    uint8_t codes[4];
+};
+
+// ONE [DeviceN] SECTION, DECODED ONCE. LISTS KEEP FILE ORDER; A MALFORMED ITEM IS DROPPED, NOT GUESSED
+struct DeviceProfile {
+    int mid;
+    std::string section;
+    std::string name;         // DeviceName; EMPTY MEANS THE CATALOG NAME FOR THE PID
+    std::string sensor;       // Sensor, MM, DM DECODED FROM BASE64
+    std::string mouseChip;
+    std::string dongleChip;
+    int xIn1;
+    int keyNumber;
+    int defaultDpi;
+    int dpiMaxGrade;
+    DpiRange dpiRange;
+    std::vector<uint16_t> dpiGrades;
+    std::vector<uint32_t> dpiColors;   // 0xRRGGBB, ONE PER GRADE
+    int keyDebounceMs;
+    std::vector<KeyParam> keys;        // KeyParam1..N
+    std::vector<uint8_t> sensorUi;
+    std::vector<uint8_t> lightUi;
+    bool displayLight;
+    std::vector<int16_t> advanced;
+    std::vector<uint16_t> batteryCurve;          // BatteryParam WITHOUT ITS LEADING 0 FIELD
+    std::shared_ptr<const VoltageLut> voltageLut;   // FROM batteryCurve; nullptr IF IT IS UNUSABLE
+};
+
+// EVERY [DeviceN] OF Config.ini, INDEXED BY MID AND BY PID. IMMUTABLE ONCE LOADED: A RELOAD BUILDS A NEW SET AND
+// SWAPS THE shared_ptr, SO READERS ON THE USB CALLBACK THREAD NEVER LOCK
+class DeviceProfiles {
+public:
+    DeviceProfiles() {}
+
+    // THE i-TH PID OF mousePids AND OF donglePids BELONGS TO MID i + 1, THE WAY [Option] LISTS THEM
+    void Load(const ConfigFile& config, const std::vector<std::string>& mousePids, const std::vector<std::string>& donglePids);
+
+    const DeviceProfile* FindByMid(int mid) const;
+    const DeviceProfile* FindByPid(std::string_view pid) const;
+    // THE LOWEST MID, FOR A PID NO SECTION CLAIMS. nullptr ONLY WHEN THERE IS NO [DeviceN] AT ALL
+    const DeviceProfile* Default() const { return profiles.empty() ? nullptr : &profiles[defaultIndex]; }
+    const DeviceProfile* Resolve(std::string_view pid) const;
+
+    const std::vector<DeviceProfile>& GetProfiles() const { return profiles; }
+    size_t Size() const { return profiles.size(); }
+
+    // "Device" FOLLOWED BY DIGITS
+    static bool IsProfileSection(std::string_view section);
+    // "F511", "b00e": UP TO FOUR HEX DIGITS
+    static bool ParsePid(std::string_view text, uint16_t& pid);
+    // ONE BYTE PER MILLIVOLT ACROSS THE CURVE, SO THE PER-SAMPLE LOOKUP IS AN INDEX; nullptr IF curve IS UNUSABLE
+    static std::shared_ptr<const VoltageLut> BuildVoltageLut(const std::vector<uint16_t>& curve);
+    static int LookupPercent(const VoltageLut* lut, uint16_t voltage);
+
+private:
+    std::vector<DeviceProfile> profiles;
+    std::vector<int16_t> midIndex;    // [MID] -> PROFILE, -1 IS NONE
+    std::vector<uint32_t> pidSlots;   // OPEN-ADDRESSED: PID << 16 | (PROFILE + 1), 0 IS EMPTY
+    size_t defaultIndex = 0;
+
+    void BindPid(std::string_view pid, int mid);
+
+    DeviceProfiles(const DeviceProfiles&);
+    DeviceProfiles& operator=(const DeviceProfiles&);
+};
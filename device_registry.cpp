@@ -0,0 +1,72 @@
+#include "device_registry.h"
+
+DeviceId DeviceRegistry::Intern(const std::string& path, const std::string& vid, const std::string& pid) {
+    auto it = pathIndex.find(path);
+    if (it != pathIndex.end()) {
+        return it->second;
+    }
+
+    DeviceId id = static_cast<DeviceId>(paths.size());
+    pathIndex.emplace(path, id);
+
+    // paths LAST: IsValid READS ITS SIZE, SO A NEW ID ONLY BECOMES VISIBLE ONCE EVERY COLUMN HOLDS IT
+    vids.push_back(vid);
+    pids.push_back(pid);
+
+    levels.push_back(0);
+    charging.push_back(0);
+    voltages.push_back(0);
+    lastUpdateMs.push_back(0);
+    flags.push_back(0);
+    connectionTypes.push_back(ConnectionType::UNKNOWN);
+
+    paths.push_back(path);
+
+    return id;
+}
+
+DeviceId DeviceRegistry::Find(const std::string& path) const {
+    auto it = pathIndex.find(path);
+    return it != pathIndex.end() ? it->second : INVALID_DEVICE_ID;
+}
+
+void DeviceRegistry::Clear() {
+    pathIndex.clear();
+    paths.clear();
+    vids.clear();
+    pids.clear();
+    levels.clear();
+    charging.clear();
+    voltages.clear();
+    lastUpdateMs.clear();
+    flags.clear();
+    connectionTypes.clear();
+}
+
+void DeviceRegistry::StoreSample(DeviceId id, const BatteryStatus& status, int64_t nowMs) {
+    levels[id] = status.level;
+    charging[id] = status.isCharging;
+    voltages[id] = status.BatVoltage;
+    lastUpdateMs[id] = nowMs;
+    flags[id] |= DEVICE_FLAG_HAS_SAMPLE;
+}
+
+BatteryStatus DeviceRegistry::GetSample(DeviceId id) const {
+    BatteryStatus status = {levels[id], charging[id], voltages[id]};
+    return status;
+}
+
+void DeviceRegistry::SetFlag(DeviceId id, DeviceFlags flag, bool enabled) {
+    if (enabled) {
+        flags[id] |= flag;
+    } else {
+        flags[id] &= static_cast<uint8_t>(~flag);
+    }
+}
+
+void DeviceRegistry::ClearFlagForAll(DeviceFlags flag) {
+    size_t count = flags.size();
+    for (size_t id = 0; id < count; id++) {
+        flags[id] &= static_cast<uint8_t>(~flag);
+    }
+}
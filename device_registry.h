@@ -0,0 +1,139 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <chrono>
+#include <atomic>
+#include <memory>
+
+typedef uint32_t DeviceId;
+
+const DeviceId INVALID_DEVICE_ID = 0xFFFFFFFFu;
+
+enum class ConnectionType {
+    USB_WIRED,
+    WIRELESS_DONGLE,
+    BLUETOOTH,
+    UNKNOWN
+};
+
+struct BatteryStatus {
+    uint8_t level;
+    uint8_t isCharging;
+    uint16_t BatVoltage;
+};
+
+enum DeviceFlags : uint8_t {
+    DEVICE_FLAG_DISCOVERED = 0x01,
+    DEVICE_FLAG_FINDER_ONLINE = 0x02,
+    DEVICE_FLAG_MONITORED = 0x04,
+    DEVICE_FLAG_HAS_SAMPLE = 0x08
+};
+
+inline int64_t SteadyNowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// ONE REGISTRY COLUMN WHOSE ELEMENTS NEVER MOVE. IT GROWS BY CHUNKS OF 16, 32, 64, ... AND ONLY clear FREES THEM, SO
+// THE HID THREAD CAN KEEP STORING SAMPLES FOR A DEVICE IT HOLDS WHILE DISCOVERY INTERNS NEW ONES. ONE WRITER APPENDS
+template <typename T>
+class StableColumn {
+private:
+    static const unsigned FIRST_CHUNK_BITS = 4;
+    static const unsigned MAX_CHUNKS = 28;
+
+    std::unique_ptr<T[]> chunks[MAX_CHUNKS];
+    std::atomic<size_t> count;
+
+    // INDEX + 16 HAS ITS TOP BIT AT 4 + CHUNK; THE BITS BELOW IT ARE THE POSITION INSIDE THAT CHUNK
+    static unsigned TopBit(uint64_t biased) {
+        unsigned bit = 0;
+        while (biased >>= 1) bit++;
+        return bit;
+    }
+
+    StableColumn(const StableColumn&);
+    StableColumn& operator=(const StableColumn&);
+
+public:
+    StableColumn() : count(0) {}
+
+    size_t size() const { return count.load(std::memory_order_acquire); }
+
+    T& operator[](size_t index) {
+        uint64_t biased = static_cast<uint64_t>(index) + (1ull << FIRST_CHUNK_BITS);
+        unsigned bit = TopBit(biased);
+        return chunks[bit - FIRST_CHUNK_BITS][biased - (1ull << bit)];
+    }
+
+    const T& operator[](size_t index) const {
+        uint64_t biased = static_cast<uint64_t>(index) + (1ull << FIRST_CHUNK_BITS);
+        unsigned bit = TopBit(biased);
+        return chunks[bit - FIRST_CHUNK_BITS][biased - (1ull << bit)];
+    }
+
+    void push_back(const T& value) {
+        size_t index = count.load(std::memory_order_relaxed);
+        uint64_t biased = static_cast<uint64_t>(index) + (1ull << FIRST_CHUNK_BITS);
+        unsigned bit = TopBit(biased);
+        std::unique_ptr<T[]>& chunk = chunks[bit - FIRST_CHUNK_BITS];
+        if (!chunk) {
+            chunk.reset(new T[static_cast<size_t>(1ull << bit)]);
+        }
+        chunk[biased - (1ull << bit)] = value;
+        count.store(index + 1, std::memory_order_release);
+    }
+
+    // NOTHING MAY STILL BE READING: THE CHUNKS ARE FREED
+    void clear() {
+        count.store(0, std::memory_order_release);
+        for (auto& chunk : chunks) {
+            chunk.reset();
+        }
+    }
+};
+
+class DeviceRegistry {
+private:
+    std::unordered_map<std::string, DeviceId> pathIndex;
+
+    StableColumn<std::string> paths;
+    StableColumn<std::string> vids;
+    StableColumn<std::string> pids;
+
+    StableColumn<uint8_t> levels;
+    StableColumn<uint8_t> charging;
+    StableColumn<uint16_t> voltages;
+    StableColumn<int64_t> lastUpdateMs;
+    StableColumn<uint8_t> flags;
+    StableColumn<ConnectionType> connectionTypes;
+
+public:
+    DeviceId Intern(const std::string& path, const std::string& vid, const std::string& pid);
+    DeviceId Find(const std::string& path) const;
+    void Clear();
+
+    size_t Size() const { return paths.size(); }
+    bool IsValid(DeviceId id) const { return id < paths.size(); }
+
+    const std::string& GetPath(DeviceId id) const { return paths[id]; }
+    const std::string& GetVid(DeviceId id) const { return vids[id]; }
+    const std::string& GetPid(DeviceId id) const { return pids[id]; }
+
+    ConnectionType GetConnectionType(DeviceId id) const { return connectionTypes[id]; }
+    void SetConnectionType(DeviceId id, ConnectionType type) { connectionTypes[id] = type; }
+
+    void StoreSample(DeviceId id, const BatteryStatus& status, int64_t nowMs);
+    BatteryStatus GetSample(DeviceId id) const;
+    bool HasSample(DeviceId id) const { return (flags[id] & DEVICE_FLAG_HAS_SAMPLE) != 0; }
+
+    int64_t GetLastUpdateMs(DeviceId id) const { return lastUpdateMs[id]; }
+    void SetLastUpdateMs(DeviceId id, int64_t ms) { lastUpdateMs[id] = ms; }
+
+    bool HasFlag(DeviceId id, DeviceFlags flag) const { return (flags[id] & flag) != 0; }
+    void SetFlag(DeviceId id, DeviceFlags flag, bool enabled);
+    void ClearFlagForAll(DeviceFlags flag);
+};
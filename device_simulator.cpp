@@ -0,0 +1,129 @@
+#include "device_simulator.h"
+
+static const ConnectionType SIMULATED_TYPES[] = {
+    ConnectionType::WIRELESS_DONGLE,
+    ConnectionType::USB_WIRED,
+    ConnectionType::BLUETOOTH
+};
+
+static uint16_t VoltageForLevel(int level) {
+    return static_cast<uint16_t>(3300 + level * 9);
+}
+
+DeviceSimulator::DeviceSimulator(uint32_t seed)
+    : rng(seed), monitoredDevice(INVALID_DEVICE_ID), reportIntervalMs(0) {
+}
+
+int64_t DeviceSimulator::IntervalFor(ConnectionType type) {
+    if (reportIntervalMs > 0) return reportIntervalMs;
+
+    std::uniform_int_distribution<int> jitter(0, 1000);
+    int64_t base = (type == ConnectionType::BLUETOOTH) ? 4000 : 2000;
+    return base + jitter(rng);
+}
+
+DeviceId DeviceSimulator::AddDevice(const std::string& name, ConnectionType type, int64_t nowMs) {
+    std::string path = "sim://" + std::to_string(registry.Size());
+    DeviceId id = registry.Intern(path, "SIM", "0000");
+
+    std::uniform_int_distribution<int> level(20, 100);
+    int initialLevel = level(rng);
+    BatteryStatus status = { static_cast<uint8_t>(initialLevel), 0, VoltageForLevel(initialLevel) };
+
+    registry.SetConnectionType(id, type);
+    registry.SetFlag(id, DEVICE_FLAG_DISCOVERED, true);
+    registry.SetFlag(id, DEVICE_FLAG_FINDER_ONLINE, true);
+    registry.StoreSample(id, status, nowMs);
+
+    names.push_back(name);
+    online.push_back(1);
+
+    // A FIXED CADENCE STARTS AT A RANDOM PHASE SO A LARGE FLEET DOESN'T REPORT IN LOCKSTEP
+    int64_t firstEvent = IntervalFor(type);
+    if (reportIntervalMs > 0) {
+        std::uniform_int_distribution<int64_t> phase(0, reportIntervalMs - 1);
+        firstEvent = phase(rng);
+    }
+    schedule.push(ScheduledEvent(nowMs + firstEvent, id));
+
+    if (monitoredDevice == INVALID_DEVICE_ID) {
+        monitoredDevice = id;
+        registry.SetFlag(id, DEVICE_FLAG_MONITORED, true);
+    }
+
+    return id;
+}
+
+void DeviceSimulator::AddDevices(size_t count, int64_t nowMs) {
+    for (size_t i = 0; i < count; i++) {
+        size_t index = registry.Size();
+        ConnectionType type = SIMULATED_TYPES[index % 3];
+        AddDevice("Simulated Mouse " + std::to_string(index + 1), type, nowMs);
+    }
+}
+
+void DeviceSimulator::Step(int64_t nowMs, std::vector<DeviceId>* reported) {
+    std::uniform_int_distribution<int> roll(0, 99);
+
+    while (!schedule.empty() && schedule.top().first <= nowMs) {
+        ScheduledEvent event = schedule.top();
+        schedule.pop();
+
+        DeviceId id = event.second;
+        // KEEP THE CADENCE ANCHORED TO THE SCHEDULE, NOT TO WHEN Step HAPPENED TO RUN
+        int64_t next = event.first + IntervalFor(registry.GetConnectionType(id));
+        schedule.push(ScheduledEvent(next > nowMs ? next : nowMs + 1, id));
+
+        ProcessEvent(id, roll(rng), nowMs, reported);
+    }
+}
+
+void DeviceSimulator::ProcessEvent(DeviceId id, int event, int64_t nowMs, std::vector<DeviceId>* reported) {
+    if (event < 2) {
+        online[id] = !online[id];
+        registry.SetFlag(id, DEVICE_FLAG_FINDER_ONLINE, online[id] != 0);
+    }
+    if (!online[id]) return;
+
+    BatteryStatus status = registry.GetSample(id);
+    int level = status.level;
+
+    if (event >= 2 && event < 5) {
+        status.isCharging = !status.isCharging;
+    } else if (status.isCharging) {
+        level = (level < 100) ? level + 1 : 100;
+    } else if (event < 40) {
+        level = (level > 1) ? level - 1 : 1;
+    }
+
+    // PLUG IN BEFORE RUNNING FLAT, UNPLUG ONCE FULL
+    if (level <= 5) status.isCharging = 1;
+    if (level >= 100) status.isCharging = 0;
+
+    status.level = static_cast<uint8_t>(level);
+    status.BatVoltage = VoltageForLevel(level);
+    registry.StoreSample(id, status, nowMs);
+    if (reported) reported->push_back(id);
+}
+
+void DeviceSimulator::BuildSnapshot(StatusSnapshot& snapshot) const {
+    snapshot.clear();
+    snapshot.reserve(registry.Size());
+
+    for (DeviceId id = 0; id < registry.Size(); id++) {
+        BatteryStatus sample = registry.GetSample(id);
+
+        DeviceStatus status;
+        status.id = id;
+        status.name = names[id];
+        status.connectionType = registry.GetConnectionType(id);
+        status.linkState = online[id] ? LinkState::ONLINE : LinkState::OFFLINE;
+        status.level = sample.level;
+        status.isCharging = sample.isCharging != 0;
+        status.isOnline = online[id] != 0;
+        status.isMonitored = (id == monitoredDevice);
+        status.voltage = sample.BatVoltage;
+        status.lastUpdateMs = registry.GetLastUpdateMs(id);
+        snapshot.push_back(status);
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <random>
+#include <string>
+#include <vector>
+#include "device_registry.h"
+#include "status_protocol.h"
+
+// SYNTHETIC MICE FOR THE HEADLESS SERVICE WHEN THE HID STACK IS MISSING (LINUX, NO DLL, NO DEVICE)
+class DeviceSimulator {
+private:
+    DeviceRegistry registry;
+    std::vector<std::string> names;
+    std::vector<uint8_t> online;
+    std::mt19937 rng;
+    DeviceId monitoredDevice;
+    int64_t reportIntervalMs;
+
+    // MIN-HEAP OF (DUE TIME, DEVICE): A STEP ONLY TOUCHES THE DEVICES THAT ACTUALLY REPORT
+    typedef std::pair<int64_t, DeviceId> ScheduledEvent;
+    std::priority_queue<ScheduledEvent, std::vector<ScheduledEvent>, std::greater<ScheduledEvent>> schedule;
+
+    int64_t IntervalFor(ConnectionType type);
+    void ProcessEvent(DeviceId id, int event, int64_t nowMs, std::vector<DeviceId>* reported);
+
+public:
+    explicit DeviceSimulator(uint32_t seed);
+
+    DeviceId AddDevice(const std::string& name, ConnectionType type, int64_t nowMs);
+    void AddDevices(size_t count, int64_t nowMs);
+
+    // 0 KEEPS THE DEFAULT 2-3 S (4-5 S BLUETOOTH) JITTERED CADENCE; SET BEFORE AddDevices
+    void SetReportIntervalMs(int64_t intervalMs) { reportIntervalMs = intervalMs; }
+
+    // APPENDS THE DEVICES THAT SENT A REPORT (ONLINE ONES ONLY) TO reported WHEN GIVEN
+    void Step(int64_t nowMs, std::vector<DeviceId>* reported = nullptr);
+    void BuildSnapshot(StatusSnapshot& snapshot) const;
+
+    size_t Size() const { return registry.Size(); }
+    bool IsOnline(DeviceId id) const { return online[id] != 0; }
+    DeviceRegistry& GetRegistry() { return registry; }
+};
@@ -0,0 +1,198 @@
+#include "fleet_monitor.h"
+#include "trace_events.h"
+
+static const uint8_t DEFAULT_LOW_LEVEL = 20;
+
+FleetMonitor* FleetMonitor::instance = nullptr;
+
+FleetMonitor::FleetMonitor(DeviceRegistry& registry)
+    : registry(registry), lowLevel(DEFAULT_LOW_LEVEL), totalReports(0) {
+    instance = this;
+    heartbeat.SetStateCallback(LinkStateChanged);
+}
+
+FleetMonitor::~FleetMonitor() {
+    heartbeat.SetStateCallback(nullptr);
+    if (instance == this) {
+        instance = nullptr;
+    }
+}
+
+// HEARTBEAT CALLBACKS RUN WITHOUT THE HEARTBEAT LOCK; OUR OWN LOCK IS NEVER HELD ACROSS A HEARTBEAT CALL
+void FleetMonitor::LinkStateChanged(DeviceId deviceId, LinkState state) {
+    if (!instance) return;
+
+    std::lock_guard<std::mutex> lock(instance->mutex);
+    if (deviceId >= instance->linkStates.size()) return;
+
+    instance->linkStates[deviceId] = state;
+    instance->MarkChangedLocked(deviceId);
+}
+
+void FleetMonitor::MarkChangedLocked(DeviceId deviceId) {
+    if (pendingChange[deviceId]) return;
+
+    pendingChange[deviceId] = 1;
+    changed.push_back(deviceId);
+}
+
+void FleetMonitor::SetReportInterval(int64_t intervalMs, uint32_t missLimit) {
+    // HALF AN INTERVAL OF SLACK SO A REPORT LANDING ON A PERIOD BOUNDARY DOESN'T COUNT AS A MISS
+    HeartbeatPolicy policy = { intervalMs + intervalMs / 2, missLimit };
+    heartbeat.SetPolicy(ConnectionType::USB_WIRED, policy);
+    heartbeat.SetPolicy(ConnectionType::WIRELESS_DONGLE, policy);
+    heartbeat.SetPolicy(ConnectionType::BLUETOOTH, policy);
+    heartbeat.SetPolicy(ConnectionType::UNKNOWN, policy);
+}
+
+void FleetMonitor::Track(DeviceId deviceId, int64_t nowMs) {
+    if (!registry.IsValid(deviceId)) return;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (deviceId >= reportCounts.size()) {
+            size_t size = static_cast<size_t>(deviceId) + 1;
+            reportCounts.resize(size, 0);
+            linkStates.resize(size, LinkState::UNKNOWN);
+            pendingChange.resize(size, 0);
+        }
+        linkStates[deviceId] = LinkState::UNKNOWN;
+        MarkChangedLocked(deviceId);
+    }
+
+    heartbeat.Arm(deviceId, registry.GetConnectionType(deviceId), nowMs);
+}
+
+void FleetMonitor::TrackAll(int64_t nowMs) {
+    TRACE_SCOPE("FleetMonitor::TrackAll", "fleet");
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        changed.reserve(registry.Size());
+    }
+
+    for (DeviceId id = 0; id < registry.Size(); id++) {
+        Track(id, nowMs);
+    }
+}
+
+void FleetMonitor::OnReport(DeviceId deviceId, const BatteryStatus& status, int64_t nowMs) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (deviceId >= reportCounts.size()) return;
+
+        registry.StoreSample(deviceId, status, nowMs);
+        reportCounts[deviceId]++;
+        totalReports++;
+        MarkChangedLocked(deviceId);
+    }
+
+    heartbeat.OnReport(deviceId, nowMs);
+}
+
+void FleetMonitor::Tick(int64_t nowMs) {
+    heartbeat.Tick(nowMs);
+}
+
+size_t FleetMonitor::DrainChanged(std::vector<DeviceId>& out) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    out.clear();
+    out.swap(changed);
+    for (DeviceId id : out) {
+        pendingChange[id] = 0;
+    }
+    return out.size();
+}
+
+bool FleetMonitor::HasChanges() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return !changed.empty();
+}
+
+void FleetMonitor::Summarize(FleetSummary& summary) const {
+    TRACE_SCOPE("FleetMonitor::Summarize", "fleet");
+    std::lock_guard<std::mutex> lock(mutex);
+
+    summary = FleetSummary();
+    summary.minLevel = 100;
+    summary.reports = totalReports;
+
+    uint64_t levelSum = 0;
+    for (DeviceId id = 0; id < linkStates.size(); id++) {
+        LinkState state = linkStates[id];
+        if (state == LinkState::ONLINE) summary.online++;
+        else if (state == LinkState::SUSPECT) summary.suspect++;
+        else if (state == LinkState::OFFLINE) summary.offline++;
+
+        summary.devices++;
+        if (!registry.HasSample(id)) continue;
+
+        BatteryStatus sample = registry.GetSample(id);
+        if (sample.isCharging) summary.charging++;
+        if (sample.level < lowLevel) summary.low++;
+        if (sample.level < summary.minLevel) summary.minLevel = sample.level;
+
+        summary.levelBuckets[sample.level >= 100 ? 10 : sample.level / 10]++;
+        levelSum += sample.level;
+    }
+
+    size_t sampled = 0;
+    for (int i = 0; i < 11; i++) {
+        sampled += summary.levelBuckets[i];
+    }
+    if (sampled == 0) {
+        summary.minLevel = 0;
+    } else {
+        summary.averageLevel = static_cast<uint8_t>(levelSum / sampled);
+    }
+}
+
+size_t FleetMonitor::CollectBelow(uint8_t level, std::vector<DeviceId>& out) const {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    out.clear();
+    for (DeviceId id = 0; id < linkStates.size(); id++) {
+        if (registry.HasSample(id) && registry.GetSample(id).level < level) {
+            out.push_back(id);
+        }
+    }
+    return out.size();
+}
+
+size_t FleetMonitor::CollectSilent(int64_t nowMs, int64_t silentMs, std::vector<DeviceId>& out) const {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    out.clear();
+    for (DeviceId id = 0; id < linkStates.size(); id++) {
+        if (nowMs - registry.GetLastUpdateMs(id) >= silentMs) {
+            out.push_back(id);
+        }
+    }
+    return out.size();
+}
+
+void FleetMonitor::ApplyLinkStates(StatusSnapshot& snapshot) const {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    for (auto& status : snapshot) {
+        if (status.id >= linkStates.size() || linkStates[status.id] == LinkState::UNKNOWN) continue;
+
+        status.linkState = linkStates[status.id];
+        status.isOnline = status.linkState != LinkState::OFFLINE;
+    }
+}
+
+LinkState FleetMonitor::GetLinkState(DeviceId deviceId) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return deviceId < linkStates.size() ? linkStates[deviceId] : LinkState::UNKNOWN;
+}
+
+uint32_t FleetMonitor::GetReportCount(DeviceId deviceId) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return deviceId < reportCounts.size() ? reportCounts[deviceId] : 0;
+}
+
+size_t FleetMonitor::Size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return reportCounts.size();
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include "device_registry.h"
+#include "heartbeat_monitor.h"
+#include "status_protocol.h"
+
+struct FleetSummary {
+    size_t devices;
+    size_t online;
+    size_t suspect;
+    size_t offline;
+    size_t charging;
+    size_t low;
+    uint8_t minLevel;
+    uint8_t averageLevel;
+    uint32_t levelBuckets[11];   // 0-9%, 10-19% ... 90-99%, 100%
+    uint64_t reports;
+};
+
+// MANY RECEIVERS ON ONE HOST. SAMPLES LIVE IN THE CALLER'S DeviceRegistry (ALREADY STRUCTURE-OF-ARRAYS);
+// THIS ADDS PER-DEVICE COUNTERS, A HEARTBEAT PER DEVICE AND A CHANGED LIST, SO A REPORT COSTS O(1)
+// AND CONSUMERS ONLY TOUCH THE DEVICES THAT MOVED
+class FleetMonitor {
+private:
+    mutable std::mutex mutex;
+    DeviceRegistry& registry;
+    HeartbeatMonitor heartbeat;
+    uint8_t lowLevel;
+
+    std::vector<uint32_t> reportCounts;
+    std::vector<LinkState> linkStates;
+    std::vector<uint8_t> pendingChange;
+    std::vector<DeviceId> changed;
+    uint64_t totalReports;
+
+    static FleetMonitor* instance;
+    static void LinkStateChanged(DeviceId deviceId, LinkState state);
+
+    void MarkChangedLocked(DeviceId deviceId);
+
+public:
+    explicit FleetMonitor(DeviceRegistry& registry);
+    ~FleetMonitor();
+
+    // EVERY DEVICE IS EXPECTED TO REPORT ON ITS OWN ONCE PER intervalMs; missLimit SILENT INTERVALS MEAN OFFLINE
+    void SetReportInterval(int64_t intervalMs, uint32_t missLimit);
+    void SetLowLevel(uint8_t level) { lowLevel = level; }
+
+    void Track(DeviceId deviceId, int64_t nowMs);
+    void TrackAll(int64_t nowMs);
+
+    void OnReport(DeviceId deviceId, const BatteryStatus& status, int64_t nowMs);
+    void Tick(int64_t nowMs);
+
+    // SWAPS OUT THE DEVICES THAT CHANGED SINCE THE LAST DRAIN (EACH AT MOST ONCE)
+    size_t DrainChanged(std::vector<DeviceId>& out);
+    bool HasChanges() const;
+
+    // BATCH QUERIES: ONE LINEAR PASS OVER THE PACKED ARRAYS
+    void Summarize(FleetSummary& summary) const;
+    size_t CollectBelow(uint8_t level, std::vector<DeviceId>& out) const;
+    size_t CollectSilent(int64_t nowMs, int64_t silentMs, std::vector<DeviceId>& out) const;
+    void ApplyLinkStates(StatusSnapshot& snapshot) const;
+
+    LinkState GetLinkState(DeviceId deviceId) const;
+    uint32_t GetReportCount(DeviceId deviceId) const;
+    size_t Size() const;
+
+private:
+    FleetMonitor(const FleetMonitor&);
+    FleetMonitor& operator=(const FleetMonitor&);
+};
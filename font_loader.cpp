@@ -1,11 +1,14 @@
 #include "font_loader.h"
 #include "resource.h"
+#include "trace_events.h"
+#include "process_metrics.h"
 #include <vector>
 
 bool FontLoader::initialized = false;
 std::map<std::pair<CustomFontFamily, FontWeight>, Gdiplus::Font*> FontLoader::fontCache;
 
 bool FontLoader::Initialize() {
+    TRACE_SCOPE("FontLoader::Initialize", "font");
     if (initialized) return true;
 
     Gdiplus::GdiplusStartupInput gdiplusStartupInput;
@@ -25,6 +28,7 @@ void FontLoader::Cleanup() {
 }
 
 Gdiplus::Font* FontLoader::LoadFontWeight(CustomFontFamily family, FontWeight weight, float size) {
+    TRACE_SCOPE("FontLoader::LoadFontWeight", "font");
     HMODULE hModule = GetModuleHandle(NULL);
     if (!hModule) return nullptr;
 
@@ -236,6 +240,7 @@ Gdiplus::Font* FontLoader::GetFont(CustomFontFamily family, FontWeight weight, f
 
     if (it != fontCache.end()) {
         if (it->second->GetSize() == size) {
+            ProcessMetrics::Increment(ProcessCounter::FONT_CACHE_HITS);
             return it->second;
         } else {
             delete it->second;
@@ -243,6 +248,7 @@ Gdiplus::Font* FontLoader::GetFont(CustomFontFamily family, FontWeight weight, f
         }
     }
 
+    ProcessMetrics::Increment(ProcessCounter::FONT_CACHE_MISSES);
     Gdiplus::Font* font = LoadFontWeight(family, weight, size);
     if (font) {
         fontCache[key] = font;
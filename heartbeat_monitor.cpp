@@ -0,0 +1,286 @@
+#include "heartbeat_monitor.h"
+#include "trace_events.h"
+#include "config_file.h"
+#include <algorithm>
+#include <utility>
+
+static const int32_t NO_SLOT = -1;
+
+// EACH CADENCE IS ONE HID BATTERY READ AND EACH TICK ONE WINDOW-THREAD WAKEUP, SO THE DEFAULTS STAY NEAR 1 s DETECTION
+// (2 MISSED 500 ms HEARTBEATS) AT 2 Hz / 4 Hz. [Heartbeat] CAN GO SUB-SECOND WHERE THAT LOAD IS WORTH IT
+HeartbeatMonitor::HeartbeatMonitor()
+    : tickMs(250), lastTickMs(0), stateCallback(nullptr), probeCallback(nullptr) {
+    policies[static_cast<int>(ConnectionType::USB_WIRED)] = { 500, 2 };
+    policies[static_cast<int>(ConnectionType::WIRELESS_DONGLE)] = { 500, 2 };
+    policies[static_cast<int>(ConnectionType::BLUETOOTH)] = { 2000, 2 };
+    policies[static_cast<int>(ConnectionType::UNKNOWN)] = { 2000, 2 };
+
+    for (int i = 0; i < WHEEL_SLOTS; i++) {
+        wheel[i] = INVALID_DEVICE_ID;
+    }
+}
+
+void HeartbeatMonitor::LoadSettings(const std::string& configPath) {
+    TRACE_SCOPE("HeartbeatMonitor::LoadSettings", "config");
+    std::shared_ptr<const ConfigFile> config = ConfigFile::Open(configPath);
+
+    long long wired = config->GetInt(ConfigKey::HEARTBEAT_WIRED_CADENCE_MS, 0);
+    long long dongle = config->GetInt(ConfigKey::HEARTBEAT_DONGLE_CADENCE_MS, 0);
+    long long bluetooth = config->GetInt(ConfigKey::HEARTBEAT_BLUETOOTH_CADENCE_MS, 0);
+    long long limit = config->GetInt(ConfigKey::HEARTBEAT_MISS_LIMIT, 0);
+    long long tick = config->GetInt(ConfigKey::HEARTBEAT_TICK_MS, 0);
+
+    // POLICIES AND tickMs ARE SHARED WITH Arm, GetPolicy AND Tick
+    std::lock_guard<std::mutex> lock(mutex);
+    if (wired > 0) {
+        policies[static_cast<int>(ConnectionType::USB_WIRED)].cadenceMs = wired;
+    }
+    if (dongle > 0) {
+        policies[static_cast<int>(ConnectionType::WIRELESS_DONGLE)].cadenceMs = dongle;
+    }
+    if (bluetooth > 0) {
+        policies[static_cast<int>(ConnectionType::BLUETOOTH)].cadenceMs = bluetooth;
+        policies[static_cast<int>(ConnectionType::UNKNOWN)].cadenceMs = bluetooth;
+    }
+    if (limit > 0) {
+        for (int i = 0; i < 4; i++) {
+            policies[i].missLimit = static_cast<uint32_t>(limit);
+        }
+    }
+    if (tick > 0 && tick != tickMs) {
+        // WHEEL SLOTS ARE deadline / tickMs: RE-FILE EVERY ARMED DEVICE UNDER THE NEW TICK
+        std::vector<DeviceId> armed;
+        for (DeviceId id = 0; id < slotOf.size(); id++) {
+            if (slotOf[id] != NO_SLOT) armed.push_back(id);
+        }
+        for (DeviceId id : armed) Unlink(id);
+        tickMs = tick;
+        for (DeviceId id : armed) Link(id, deadlineMs[id]);
+    }
+}
+
+void HeartbeatMonitor::SetPolicy(ConnectionType type, const HeartbeatPolicy& policy) {
+    std::lock_guard<std::mutex> lock(mutex);
+    policies[static_cast<int>(type)] = policy;
+}
+
+HeartbeatPolicy HeartbeatMonitor::GetPolicy(ConnectionType type) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return policies[static_cast<int>(type)];
+}
+
+void HeartbeatMonitor::EnsureDevice(DeviceId deviceId) {
+    if (deviceId < states.size()) return;
+
+    size_t size = static_cast<size_t>(deviceId) + 1;
+    deadlineMs.resize(size, 0);
+    cadenceMs.resize(size, 0);
+    missLimit.resize(size, 0);
+    missed.resize(size, 0);
+    reported.resize(size, 0);
+    states.resize(size, LinkState::UNKNOWN);
+    reconnects.resize(size, 0);
+    slotOf.resize(size, NO_SLOT);
+    nextInSlot.resize(size, INVALID_DEVICE_ID);
+    prevInSlot.resize(size, INVALID_DEVICE_ID);
+}
+
+int HeartbeatMonitor::SlotFor(int64_t deadline) const {
+    return static_cast<int>((deadline / tickMs) % WHEEL_SLOTS);
+}
+
+void HeartbeatMonitor::Link(DeviceId deviceId, int64_t deadline) {
+    int slot = SlotFor(deadline);
+    DeviceId head = wheel[slot];
+
+    deadlineMs[deviceId] = deadline;
+    slotOf[deviceId] = slot;
+    prevInSlot[deviceId] = INVALID_DEVICE_ID;
+    nextInSlot[deviceId] = head;
+    if (head != INVALID_DEVICE_ID) {
+        prevInSlot[head] = deviceId;
+    }
+    wheel[slot] = deviceId;
+}
+
+void HeartbeatMonitor::Unlink(DeviceId deviceId) {
+    int32_t slot = slotOf[deviceId];
+    if (slot == NO_SLOT) return;
+
+    DeviceId prev = prevInSlot[deviceId];
+    DeviceId next = nextInSlot[deviceId];
+    if (prev != INVALID_DEVICE_ID) {
+        nextInSlot[prev] = next;
+    } else {
+        wheel[slot] = next;
+    }
+    if (next != INVALID_DEVICE_ID) {
+        prevInSlot[next] = prev;
+    }
+
+    slotOf[deviceId] = NO_SLOT;
+    prevInSlot[deviceId] = INVALID_DEVICE_ID;
+    nextInSlot[deviceId] = INVALID_DEVICE_ID;
+}
+
+void HeartbeatMonitor::Arm(DeviceId deviceId, ConnectionType type, int64_t nowMs, int64_t minCadenceMs) {
+    HeartbeatProbeCallback probe = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        EnsureDevice(deviceId);
+        Unlink(deviceId);
+
+        const HeartbeatPolicy& policy = policies[static_cast<int>(type)];
+        int64_t cadence = std::max<int64_t>(policy.cadenceMs, minCadenceMs);
+        cadenceMs[deviceId] = cadence;
+        missLimit[deviceId] = policy.missLimit > 0 ? policy.missLimit : 1;
+        missed[deviceId] = 0;
+        reported[deviceId] = 0;
+        states[deviceId] = LinkState::UNKNOWN;
+
+        if (lastTickMs == 0) lastTickMs = nowMs;
+        Link(deviceId, nowMs + cadence);
+        probe = probeCallback;
+    }
+
+    if (probe) {
+        probe(deviceId);
+    }
+}
+
+void HeartbeatMonitor::Disarm(DeviceId deviceId) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (deviceId >= states.size()) return;
+
+    Unlink(deviceId);
+    states[deviceId] = LinkState::UNKNOWN;
+    missed[deviceId] = 0;
+    reported[deviceId] = 0;
+}
+
+void HeartbeatMonitor::DisarmAll() {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    deadlineMs.clear();
+    cadenceMs.clear();
+    missLimit.clear();
+    missed.clear();
+    reported.clear();
+    states.clear();
+    slotOf.clear();
+    nextInSlot.clear();
+    prevInSlot.clear();
+
+    for (int i = 0; i < WHEEL_SLOTS; i++) {
+        wheel[i] = INVALID_DEVICE_ID;
+    }
+    lastTickMs = 0;
+}
+
+bool HeartbeatMonitor::IsArmed(DeviceId deviceId) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return deviceId < slotOf.size() && slotOf[deviceId] != NO_SLOT;
+}
+
+// CALLED FROM THE HID THREAD; ONLY FLAGS THE CURRENT PERIOD, THE WHEEL IS LEFT ALONE
+void HeartbeatMonitor::OnReport(DeviceId deviceId, int64_t nowMs) {
+    (void)nowMs;
+    LinkStateCallback callback = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (deviceId >= slotOf.size() || slotOf[deviceId] == NO_SLOT) return;
+
+        reported[deviceId] = 1;
+        missed[deviceId] = 0;
+        if (states[deviceId] == LinkState::ONLINE) return;
+
+        if (states[deviceId] == LinkState::OFFLINE) reconnects[deviceId]++;
+        states[deviceId] = LinkState::ONLINE;
+        callback = stateCallback;
+    }
+
+    if (callback) {
+        callback(deviceId, LinkState::ONLINE);
+    }
+}
+
+void HeartbeatMonitor::Tick(int64_t nowMs) {
+    std::vector<DeviceId> probes;
+    std::vector<std::pair<DeviceId, LinkState>> changes;
+    HeartbeatProbeCallback probe = nullptr;
+    LinkStateCallback callback = nullptr;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (lastTickMs == 0) lastTickMs = nowMs;
+
+        int64_t fromTick = lastTickMs / tickMs;
+        int64_t toTick = nowMs / tickMs;
+        int64_t slotsToScan = toTick - fromTick + 1;
+        if (slotsToScan > WHEEL_SLOTS) slotsToScan = WHEEL_SLOTS;
+        lastTickMs = nowMs;
+
+        std::vector<DeviceId> expired;
+        for (int64_t t = 0; t < slotsToScan; t++) {
+            int slot = static_cast<int>((fromTick + t) % WHEEL_SLOTS);
+            for (DeviceId id = wheel[slot]; id != INVALID_DEVICE_ID; id = nextInSlot[id]) {
+                if (deadlineMs[id] <= nowMs) {
+                    expired.push_back(id);
+                }
+            }
+        }
+
+        for (DeviceId id : expired) {
+            int64_t deadline = deadlineMs[id];
+            Unlink(id);
+
+            LinkState previous = states[id];
+            if (reported[id]) {
+                missed[id] = 0;
+            } else {
+                missed[id]++;
+                if (missed[id] >= missLimit[id]) {
+                    states[id] = LinkState::OFFLINE;
+                } else if (previous == LinkState::ONLINE) {
+                    states[id] = LinkState::SUSPECT;
+                }
+            }
+            reported[id] = 0;
+
+            if (states[id] != previous) {
+                changes.push_back(std::make_pair(id, states[id]));
+            }
+
+            int64_t next = deadline + cadenceMs[id];
+            if (next <= nowMs) next = nowMs + cadenceMs[id];
+            Link(id, next);
+            probes.push_back(id);
+        }
+
+        probe = probeCallback;
+        callback = stateCallback;
+    }
+
+    if (callback) {
+        for (const auto& change : changes) {
+            callback(change.first, change.second);
+        }
+    }
+    if (probe) {
+        for (DeviceId id : probes) {
+            probe(id);
+        }
+    }
+}
+
+LinkState HeartbeatMonitor::GetState(DeviceId deviceId) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (deviceId >= states.size()) return LinkState::UNKNOWN;
+    return states[deviceId];
+}
+
+uint32_t HeartbeatMonitor::GetReconnectCount(DeviceId deviceId) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (deviceId >= reconnects.size()) return 0;
+    return reconnects[deviceId];
+}
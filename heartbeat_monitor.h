@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <mutex>
+#include "device_registry.h"
+
+enum class LinkState : uint8_t {
+    UNKNOWN,
+    ONLINE,
+    SUSPECT,
+    OFFLINE
+};
+
+struct HeartbeatPolicy {
+    int64_t cadenceMs;
+    uint32_t missLimit;
+};
+
+typedef void(*LinkStateCallback)(DeviceId deviceId, LinkState newState);
+typedef void(*HeartbeatProbeCallback)(DeviceId deviceId);
+
+class HeartbeatMonitor {
+private:
+    static const int WHEEL_SLOTS = 64;
+
+    mutable std::mutex mutex;
+    int64_t tickMs;
+    int64_t lastTickMs;
+    HeartbeatPolicy policies[4];
+
+    DeviceId wheel[WHEEL_SLOTS];
+
+    std::vector<int64_t> deadlineMs;
+    std::vector<int64_t> cadenceMs;
+    std::vector<uint32_t> missLimit;
+    std::vector<uint32_t> missed;
+    std::vector<uint8_t> reported;
+    std::vector<LinkState> states;
+    std::vector<uint32_t> reconnects;
+    std::vector<int32_t> slotOf;
+    std::vector<DeviceId> nextInSlot;
+    std::vector<DeviceId> prevInSlot;
+
+    LinkStateCallback stateCallback;
+    HeartbeatProbeCallback probeCallback;
+
+    void EnsureDevice(DeviceId deviceId);
+    int SlotFor(int64_t deadline) const;
+    void Link(DeviceId deviceId, int64_t deadline);
+    void Unlink(DeviceId deviceId);
+
+public:
+    HeartbeatMonitor();
+
+    void LoadSettings(const std::string& configPath);
+    void SetPolicy(ConnectionType type, const HeartbeatPolicy& policy);
+    HeartbeatPolicy GetPolicy(ConnectionType type) const;
+    int64_t GetTickMs() const { std::lock_guard<std::mutex> lock(mutex); return tickMs; }
+
+    void SetStateCallback(LinkStateCallback callback) { stateCallback = callback; }
+    void SetProbeCallback(HeartbeatProbeCallback callback) { probeCallback = callback; }
+
+    // minCadenceMs: THE FASTEST THE DEVICE'S MODEL ANSWERS; A FASTER POLICY CADENCE IS SLOWED TO IT
+    void Arm(DeviceId deviceId, ConnectionType type, int64_t nowMs, int64_t minCadenceMs = 0);
+    void Disarm(DeviceId deviceId);
+    void DisarmAll();
+    bool IsArmed(DeviceId deviceId) const;
+
+    void OnReport(DeviceId deviceId, int64_t nowMs);
+    void Tick(int64_t nowMs);
+
+    LinkState GetState(DeviceId deviceId) const;
+    // OFFLINE -> ONLINE TRANSITIONS SINCE THE DEVICE WAS FIRST ARMED
+    uint32_t GetReconnectCount(DeviceId deviceId) const;
+};
@@ -0,0 +1,694 @@
+#include "net_socket.h"
+#include "http_server.h"
+#include "metrics_exporter.h"
+#include "trace_events.h"
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <cctype>
+#include <sys/stat.h>
+
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
+
+static const size_t MAX_CLIENTS = 64;
+static const size_t MAX_REQUEST_HEAD = 8192;
+static const size_t MAX_EVENT_BACKLOG = 256 * 1024;
+static const size_t FILE_CHUNK = 16 * 1024;
+static const int64_t KEEPALIVE_INTERVAL_MS = 15000;
+
+// FILE BODIES GO STRAIGHT FROM THE PAGE CACHE TO THE SOCKET WHERE THE OS ALLOWS IT
+struct FileBody {
+#ifdef __linux__
+    int fd;
+    off_t offset;
+#else
+    FILE* file;
+#endif
+    uint64_t remaining;
+};
+
+struct HttpClient {
+    SocketHandle socket;
+    std::string input;
+    std::string output;
+    size_t outputOffset;
+    FileBody body;
+    bool isEventStream;
+    bool closeAfterWrite;
+};
+
+static void ResetBody(FileBody& body) {
+#ifdef __linux__
+    body.fd = -1;
+    body.offset = 0;
+#else
+    body.file = nullptr;
+#endif
+    body.remaining = 0;
+}
+
+static void CloseBody(FileBody& body) {
+#ifdef __linux__
+    if (body.fd >= 0) close(body.fd);
+    body.fd = -1;
+#else
+    if (body.file) fclose(body.file);
+    body.file = nullptr;
+#endif
+    body.remaining = 0;
+}
+
+static bool OpenRegularFile(const std::string& path, FileBody& body) {
+#ifdef __linux__
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+        close(fd);
+        return false;
+    }
+
+    body.fd = fd;
+    body.offset = 0;
+    body.remaining = static_cast<uint64_t>(info.st_size);
+#elif defined(_WIN32)
+    FILE* file = nullptr;
+    if (fopen_s(&file, path.c_str(), "rb") != 0 || !file) return false;
+
+    struct _stat64 info;
+    if (_fstat64(_fileno(file), &info) != 0 || !(info.st_mode & _S_IFREG)) {
+        fclose(file);
+        return false;
+    }
+
+    body.file = file;
+    body.remaining = static_cast<uint64_t>(info.st_size);
+#else
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) return false;
+
+    struct stat info;
+    if (fstat(fileno(file), &info) != 0 || !S_ISREG(info.st_mode)) {
+        fclose(file);
+        return false;
+    }
+
+    body.file = file;
+    body.remaining = static_cast<uint64_t>(info.st_size);
+#endif
+    return true;
+}
+
+static const char* ContentTypeFor(const std::string& path) {
+    size_t dot = path.find_last_of('.');
+    if (dot == std::string::npos) return "application/octet-stream";
+
+    std::string ext = path.substr(dot + 1);
+    if (ext == "html") return "text/html; charset=utf-8";
+    if (ext == "js") return "text/javascript; charset=utf-8";
+    if (ext == "css") return "text/css; charset=utf-8";
+    if (ext == "json") return "application/json";
+    if (ext == "txt") return "text/plain; charset=utf-8";
+    if (ext == "svg") return "image/svg+xml";
+    if (ext == "png") return "image/png";
+    if (ext == "ico") return "image/x-icon";
+    if (ext == "woff2") return "font/woff2";
+    if (ext == "woff") return "font/woff";
+    return "application/octet-stream";
+}
+
+static int HexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// DECODES THE URL PATH AND REFUSES ANYTHING THAT COULD ESCAPE THE DOCUMENT ROOT
+static bool DecodePath(const std::string& target, std::string& path) {
+    path.clear();
+    for (size_t i = 0; i < target.size(); i++) {
+        char c = target[i];
+        if (c == '%') {
+            if (i + 2 >= target.size()) return false;
+            int high = HexValue(target[i + 1]);
+            int low = HexValue(target[i + 2]);
+            if (high < 0 || low < 0) return false;
+            c = static_cast<char>(high * 16 + low);
+            i += 2;
+        }
+        if (c == '\0' || c == '\\' || c == ':') return false;
+        path.push_back(c);
+    }
+
+    if (path.empty() || path[0] != '/') return false;
+    return path.find("/..") == std::string::npos && path.find("//") == std::string::npos;
+}
+
+static std::string LowerCase(std::string value) {
+    for (auto& c : value) c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+    return value;
+}
+
+// REJECTING FOREIGN HOST HEADERS KEEPS DNS-REBOUND PAGES FROM READING THE LOOPBACK SERVER
+static bool IsLoopbackHost(const std::string& host) {
+    std::string name = LowerCase(host);
+    if (!name.empty() && name[0] == '[') {
+        return name.compare(0, 5, "[::1]") == 0;
+    }
+
+    size_t colon = name.find(':');
+    if (colon != std::string::npos) name.erase(colon);
+    return name == "localhost" || name == "127.0.0.1";
+}
+
+struct HttpServer::Impl {
+    std::mutex mutex;
+    StatusSnapshot snapshot;
+    uint32_t sequence;
+    std::string pendingEvents;
+
+    std::string documentRoot;
+    std::atomic<bool> running;
+    std::atomic<int> port;
+    SocketHandle listenSocket;
+    SocketHandle wakeSocket;
+    std::thread thread;
+
+    std::atomic<MetricsExporter*> metrics;
+
+    std::vector<HttpClient> clients;
+    std::atomic<size_t> clientCount;
+
+    Impl() : sequence(0), running(false), port(0), listenSocket(NO_SOCKET), wakeSocket(NO_SOCKET), metrics(nullptr), clientCount(0) {}
+
+    void Loop();
+    void Wake();
+
+    bool ServeClient(HttpClient& client);
+    bool Flush(HttpClient& client);
+    int HandleNextRequest(HttpClient& client);
+    void HandleRequest(HttpClient& client, const std::string& method, const std::string& path, bool keepAlive);
+    void ServeFile(HttpClient& client, const std::string& path, bool headOnly, bool keepAlive);
+    void AppendHead(HttpClient& client, int status, const char* reason, const char* contentType, uint64_t length, bool keepAlive);
+    void AppendError(HttpClient& client, int status, const char* reason);
+};
+
+void HttpServer::Impl::Wake() {
+    char wake = 1;
+    send(wakeSocket, &wake, 1, 0);
+}
+
+void HttpServer::Impl::AppendHead(HttpClient& client, int status, const char* reason, const char* contentType, uint64_t length, bool keepAlive) {
+    char head[320];
+    snprintf(head, sizeof(head),
+             "HTTP/1.1 %d %s\r\n"
+             "Content-Type: %s\r\n"
+             "Content-Length: %llu\r\n"
+             "Cache-Control: no-cache\r\n"
+             "X-Content-Type-Options: nosniff\r\n"
+             "Connection: %s\r\n\r\n",
+             status, reason, contentType, static_cast<unsigned long long>(length),
+             keepAlive ? "keep-alive" : "close");
+    client.output += head;
+    if (!keepAlive) client.closeAfterWrite = true;
+}
+
+void HttpServer::Impl::AppendError(HttpClient& client, int status, const char* reason) {
+    std::string body = std::to_string(status) + " " + reason + "\n";
+    AppendHead(client, status, reason, "text/plain; charset=utf-8", body.size(), false);
+    client.output += body;
+}
+
+void HttpServer::Impl::ServeFile(HttpClient& client, const std::string& path, bool headOnly, bool keepAlive) {
+    std::string relative = path;
+    if (relative.back() == '/') relative += "index.html";
+
+    const std::string candidates[] = { relative, relative + ".html", relative + "/index.html" };
+
+    FileBody body;
+    ResetBody(body);
+    std::string resolved;
+    for (const auto& candidate : candidates) {
+        if (OpenRegularFile(documentRoot + candidate, body)) {
+            resolved = candidate;
+            break;
+        }
+    }
+
+    int status = 200;
+    const char* reason = "OK";
+    if (resolved.empty()) {
+        if (!OpenRegularFile(documentRoot + "/404.html", body)) {
+            AppendError(client, 404, "Not Found");
+            return;
+        }
+        resolved = "/404.html";
+        status = 404;
+        reason = "Not Found";
+    }
+
+    AppendHead(client, status, reason, ContentTypeFor(resolved), body.remaining, keepAlive);
+    if (headOnly) {
+        CloseBody(body);
+        return;
+    }
+    client.body = body;
+}
+
+void HttpServer::Impl::HandleRequest(HttpClient& client, const std::string& method, const std::string& path, bool keepAlive) {
+    bool headOnly = (method == "HEAD");
+
+    if (path == "/events") {
+        if (headOnly) {
+            AppendError(client, 405, "Method Not Allowed");
+            return;
+        }
+
+        client.isEventStream = true;
+        client.output += "HTTP/1.1 200 OK\r\n"
+                         "Content-Type: text/event-stream\r\n"
+                         "Cache-Control: no-cache\r\n"
+                         "Connection: keep-alive\r\n\r\n"
+                         "retry: 2000\n\n";
+
+        std::lock_guard<std::mutex> lock(mutex);
+        client.output += "event: snapshot\nid: " + std::to_string(sequence) + "\ndata: ";
+        StatusProtocol::AppendJson(client.output, "snapshot", sequence, snapshot, SteadyNowMs());
+        client.output += "\n";
+        return;
+    }
+
+    if (path == "/status") {
+        std::string body;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            StatusProtocol::AppendJson(body, "status", sequence, snapshot, SteadyNowMs());
+        }
+        AppendHead(client, 200, "OK", "application/json", body.size(), keepAlive);
+        if (!headOnly) client.output += body;
+        return;
+    }
+
+    MetricsExporter* exporter = metrics;
+    if (path == "/metrics" && exporter) {
+        exporter->Read([&](const std::string& text) {
+            AppendHead(client, 200, "OK", MetricsExporter::ContentType(), text.size(), keepAlive);
+            if (!headOnly) client.output += text;
+        });
+        return;
+    }
+
+    ServeFile(client, path, headOnly, keepAlive);
+}
+
+// RETURNS 1 WHEN A REQUEST WAS QUEUED, 0 WHEN MORE INPUT IS NEEDED, -1 TO DROP THE CONNECTION
+int HttpServer::Impl::HandleNextRequest(HttpClient& client) {
+    size_t headEnd = client.input.find("\r\n\r\n");
+    if (headEnd == std::string::npos) {
+        if (client.input.size() > MAX_REQUEST_HEAD) {
+            AppendError(client, 431, "Request Header Fields Too Large");
+            return 1;
+        }
+        return 0;
+    }
+
+    std::string head = client.input.substr(0, headEnd);
+    client.input.erase(0, headEnd + 4);
+
+    size_t lineEnd = head.find("\r\n");
+    std::string requestLine = head.substr(0, lineEnd);
+
+    size_t firstSpace = requestLine.find(' ');
+    size_t secondSpace = requestLine.find(' ', firstSpace + 1);
+    if (firstSpace == std::string::npos || secondSpace == std::string::npos) {
+        AppendError(client, 400, "Bad Request");
+        return 1;
+    }
+
+    std::string method = requestLine.substr(0, firstSpace);
+    std::string target = requestLine.substr(firstSpace + 1, secondSpace - firstSpace - 1);
+    std::string version = requestLine.substr(secondSpace + 1);
+
+    std::string host;
+    std::string connection;
+    bool hasBody = false;
+    size_t lineStart = (lineEnd == std::string::npos) ? head.size() : lineEnd + 2;
+    while (lineStart < head.size()) {
+        size_t next = head.find("\r\n", lineStart);
+        if (next == std::string::npos) next = head.size();
+
+        std::string line = head.substr(lineStart, next - lineStart);
+        size_t colon = line.find(':');
+        if (colon != std::string::npos) {
+            std::string name = LowerCase(line.substr(0, colon));
+            size_t valueStart = line.find_first_not_of(" \t", colon + 1);
+            std::string value = (valueStart == std::string::npos) ? "" : line.substr(valueStart);
+
+            if (name == "host") host = value;
+            else if (name == "connection") connection = LowerCase(value);
+            else if (name == "content-length" || name == "transfer-encoding") hasBody = (value != "0");
+        }
+        lineStart = next + 2;
+    }
+
+    if (version != "HTTP/1.1" && version != "HTTP/1.0") {
+        AppendError(client, 505, "HTTP Version Not Supported");
+        return 1;
+    }
+    if (!host.empty() ? !IsLoopbackHost(host) : version == "HTTP/1.1") {
+        AppendError(client, 403, "Forbidden");
+        return 1;
+    }
+    if (method != "GET" && method != "HEAD") {
+        AppendError(client, 405, "Method Not Allowed");
+        return 1;
+    }
+
+    bool keepAlive = !hasBody && ((version == "HTTP/1.1") ? connection != "close" : connection == "keep-alive");
+
+    size_t query = target.find_first_of("?#");
+    if (query != std::string::npos) target.erase(query);
+
+    std::string path;
+    if (!DecodePath(target, path)) {
+        AppendError(client, 400, "Bad Request");
+        return 1;
+    }
+
+    HandleRequest(client, method, path, keepAlive);
+    return 1;
+}
+
+bool HttpServer::Impl::Flush(HttpClient& client) {
+    while (true) {
+        if (client.outputOffset < client.output.size()) {
+            int length = static_cast<int>(client.output.size() - client.outputOffset);
+            int sent = static_cast<int>(send(client.socket, client.output.data() + client.outputOffset, length, SEND_FLAGS));
+            if (sent < 0) return WouldBlock();
+            client.outputOffset += static_cast<size_t>(sent);
+            continue;
+        }
+
+        client.output.clear();
+        client.outputOffset = 0;
+
+        if (client.body.remaining == 0) {
+            CloseBody(client.body);
+            return true;
+        }
+
+#ifdef __linux__
+        size_t chunk = client.body.remaining > (1u << 20) ? (1u << 20) : static_cast<size_t>(client.body.remaining);
+        ssize_t sent = sendfile(client.socket, client.body.fd, &client.body.offset, chunk);
+        if (sent < 0) return WouldBlock();
+        if (sent == 0) return false;
+        client.body.remaining -= static_cast<uint64_t>(sent);
+#else
+        size_t chunk = client.body.remaining > FILE_CHUNK ? FILE_CHUNK : static_cast<size_t>(client.body.remaining);
+        client.output.resize(chunk);
+        size_t bytesRead = fread(&client.output[0], 1, chunk, client.body.file);
+        if (bytesRead == 0) return false;
+        client.output.resize(bytesRead);
+        client.body.remaining -= bytesRead;
+#endif
+    }
+}
+
+bool HttpServer::Impl::ServeClient(HttpClient& client) {
+    while (true) {
+        if (!Flush(client)) return false;
+
+        bool idle = client.output.empty() && client.body.remaining == 0;
+        if (!idle) return !client.isEventStream || client.output.size() <= MAX_EVENT_BACKLOG;
+        if (client.closeAfterWrite) return false;
+        if (client.isEventStream) return true;
+
+        int result = HandleNextRequest(client);
+        if (result <= 0) return result == 0;
+    }
+}
+
+void HttpServer::Impl::Loop() {
+    TRACE_THREAD_NAME("http-server");
+
+    std::vector<pollfd> pollFds;
+    char buffer[4096];
+    int64_t lastKeepaliveMs = SteadyNowMs();
+
+    while (running) {
+        pollFds.clear();
+        pollFds.push_back({ wakeSocket, POLLIN, 0 });
+        pollFds.push_back({ listenSocket, POLLIN, 0 });
+        for (const auto& client : clients) {
+            short events = POLLIN;
+            if (!client.output.empty() || client.body.remaining > 0) events |= POLLOUT;
+            pollFds.push_back({ client.socket, events, 0 });
+        }
+
+        int64_t untilKeepalive = KEEPALIVE_INTERVAL_MS - (SteadyNowMs() - lastKeepaliveMs);
+        if (untilKeepalive < 0) untilKeepalive = 0;
+        if (PollSockets(pollFds.data(), pollFds.size(), static_cast<int>(untilKeepalive)) < 0) {
+            if (WouldBlock()) continue;
+            break;
+        }
+
+        if (pollFds[0].revents & POLLIN) {
+            while (recv(wakeSocket, buffer, sizeof(buffer), 0) > 0) {}
+        }
+        if (!running) break;
+
+        std::string events;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            events.swap(pendingEvents);
+        }
+
+        int64_t now = SteadyNowMs();
+        if (now - lastKeepaliveMs >= KEEPALIVE_INTERVAL_MS) {
+            events += ": keepalive\n\n";
+            lastKeepaliveMs = now;
+        }
+
+        std::vector<bool> closed(clients.size(), false);
+
+        for (size_t i = 0; i < clients.size(); i++) {
+            HttpClient& client = clients[i];
+            short revents = pollFds[i + 2].revents;
+
+            if (client.isEventStream && !events.empty()) {
+                client.output += events;
+            }
+
+            if (revents & (POLLIN | POLLHUP | POLLERR)) {
+                while (true) {
+                    int bytesRead = static_cast<int>(recv(client.socket, buffer, sizeof(buffer), 0));
+                    if (bytesRead > 0) {
+                        // EVENT STREAMS NEVER SEND ANOTHER REQUEST; DON'T LET THEM BUFFER ONE
+                        if (!client.isEventStream) client.input.append(buffer, bytesRead);
+                        if (client.input.size() > MAX_REQUEST_HEAD * 2) break;
+                        continue;
+                    }
+                    if (bytesRead < 0 && WouldBlock()) break;
+                    closed[i] = true;
+                    break;
+                }
+            }
+
+            if (!closed[i] && !ServeClient(client)) {
+                closed[i] = true;
+            }
+        }
+
+        for (size_t i = clients.size(); i-- > 0;) {
+            if (closed[i]) {
+                CloseBody(clients[i].body);
+                CloseSocket(clients[i].socket);
+                clients.erase(clients.begin() + i);
+            }
+        }
+
+        if (pollFds[1].revents & POLLIN) {
+            while (true) {
+                SocketHandle socket = accept(listenSocket, NULL, NULL);
+                if (socket == NO_SOCKET) break;
+
+                if (clients.size() >= MAX_CLIENTS) {
+                    CloseSocket(socket);
+                    continue;
+                }
+
+                SetNonBlocking(socket);
+                int noDelay = 1;
+                setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&noDelay), sizeof(noDelay));
+
+                HttpClient client;
+                client.socket = socket;
+                client.outputOffset = 0;
+                client.isEventStream = false;
+                client.closeAfterWrite = false;
+                ResetBody(client.body);
+                clients.push_back(client);
+            }
+        }
+
+        clientCount = clients.size();
+    }
+
+    for (auto& client : clients) {
+        CloseBody(client.body);
+        CloseSocket(client.socket);
+    }
+    clients.clear();
+    clientCount = 0;
+}
+
+HttpServer::HttpServer() : impl(new Impl()) {}
+
+HttpServer::~HttpServer() {
+    Stop();
+}
+
+bool HttpServer::Start(int port, const std::string& documentRoot) {
+    if (impl->running) return true;
+
+    if (!InitSockets()) {
+        return false;
+    }
+
+    impl->documentRoot = documentRoot;
+    while (!impl->documentRoot.empty() && (impl->documentRoot.back() == '/' || impl->documentRoot.back() == '\\')) {
+        impl->documentRoot.pop_back();
+    }
+
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(static_cast<uint16_t>(port));
+
+    SocketHandle listener = socket(AF_INET, SOCK_STREAM, 0);
+    SocketHandle waker = socket(AF_INET, SOCK_DGRAM, 0);
+
+    sockaddr_in wakeAddress = {};
+    wakeAddress.sin_family = AF_INET;
+    wakeAddress.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addressLength = sizeof(wakeAddress);
+
+    // A UDP SOCKET CONNECTED TO ITSELF WAKES THE POLL LOOP THE SAME WAY ON EVERY PLATFORM
+    bool ok = listener != NO_SOCKET && waker != NO_SOCKET &&
+              bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0 &&
+              listen(listener, 16) == 0 &&
+              bind(waker, reinterpret_cast<sockaddr*>(&wakeAddress), sizeof(wakeAddress)) == 0 &&
+              getsockname(waker, reinterpret_cast<sockaddr*>(&wakeAddress), &addressLength) == 0 &&
+              connect(waker, reinterpret_cast<sockaddr*>(&wakeAddress), sizeof(wakeAddress)) == 0;
+
+    if (ok) {
+        addressLength = sizeof(address);
+        ok = getsockname(listener, reinterpret_cast<sockaddr*>(&address), &addressLength) == 0;
+    }
+
+    if (!ok) {
+        if (listener != NO_SOCKET) CloseSocket(listener);
+        if (waker != NO_SOCKET) CloseSocket(waker);
+        CleanupSockets();
+        return false;
+    }
+
+    SetNonBlocking(listener);
+    SetNonBlocking(waker);
+
+    impl->listenSocket = listener;
+    impl->wakeSocket = waker;
+    impl->port = ntohs(address.sin_port);
+    impl->running = true;
+    impl->thread = std::thread(&HttpServer::Impl::Loop, impl.get());
+    return true;
+}
+
+void HttpServer::Stop() {
+    if (!impl->running.exchange(false)) return;
+
+    impl->Wake();
+    if (impl->thread.joinable()) {
+        impl->thread.join();
+    }
+
+    CloseSocket(impl->listenSocket);
+    CloseSocket(impl->wakeSocket);
+    impl->listenSocket = NO_SOCKET;
+    impl->wakeSocket = NO_SOCKET;
+    impl->port = 0;
+
+    CleanupSockets();
+}
+
+bool HttpServer::IsRunning() const {
+    return impl->running;
+}
+
+int HttpServer::GetPort() const {
+    return impl->port;
+}
+
+void HttpServer::Publish(const StatusSnapshot& snapshot) {
+    {
+        std::lock_guard<std::mutex> lock(impl->mutex);
+
+        const StatusSnapshot& previous = impl->snapshot;
+        if (StatusProtocol::SameState(snapshot, previous)) {
+            impl->snapshot = snapshot;
+            return;
+        }
+
+        impl->sequence++;
+        std::string id = std::to_string(impl->sequence);
+        int64_t now = SteadyNowMs();
+
+        bool sameDevices = (snapshot.size() == previous.size());
+        for (size_t i = 0; sameDevices && i < snapshot.size(); i++) {
+            sameDevices = (snapshot[i].id == previous[i].id);
+        }
+
+        std::string& events = impl->pendingEvents;
+        if (!sameDevices) {
+            events += "event: snapshot\nid: " + id + "\ndata: ";
+            StatusProtocol::AppendJson(events, "snapshot", impl->sequence, snapshot, now);
+            events += "\n";
+        } else {
+            for (size_t i = 0; i < snapshot.size(); i++) {
+                if (StatusProtocol::SameDevice(snapshot[i], previous[i])) continue;
+
+                events += "event: device\nid: " + id + "\ndata: ";
+                StatusProtocol::AppendJsonDevice(events, snapshot[i], now);
+                events += "\n\n";
+            }
+        }
+
+        // A STALLED LOOP MUST NOT GROW THIS WITHOUT BOUND; CLIENTS RESYNC FROM THE NEXT SNAPSHOT
+        if (events.size() > MAX_EVENT_BACKLOG) {
+            events = "event: snapshot\nid: " + id + "\ndata: ";
+            StatusProtocol::AppendJson(events, "snapshot", impl->sequence, snapshot, now);
+            events += "\n";
+        }
+
+        impl->snapshot = snapshot;
+    }
+
+    if (impl->running) {
+        impl->Wake();
+    }
+}
+
+void HttpServer::SetMetricsExporter(MetricsExporter* exporter) {
+    impl->metrics = exporter;
+}
+
+size_t HttpServer::GetClientCount() const {
+    return impl->clientCount;
+}
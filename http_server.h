@@ -0,0 +1,32 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include "status_protocol.h"
+
+class MetricsExporter;
+
+// LOOPBACK-ONLY HTTP/1.1 SERVER FOR THE docs/ DASHBOARD. ONE POLL LOOP SERVES STATIC FILES,
+// /status (JSON SNAPSHOT), /events (SERVER-SENT EVENTS, ONE "device" EVENT PER CHANGED MOUSE)
+// AND /metrics (PROMETHEUS TEXT, WHEN AN EXPORTER IS ATTACHED)
+class HttpServer {
+public:
+    HttpServer();
+    ~HttpServer();
+
+    bool Start(int port, const std::string& documentRoot);
+    void Stop();
+    bool IsRunning() const;
+    int GetPort() const;
+
+    void Publish(const StatusSnapshot& snapshot);
+    void SetMetricsExporter(MetricsExporter* exporter);
+    size_t GetClientCount() const;
+
+private:
+    HttpServer(const HttpServer&);
+    HttpServer& operator=(const HttpServer&);
+
+    struct Impl;
+    std::unique_ptr<Impl> impl;
+};
@@ -0,0 +1,109 @@
+#include "lan_status.h"
+#include <cstring>
+
+namespace {
+
+void PutU16(unsigned char* p, uint16_t value) {
+    p[0] = static_cast<unsigned char>(value & 0xFF);
+    p[1] = static_cast<unsigned char>(value >> 8);
+}
+
+void PutU32(unsigned char* p, uint32_t value) {
+    for (int i = 0; i < 4; i++) p[i] = static_cast<unsigned char>(value >> (8 * i));
+}
+
+void PutU64(unsigned char* p, uint64_t value) {
+    for (int i = 0; i < 8; i++) p[i] = static_cast<unsigned char>(value >> (8 * i));
+}
+
+uint16_t GetU16(const unsigned char* p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+uint32_t GetU32(const unsigned char* p) {
+    uint32_t value = 0;
+    for (int i = 3; i >= 0; i--) value = (value << 8) | p[i];
+    return value;
+}
+
+uint64_t GetU64(const unsigned char* p) {
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; i--) value = (value << 8) | p[i];
+    return value;
+}
+
+}
+
+size_t LanStatus::Encode(char* buffer, size_t capacity, DatagramType type, uint64_t senderId, uint32_t sequence,
+                         const std::string& host, const StatusSnapshot& snapshot) {
+    size_t hostLength = host.size() > MAX_HOST_LENGTH ? MAX_HOST_LENGTH : host.size();
+    size_t count = snapshot.size() > MAX_DEVICES ? MAX_DEVICES : snapshot.size();
+    size_t total = HEADER_SIZE + hostLength + count * RECORD_SIZE;
+    if (total > capacity) return 0;
+
+    unsigned char* p = reinterpret_cast<unsigned char*>(buffer);
+    p[0] = MAGIC_0;
+    p[1] = MAGIC_1;
+    p[2] = VERSION;
+    p[3] = type;
+    PutU64(p + 4, senderId);
+    PutU32(p + 12, sequence);
+    PutU16(p + 16, static_cast<uint16_t>(count));
+    p[18] = static_cast<unsigned char>(hostLength);
+    memcpy(p + HEADER_SIZE, host.data(), hostLength);
+
+    unsigned char* record = p + HEADER_SIZE + hostLength;
+    for (size_t i = 0; i < count; i++, record += RECORD_SIZE) {
+        const DeviceStatus& status = snapshot[i];
+
+        uint8_t flags = 0;
+        if (status.isOnline) flags |= StatusProtocol::RECORD_ONLINE;
+        if (status.isCharging) flags |= StatusProtocol::RECORD_CHARGING;
+        if (status.isMonitored) flags |= StatusProtocol::RECORD_MONITORED;
+
+        PutU32(record, status.id);
+        record[4] = status.level;
+        record[5] = flags;
+        record[6] = static_cast<uint8_t>(status.connectionType);
+        record[7] = static_cast<uint8_t>(status.linkState);
+        PutU16(record + 8, status.voltage);
+    }
+
+    return total;
+}
+
+bool LanStatus::Decode(const char* data, size_t length, Datagram& datagram) {
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+    if (length < HEADER_SIZE || p[0] != MAGIC_0 || p[1] != MAGIC_1 || p[2] != VERSION) return false;
+    if (p[3] != DATAGRAM_CHANGE && p[3] != DATAGRAM_HEARTBEAT) return false;
+
+    size_t count = GetU16(p + 16);
+    size_t hostLength = p[18];
+    if (hostLength > MAX_HOST_LENGTH || length != HEADER_SIZE + hostLength + count * RECORD_SIZE) return false;
+
+    datagram.type = static_cast<DatagramType>(p[3]);
+    datagram.senderId = GetU64(p + 4);
+    datagram.sequence = GetU32(p + 12);
+    datagram.host.assign(data + HEADER_SIZE, hostLength);
+
+    datagram.devices.resize(count);
+    const unsigned char* record = p + HEADER_SIZE + hostLength;
+    for (size_t i = 0; i < count; i++, record += RECORD_SIZE) {
+        DeviceStatus& status = datagram.devices[i];
+        uint8_t connection = record[6];
+        uint8_t link = record[7];
+
+        status.id = GetU32(record);
+        status.name.clear();
+        status.level = record[4];
+        status.isOnline = (record[5] & StatusProtocol::RECORD_ONLINE) != 0;
+        status.isCharging = (record[5] & StatusProtocol::RECORD_CHARGING) != 0;
+        status.isMonitored = (record[5] & StatusProtocol::RECORD_MONITORED) != 0;
+        status.connectionType = connection <= static_cast<uint8_t>(ConnectionType::UNKNOWN) ? static_cast<ConnectionType>(connection) : ConnectionType::UNKNOWN;
+        status.linkState = link <= static_cast<uint8_t>(LinkState::OFFLINE) ? static_cast<LinkState>(link) : LinkState::UNKNOWN;
+        status.voltage = GetU16(record + 8);
+        status.lastUpdateMs = 0;
+    }
+
+    return true;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include "status_protocol.h"
+
+// LAN DATAGRAM: 'M' 'B' VERSION TYPE, U64 SENDER, U32 SEQUENCE, U16 COUNT, U8 HOST LENGTH + HOST,
+// THEN 10 BYTES PER DEVICE (U32 ID, U8 LEVEL, U8 FLAGS, U8 CONNECTION, U8 LINK, U16 VOLTAGE). LITTLE ENDIAN
+namespace LanStatus {
+    const uint8_t MAGIC_0 = 'M';
+    const uint8_t MAGIC_1 = 'B';
+    const uint8_t VERSION = 1;
+
+    const size_t HEADER_SIZE = 19;
+    const size_t RECORD_SIZE = 10;
+    const size_t MAX_HOST_LENGTH = 32;
+    const size_t MAX_DATAGRAM = 1200;
+    const size_t MAX_DEVICES = (MAX_DATAGRAM - HEADER_SIZE - MAX_HOST_LENGTH) / RECORD_SIZE;
+
+    enum DatagramType : uint8_t {
+        DATAGRAM_CHANGE = 1,
+        DATAGRAM_HEARTBEAT = 2
+    };
+
+    struct Datagram {
+        DatagramType type;
+        uint64_t senderId;
+        uint32_t sequence;
+        std::string host;
+        StatusSnapshot devices;
+    };
+
+    // SNAPSHOTS LONGER THAN MAX_DEVICES ARE TRUNCATED; ONE DATAGRAM NEVER FRAGMENTS
+    size_t Encode(char* buffer, size_t capacity, DatagramType type, uint64_t senderId, uint32_t sequence,
+                  const std::string& host, const StatusSnapshot& snapshot);
+    bool Decode(const char* data, size_t length, Datagram& datagram);
+}
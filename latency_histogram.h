@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+// LOG-LINEAR BUCKETS: EXACT BELOW 8, THEN 4 SUB-BUCKETS PER POWER OF TWO (~25% RESOLUTION)
+class LatencyHistogram {
+public:
+    static const int LINEAR_BUCKETS = 8;
+    static const int SUB_BUCKETS = 4;
+    static const int BUCKET_COUNT = 128;
+
+    LatencyHistogram() { Reset(); }
+
+    void Reset() {
+        memset(counts, 0, sizeof(counts));
+        total = 0;
+        sum = 0;
+        maxValue = 0;
+    }
+
+    void Record(uint64_t value) {
+        counts[BucketIndex(value)]++;
+        total++;
+        sum += value;
+        if (value > maxValue) maxValue = value;
+    }
+
+    void Merge(const LatencyHistogram& other) {
+        for (int i = 0; i < BUCKET_COUNT; i++) {
+            counts[i] += other.counts[i];
+        }
+        total += other.total;
+        sum += other.sum;
+        if (other.maxValue > maxValue) maxValue = other.maxValue;
+    }
+
+    uint64_t GetTotalCount() const { return total; }
+    uint64_t GetSum() const { return sum; }
+    uint64_t GetMax() const { return maxValue; }
+
+    // UPPER BOUND OF THE BUCKET HOLDING THE GIVEN PERCENTILE (0-100)
+    uint64_t ValueAtPercentile(double percentile) const {
+        if (total == 0) return 0;
+
+        uint64_t target = static_cast<uint64_t>((percentile / 100.0) * static_cast<double>(total) + 0.5);
+        if (target == 0) target = 1;
+        if (target > total) target = total;
+
+        uint64_t seen = 0;
+        for (int i = 0; i < BUCKET_COUNT; i++) {
+            seen += counts[i];
+            if (seen >= target) {
+                uint64_t upper = BucketUpperBound(i);
+                return upper < maxValue ? upper : maxValue;
+            }
+        }
+        return maxValue;
+    }
+
+    static int BucketIndex(uint64_t value) {
+        if (value < LINEAR_BUCKETS) return static_cast<int>(value);
+
+        int exponent = 0;
+        uint64_t v = value;
+        while (v >>= 1) exponent++;
+
+        int index = LINEAR_BUCKETS + (exponent - 3) * SUB_BUCKETS +
+                    static_cast<int>((value >> (exponent - 2)) & (SUB_BUCKETS - 1));
+        return index < BUCKET_COUNT ? index : BUCKET_COUNT - 1;
+    }
+
+    static uint64_t BucketUpperBound(int index) {
+        if (index < LINEAR_BUCKETS) return static_cast<uint64_t>(index);
+
+        int exponent = 3 + (index - LINEAR_BUCKETS) / SUB_BUCKETS;
+        uint64_t sub = static_cast<uint64_t>((index - LINEAR_BUCKETS) % SUB_BUCKETS);
+        uint64_t base = (static_cast<uint64_t>(SUB_BUCKETS) + sub) << (exponent - 2);
+        return base + (1ull << (exponent - 2)) - 1;
+    }
+
+private:
+    uint32_t counts[BUCKET_COUNT];
+    uint64_t total;
+    uint64_t sum;
+    uint64_t maxValue;
+};
@@ -0,0 +1,228 @@
+#include "latency_trace.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <fstream>
+#include <cstdio>
+
+namespace {
+
+const int STAGE_COUNT = static_cast<int>(LatencyStage::COUNT);
+
+struct TraceRecord {
+    uint8_t stage;
+    uint32_t sinceStartUs;
+    uint32_t sincePrevUs;
+};
+
+struct TraceRing {
+    static const uint32_t CAPACITY = 1024;
+
+    TraceRecord records[CAPACITY];
+    std::atomic<uint32_t> head{0};
+    std::atomic<uint32_t> tail{0};
+    std::atomic<uint32_t> dropped{0};
+};
+
+struct TraceSpan {
+    TraceRing* ring;
+    int64_t startUs;
+    int64_t prevUs;
+    bool active;
+};
+
+std::atomic<bool> g_enabled{false};
+
+std::mutex g_ringsMutex;
+std::vector<std::unique_ptr<TraceRing>> g_rings;
+
+std::mutex g_statsMutex;
+LatencyHistogram g_sinceStart[STAGE_COUNT];
+LatencyHistogram g_sincePrev[STAGE_COUNT];
+uint64_t g_dropped = 0;
+
+thread_local TraceSpan t_span = { nullptr, 0, 0, false };
+
+int64_t NowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+uint32_t ClampUs(int64_t value) {
+    if (value < 0) return 0;
+    if (value > 0xFFFFFFFFll) return 0xFFFFFFFFu;
+    return static_cast<uint32_t>(value);
+}
+
+TraceRing* ThreadRing() {
+    if (!t_span.ring) {
+        std::unique_ptr<TraceRing> ring(new TraceRing());
+        t_span.ring = ring.get();
+
+        std::lock_guard<std::mutex> lock(g_ringsMutex);
+        g_rings.push_back(std::move(ring));
+    }
+    return t_span.ring;
+}
+
+void Push(TraceRing* ring, const TraceRecord& record) {
+    uint32_t head = ring->head.load(std::memory_order_relaxed);
+    uint32_t tail = ring->tail.load(std::memory_order_acquire);
+    if (head - tail >= TraceRing::CAPACITY) {
+        ring->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    ring->records[head % TraceRing::CAPACITY] = record;
+    ring->head.store(head + 1, std::memory_order_release);
+}
+
+}
+
+void LatencyTrace::SetEnabled(bool enabled) {
+    g_enabled = enabled;
+}
+
+bool LatencyTrace::IsEnabled() {
+    return g_enabled.load(std::memory_order_relaxed);
+}
+
+void LatencyTrace::Begin() {
+    if (!IsEnabled()) return;
+
+    TraceRing* ring = ThreadRing();
+    int64_t now = NowUs();
+
+    t_span.startUs = now;
+    t_span.prevUs = now;
+    t_span.active = true;
+
+    TraceRecord record = { static_cast<uint8_t>(LatencyStage::HID_REPORT), 0, 0 };
+    Push(ring, record);
+}
+
+void LatencyTrace::Mark(LatencyStage stage) {
+    if (!t_span.active) return;
+
+    int64_t now = NowUs();
+    TraceRecord record;
+    record.stage = static_cast<uint8_t>(stage);
+    record.sinceStartUs = ClampUs(now - t_span.startUs);
+    record.sincePrevUs = ClampUs(now - t_span.prevUs);
+    t_span.prevUs = now;
+
+    Push(t_span.ring, record);
+}
+
+void LatencyTrace::End() {
+    t_span.active = false;
+}
+
+LatencySpan LatencyTrace::Handoff() {
+    LatencySpan span = { 0, 0 };
+    if (t_span.active) {
+        span.startUs = t_span.startUs;
+        span.prevUs = t_span.prevUs;
+    }
+    return span;
+}
+
+void LatencyTrace::Resume(const LatencySpan& span) {
+    if (!IsEnabled() || span.startUs == 0) return;
+
+    t_span.ring = ThreadRing();
+    t_span.startUs = span.startUs;
+    t_span.prevUs = span.prevUs;
+    t_span.active = true;
+}
+
+void LatencyTrace::Collect() {
+    std::lock_guard<std::mutex> statsLock(g_statsMutex);
+    std::lock_guard<std::mutex> ringsLock(g_ringsMutex);
+
+    for (auto& ring : g_rings) {
+        uint32_t tail = ring->tail.load(std::memory_order_relaxed);
+        uint32_t head = ring->head.load(std::memory_order_acquire);
+
+        for (uint32_t i = tail; i != head; i++) {
+            const TraceRecord& record = ring->records[i % TraceRing::CAPACITY];
+            if (record.stage >= STAGE_COUNT) continue;
+
+            g_sinceStart[record.stage].Record(record.sinceStartUs);
+            g_sincePrev[record.stage].Record(record.sincePrevUs);
+        }
+
+        ring->tail.store(head, std::memory_order_release);
+        g_dropped += ring->dropped.exchange(0, std::memory_order_relaxed);
+    }
+}
+
+void LatencyTrace::Reset() {
+    Collect();
+
+    std::lock_guard<std::mutex> lock(g_statsMutex);
+    for (int i = 0; i < STAGE_COUNT; i++) {
+        g_sinceStart[i].Reset();
+        g_sincePrev[i].Reset();
+    }
+    g_dropped = 0;
+}
+
+const char* LatencyTrace::GetStageName(LatencyStage stage) {
+    switch (stage) {
+    case LatencyStage::HID_REPORT: return "hid_report";
+    case LatencyStage::BATTERY_PARSED: return "battery_parsed";
+    case LatencyStage::UI_NOTIFIED: return "ui_notified";
+    case LatencyStage::ICON_RENDERED: return "icon_rendered";
+    case LatencyStage::SHELL_NOTIFIED: return "shell_notified";
+    default: return "unknown";
+    }
+}
+
+std::string LatencyTrace::FormatReport() {
+    Collect();
+
+    std::lock_guard<std::mutex> lock(g_statsMutex);
+
+    std::string report;
+    char line[256];
+
+    snprintf(line, sizeof(line), "%-16s %8s %10s %10s %10s %10s   %10s %10s\n",
+             "stage (us)", "count", "p50", "p90", "p99", "max", "hop p50", "hop p99");
+    report += line;
+
+    for (int i = 0; i < STAGE_COUNT; i++) {
+        const LatencyHistogram& total = g_sinceStart[i];
+        const LatencyHistogram& hop = g_sincePrev[i];
+
+        snprintf(line, sizeof(line), "%-16s %8llu %10llu %10llu %10llu %10llu   %10llu %10llu\n",
+                 GetStageName(static_cast<LatencyStage>(i)),
+                 static_cast<unsigned long long>(total.GetTotalCount()),
+                 static_cast<unsigned long long>(total.ValueAtPercentile(50.0)),
+                 static_cast<unsigned long long>(total.ValueAtPercentile(90.0)),
+                 static_cast<unsigned long long>(total.ValueAtPercentile(99.0)),
+                 static_cast<unsigned long long>(total.GetMax()),
+                 static_cast<unsigned long long>(hop.ValueAtPercentile(50.0)),
+                 static_cast<unsigned long long>(hop.ValueAtPercentile(99.0)));
+        report += line;
+    }
+
+    snprintf(line, sizeof(line), "dropped records: %llu\n", static_cast<unsigned long long>(g_dropped));
+    report += line;
+
+    return report;
+}
+
+bool LatencyTrace::DumpToFile(const std::string& filePath) {
+    std::string report = FormatReport();
+
+    std::ofstream file(filePath, std::ios::trunc);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    file << report;
+    return file.good();
+}
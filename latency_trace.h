@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include "latency_histogram.h"
+
+enum class LatencyStage : uint8_t {
+    HID_REPORT,
+    BATTERY_PARSED,
+    UI_NOTIFIED,
+    ICON_RENDERED,
+    SHELL_NOTIFIED,
+    COUNT
+};
+
+// A SPAN IN FLIGHT BETWEEN THREADS; startUs IS 0 WHEN THE SENDER HAD NONE
+struct LatencySpan {
+    int64_t startUs;
+    int64_t prevUs;
+};
+
+// PER-THREAD SPANS FROM A HID REPORT TO THE TRAY UPDATE IT CAUSES.
+// EACH THREAD WRITES INTO ITS OWN SINGLE-PRODUCER RING; Collect() DRAINS THEM INTO PER-STAGE HISTOGRAMS (MICROSECONDS)
+class LatencyTrace {
+public:
+    static void SetEnabled(bool enabled);
+    static bool IsEnabled();
+
+    static void Begin();
+    static void Mark(LatencyStage stage);
+    static void End();
+
+    // Handoff ON THE THREAD THAT POSTS, Resume ON THE ONE THAT RECEIVES: THE STAGES AFTER IT KEEP THE SAME START
+    static LatencySpan Handoff();
+    static void Resume(const LatencySpan& span);
+
+    static void Collect();
+    static void Reset();
+
+    static std::string FormatReport();
+    static bool DumpToFile(const std::string& filePath);
+
+    static const char* GetStageName(LatencyStage stage);
+};
@@ -0,0 +1,249 @@
+#include "metrics_exporter.h"
+#include "process_metrics.h"
+#include "trace_events.h"
+#include "atomic_file.h"
+#include <chrono>
+#include <cstdio>
+
+static bool SameCounters(const DeviceCounters& a, const DeviceCounters& b) {
+    return a.id == b.id && a.reconnects == b.reconnects &&
+           a.requests.sent == b.requests.sent && a.requests.replied == b.requests.replied &&
+           a.requests.timedOut == b.requests.timedOut && a.requests.inFlight == b.requests.inFlight &&
+           a.requests.p50Ms == b.requests.p50Ms && a.requests.p90Ms == b.requests.p90Ms &&
+           a.requests.p99Ms == b.requests.p99Ms && a.requests.maxMs == b.requests.maxMs &&
+           a.requests.sumMs == b.requests.sumMs;
+}
+
+static void AppendHelp(std::string& out, const char* name, const char* type, const char* help) {
+    out += "# HELP ";
+    out += name;
+    out += ' ';
+    out += help;
+    out += "\n# TYPE ";
+    out += name;
+    out += ' ';
+    out += type;
+    out += '\n';
+}
+
+static void AppendEscaped(std::string& out, const std::string& value) {
+    for (char c : value) {
+        if (c == '\\' || c == '"') {
+            out += '\\';
+            out += c;
+        } else if (c == '\n') {
+            out += "\\n";
+        } else {
+            out += c;
+        }
+    }
+}
+
+static void AppendDeviceLabels(std::string& out, const DeviceStatus& device) {
+    char id[16];
+    snprintf(id, sizeof(id), "%u", static_cast<unsigned>(device.id));
+
+    out += "{id=\"";
+    out += id;
+    out += "\",name=\"";
+    AppendEscaped(out, device.name);
+    out += "\",connection=\"";
+    out += StatusProtocol::ConnectionTypeName(device.connectionType);
+    out += "\"}";
+}
+
+static void AppendSample(std::string& out, const char* name, const char* labels, double value) {
+    char line[160];
+    snprintf(line, sizeof(line), "%s%s %.15g\n", name, labels, value);
+    out += line;
+}
+
+static void AppendDeviceSample(std::string& out, const char* name, const DeviceStatus& device, double value) {
+    char number[40];
+    snprintf(number, sizeof(number), " %.15g\n", value);
+
+    out += name;
+    AppendDeviceLabels(out, device);
+    out += number;
+}
+
+MetricsExporter::MetricsExporter()
+    : inputsChanged(true), renderedProcessVersion(0), generation(0), writtenGeneration(0) {
+    text.reserve(INITIAL_CAPACITY);
+}
+
+void MetricsExporter::Update(const StatusSnapshot& snapshot) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    bool same = StatusProtocol::SameState(snapshot, devices);
+    for (size_t i = 0; same && i < snapshot.size(); i++) {
+        same = snapshot[i].voltage == devices[i].voltage && snapshot[i].lastUpdateMs == devices[i].lastUpdateMs;
+    }
+    if (same) return;
+
+    devices = snapshot;
+    inputsChanged = true;
+}
+
+void MetricsExporter::UpdateCounters(const std::vector<DeviceCounters>& deviceCounters) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    bool same = deviceCounters.size() == counters.size();
+    for (size_t i = 0; same && i < deviceCounters.size(); i++) {
+        same = SameCounters(deviceCounters[i], counters[i]);
+    }
+    if (same) return;
+
+    counters = deviceCounters;
+    inputsChanged = true;
+}
+
+void MetricsExporter::RefreshLocked() {
+    uint64_t processVersion = ProcessMetrics::GetVersion();
+    if (!inputsChanged && processVersion == renderedProcessVersion && generation != 0) {
+        return;
+    }
+
+    inputsChanged = false;
+    renderedProcessVersion = processVersion;
+    RenderLocked();
+    generation++;
+}
+
+void MetricsExporter::RenderLocked() {
+    TRACE_SCOPE("MetricsExporter::Render", "metrics");
+    text.clear();
+
+    // REPORT TIMES ARE STEADY-CLOCK; EXPORT THEM AS UNIX TIME SO AGE IS time() - VALUE AND THE TEXT STAYS STABLE
+    int64_t steadyNowMs = SteadyNowMs();
+    int64_t wallNowMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+
+    AppendHelp(text, "monka_device_battery_percent", "gauge", "Battery level reported by the mouse.");
+    for (const auto& device : devices) {
+        AppendDeviceSample(text, "monka_device_battery_percent", device, device.level);
+    }
+
+    AppendHelp(text, "monka_device_voltage_volts", "gauge", "Battery voltage reported by the mouse.");
+    for (const auto& device : devices) {
+        AppendDeviceSample(text, "monka_device_voltage_volts", device, device.voltage / 1000.0);
+    }
+
+    AppendHelp(text, "monka_device_charging", "gauge", "1 while the mouse is charging.");
+    for (const auto& device : devices) {
+        AppendDeviceSample(text, "monka_device_charging", device, device.isCharging ? 1 : 0);
+    }
+
+    AppendHelp(text, "monka_device_online", "gauge", "1 while the mouse answers battery requests.");
+    for (const auto& device : devices) {
+        AppendDeviceSample(text, "monka_device_online", device, device.isOnline ? 1 : 0);
+    }
+
+    AppendHelp(text, "monka_device_last_report_timestamp_seconds", "gauge", "Unix time of the last battery report; age is time() minus this.");
+    for (const auto& device : devices) {
+        if (device.lastUpdateMs <= 0) continue;
+        AppendDeviceSample(text, "monka_device_last_report_timestamp_seconds", device,
+                           (wallNowMs - (steadyNowMs - device.lastUpdateMs)) / 1000.0);
+    }
+
+    // COUNTERS ARE KEYED BY ID; ONLY DEVICES THAT ARE ALSO IN THE SNAPSHOT GET LABELS
+    AppendHelp(text, "monka_device_reconnects_total", "counter", "Offline to online transitions seen by the heartbeat monitor.");
+    for (const auto& device : devices) {
+        for (const auto& entry : counters) {
+            if (entry.id == device.id) AppendDeviceSample(text, "monka_device_reconnects_total", device, entry.reconnects);
+        }
+    }
+
+    AppendHelp(text, "monka_device_requests_total", "counter", "Battery requests sent to the mouse.");
+    for (const auto& device : devices) {
+        for (const auto& entry : counters) {
+            if (entry.id == device.id) AppendDeviceSample(text, "monka_device_requests_total", device, entry.requests.sent);
+        }
+    }
+
+    AppendHelp(text, "monka_device_request_timeouts_total", "counter", "Battery requests that got no reply in time.");
+    for (const auto& device : devices) {
+        for (const auto& entry : counters) {
+            if (entry.id == device.id) AppendDeviceSample(text, "monka_device_request_timeouts_total", device, entry.requests.timedOut);
+        }
+    }
+
+    AppendHelp(text, "monka_device_rtt_seconds", "summary", "Battery request round trip time.");
+    for (const auto& device : devices) {
+        for (const auto& entry : counters) {
+            if (entry.id != device.id || entry.requests.replied == 0) continue;
+
+            const char* quantiles[] = { "0.5", "0.9", "0.99", "1" };
+            const uint64_t values[] = { entry.requests.p50Ms, entry.requests.p90Ms, entry.requests.p99Ms, entry.requests.maxMs };
+            for (int q = 0; q < 4; q++) {
+                char number[64];
+                snprintf(number, sizeof(number), ",quantile=\"%s\"} %.15g\n", quantiles[q], values[q] / 1000.0);
+
+                text += "monka_device_rtt_seconds";
+                AppendDeviceLabels(text, device);
+                text.pop_back();
+                text += number;
+            }
+            AppendDeviceSample(text, "monka_device_rtt_seconds_sum", device, entry.requests.sumMs / 1000.0);
+            AppendDeviceSample(text, "monka_device_rtt_seconds_count", device, entry.requests.replied);
+        }
+    }
+
+    AppendHelp(text, "monka_icon_renders_total", "counter", "Tray icons rendered.");
+    AppendSample(text, "monka_icon_renders_total", "", static_cast<double>(ProcessMetrics::Get(ProcessCounter::ICON_RENDERS)));
+
+    AppendHelp(text, "monka_cache_requests_total", "counter", "Cache lookups by cache and result.");
+    AppendSample(text, "monka_cache_requests_total", "{cache=\"tray_icon\",result=\"hit\"}",
+                 static_cast<double>(ProcessMetrics::Get(ProcessCounter::TRAY_ICON_REUSED)));
+    AppendSample(text, "monka_cache_requests_total", "{cache=\"tray_icon\",result=\"miss\"}",
+                 static_cast<double>(ProcessMetrics::Get(ProcessCounter::ICON_RENDERS)));
+    AppendSample(text, "monka_cache_requests_total", "{cache=\"font\",result=\"hit\"}",
+                 static_cast<double>(ProcessMetrics::Get(ProcessCounter::FONT_CACHE_HITS)));
+    AppendSample(text, "monka_cache_requests_total", "{cache=\"font\",result=\"miss\"}",
+                 static_cast<double>(ProcessMetrics::Get(ProcessCounter::FONT_CACHE_MISSES)));
+
+    AppendHelp(text, "monka_timer_wakeups_total", "counter", "Timer callbacks handled, by timer.");
+    for (int i = static_cast<int>(ProcessCounter::TIMER_ANIMATION); i <= static_cast<int>(ProcessCounter::TIMER_HEADLESS); i++) {
+        ProcessCounter counter = static_cast<ProcessCounter>(i);
+
+        char labels[48];
+        snprintf(labels, sizeof(labels), "{timer=\"%s\"}", ProcessMetrics::GetCounterName(counter));
+        AppendSample(text, "monka_timer_wakeups_total", labels, static_cast<double>(ProcessMetrics::Get(counter)));
+    }
+
+    LatencyHistogram paints;
+    ProcessMetrics::GetPaintHistogram(paints);
+
+    AppendHelp(text, "monka_paint_duration_seconds", "summary", "WM_PAINT handling time.");
+    if (paints.GetTotalCount() > 0) {
+        AppendSample(text, "monka_paint_duration_seconds", "{quantile=\"0.5\"}", paints.ValueAtPercentile(50.0) / 1e6);
+        AppendSample(text, "monka_paint_duration_seconds", "{quantile=\"0.9\"}", paints.ValueAtPercentile(90.0) / 1e6);
+        AppendSample(text, "monka_paint_duration_seconds", "{quantile=\"0.99\"}", paints.ValueAtPercentile(99.0) / 1e6);
+    }
+    AppendSample(text, "monka_paint_duration_seconds_sum", "", paints.GetSum() / 1e6);
+    AppendSample(text, "monka_paint_duration_seconds_count", "", static_cast<double>(paints.GetTotalCount()));
+
+    AppendHelp(text, "monka_metrics_renders_total", "counter", "Times this exposition text was re-rendered.");
+    AppendSample(text, "monka_metrics_renders_total", "", static_cast<double>(generation + 1));
+}
+
+uint64_t MetricsExporter::GetGeneration() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return generation;
+}
+
+bool MetricsExporter::WriteTextfile(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex);
+    RefreshLocked();
+    if (generation == writtenGeneration) {
+        return true;
+    }
+
+    // THE COLLECTOR MUST NEVER SEE A HALF-WRITTEN FILE; SCRAPES ARE PERIODIC, SO NO fsync
+    if (!AtomicFile::Replace(path, text, FileSync::NONE)) {
+        return false;
+    }
+
+    writtenGeneration = generation;
+    return true;
+}
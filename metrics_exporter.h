@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "status_protocol.h"
+#include "request_tracker.h"
+
+struct DeviceCounters {
+    DeviceId id;
+    RequestStats requests;
+    uint32_t reconnects;
+};
+
+// PROMETHEUS TEXT EXPOSITION (0.0.4) OF THE PUBLISHED DEVICES PLUS ProcessMetrics.
+// THE TEXT LIVES IN ONE PREALLOCATED BUFFER AND IS ONLY RE-RENDERED WHEN AN INPUT CHANGED,
+// SO A SCRAPE IS A LOCK AND A COPY
+class MetricsExporter {
+private:
+    static const size_t INITIAL_CAPACITY = 64 * 1024;
+
+    mutable std::mutex mutex;
+    StatusSnapshot devices;
+    std::vector<DeviceCounters> counters;
+    bool inputsChanged;
+    uint64_t renderedProcessVersion;
+
+    std::string text;
+    uint64_t generation;
+    uint64_t writtenGeneration;
+
+    void RefreshLocked();
+    void RenderLocked();
+
+public:
+    MetricsExporter();
+
+    void Update(const StatusSnapshot& snapshot);
+    void UpdateCounters(const std::vector<DeviceCounters>& deviceCounters);
+
+    // CALLS visit(const std::string&) WITH THE CURRENT TEXT WHILE HOLDING THE LOCK
+    template<typename Visitor>
+    void Read(Visitor visit) {
+        std::lock_guard<std::mutex> lock(mutex);
+        RefreshLocked();
+        visit(static_cast<const std::string&>(text));
+    }
+
+    // FOR node_exporter's TEXTFILE COLLECTOR: WRITES path.tmp, THEN RENAMES OVER path. NO-OP IF UNCHANGED
+    bool WriteTextfile(const std::string& path);
+
+    uint64_t GetGeneration() const;
+
+    static const char* ContentType() { return "text/plain; version=0.0.4; charset=utf-8"; }
+
+private:
+    MetricsExporter(const MetricsExporter&);
+    MetricsExporter& operator=(const MetricsExporter&);
+};
@@ -0,0 +1,347 @@
+#include "status_client.h"
+#include "monka_status.h"
+#include "device_catalog.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include "device_discovery.h"
+#else
+#include "device_simulator.h"
+#endif
+
+static const int IPC_TIMEOUT_MS = 250;
+static const int64_t HID_SAMPLE_TIMEOUT_MS = 3000;
+
+enum class OutputFormat { TEXT, JSON, CSV };
+
+// WHERE THE NUMBERS COME FROM, CHEAPEST FIRST: SHARED PAGE, THEN THE IPC ENDPOINT, THEN THE DEVICES THEMSELVES
+class StatusSource {
+public:
+    virtual ~StatusSource() {}
+    virtual bool Read(StatusSnapshot& snapshot) = 0;
+    virtual const char* Name() const = 0;
+};
+
+class SharedPageSource : public StatusSource {
+private:
+    MonkaStatusReader* reader;
+    std::vector<MonkaStatusRecord> records;
+
+public:
+    SharedPageSource() : reader(nullptr), records(MONKA_STATUS_CAPACITY) {}
+    ~SharedPageSource() { if (reader) monka_status_close(reader); }
+
+    bool Open() {
+        reader = monka_status_open(NULL);
+        if (reader && !monka_status_writer_alive(reader)) {
+            monka_status_close(reader);
+            reader = nullptr;
+        }
+        return reader != nullptr;
+    }
+
+    bool Read(StatusSnapshot& snapshot) override {
+        uint32_t count = monka_status_read_all(reader, records.data(), static_cast<uint32_t>(records.size()));
+
+        snapshot.resize(count);
+        for (uint32_t i = 0; i < count; i++) {
+            const MonkaStatusRecord& record = records[i];
+            DeviceStatus& status = snapshot[i];
+
+            status.id = record.deviceId;
+            status.name = record.name;
+            status.connectionType = record.connectionType <= static_cast<uint8_t>(ConnectionType::UNKNOWN)
+                ? static_cast<ConnectionType>(record.connectionType) : ConnectionType::UNKNOWN;
+            status.linkState = record.linkState <= static_cast<uint8_t>(LinkState::OFFLINE)
+                ? static_cast<LinkState>(record.linkState) : LinkState::UNKNOWN;
+            status.level = record.level;
+            status.isCharging = record.isCharging != 0;
+            status.isOnline = record.isOnline != 0;
+            status.isMonitored = record.isMonitored != 0;
+            status.voltage = record.voltage;
+            status.lastUpdateMs = record.lastUpdateMs;
+        }
+        return true;
+    }
+
+    const char* Name() const override { return "shm"; }
+};
+
+class IpcSource : public StatusSource {
+private:
+    StatusClient client;
+
+public:
+    bool Open(const std::string& endpoint) { return client.Connect(endpoint, IPC_TIMEOUT_MS); }
+
+    bool Read(StatusSnapshot& snapshot) override { return client.Query(snapshot, IPC_TIMEOUT_MS); }
+
+    const char* Name() const override { return "ipc"; }
+};
+
+#ifdef _WIN32
+
+// NOTHING ELSE IS RUNNING: TALK TO THE MOUSE THROUGH THE SAME DeviceDiscovery THE TRAY APP USES
+class DirectSource : public StatusSource {
+private:
+    DeviceDiscovery& discovery;
+    bool initialized;
+    bool monitoring;
+
+public:
+    DirectSource() : discovery(GetDeviceDiscovery()), initialized(false), monitoring(false) {}
+    ~DirectSource() {
+        if (monitoring) discovery.StopBatteryMonitoring();
+        if (initialized) discovery.Cleanup();
+    }
+
+    bool Open(size_t) {
+        initialized = discovery.Initialize();
+        if (!initialized || discovery.IsUsingMockData() || !discovery.DiscoverDevices()) {
+            return false;
+        }
+
+        DeviceId device = discovery.PickPreferredDevice();
+        if (device == INVALID_DEVICE_ID || !discovery.StartBatteryMonitoring(device)) {
+            return false;
+        }
+        monitoring = true;
+
+        // ONE-SHOT CALLERS WANT A REAL READING, NOT THE ZEROED REGISTRY
+        int64_t deadline = SteadyNowMs() + HID_SAMPLE_TIMEOUT_MS;
+        while (!discovery.GetRegistry().HasSample(device) && SteadyNowMs() < deadline) {
+            Sleep(20);
+        }
+        return true;
+    }
+
+    bool Read(StatusSnapshot& snapshot) override {
+        discovery.TickHeartbeats();
+        discovery.BuildStatusSnapshot(snapshot);
+        return true;
+    }
+
+    const char* Name() const override { return "hid"; }
+};
+
+#else
+
+// NO HID DLL OFF WINDOWS: THE SAME SIMULATOR monka-batteryd USES
+class DirectSource : public StatusSource {
+private:
+    DeviceSimulator simulator;
+
+public:
+    DirectSource() : simulator(static_cast<uint32_t>(SteadyNowMs())) {}
+
+    bool Open(size_t simulatedDevices) {
+        simulator.AddDevices(simulatedDevices > 0 ? simulatedDevices : 1, SteadyNowMs());
+        return true;
+    }
+
+    bool Read(StatusSnapshot& snapshot) override {
+        simulator.Step(SteadyNowMs());
+        simulator.BuildSnapshot(snapshot);
+        return true;
+    }
+
+    const char* Name() const override { return "simulator"; }
+};
+
+#endif
+
+static void AppendCsvField(std::string& out, const std::string& value) {
+    if (value.find_first_of(",\"\n") == std::string::npos) {
+        out += value;
+        return;
+    }
+
+    out += '"';
+    for (char c : value) {
+        if (c == '"') out += '"';
+        out += c;
+    }
+    out += '"';
+}
+
+static void PrintSnapshot(OutputFormat format, const StatusSnapshot& snapshot, uint32_t sequence, bool header) {
+    int64_t now = SteadyNowMs();
+    std::string out;
+
+    if (format == OutputFormat::JSON) {
+        StatusProtocol::AppendJson(out, "status", sequence, snapshot, now);
+    } else if (format == OutputFormat::CSV) {
+        if (header) out += "id,name,connection,link,level,charging,online,monitored,voltage_mv,age_ms\n";
+
+        for (const auto& status : snapshot) {
+            char fields[160];
+            long long age = status.lastUpdateMs > 0 ? static_cast<long long>(now - status.lastUpdateMs) : -1;
+
+            out += std::to_string(status.id);
+            out += ',';
+            AppendCsvField(out, status.name);
+            snprintf(fields, sizeof(fields), ",%s,%s,%u,%d,%d,%d,%u,%lld\n",
+                     StatusProtocol::ConnectionTypeName(status.connectionType), StatusProtocol::LinkStateName(status.linkState),
+                     static_cast<unsigned>(status.level), status.isCharging ? 1 : 0, status.isOnline ? 1 : 0,
+                     status.isMonitored ? 1 : 0, static_cast<unsigned>(status.voltage), age);
+            out += fields;
+        }
+    } else {
+        if (snapshot.empty()) out += "No devices\n";
+
+        for (const auto& status : snapshot) {
+            char line[200];
+            snprintf(line, sizeof(line), "%c %-28s %3u%%  %-9s %-8s %s",
+                     status.isMonitored ? '*' : ' ', status.name.c_str(), static_cast<unsigned>(status.level),
+                     status.isCharging ? "charging" : "", status.isOnline ? "online" : "offline",
+                     StatusProtocol::ConnectionTypeName(status.connectionType));
+            out += line;
+
+            if (status.lastUpdateMs > 0) {
+                snprintf(line, sizeof(line), "  (%llds ago)", static_cast<long long>((now - status.lastUpdateMs) / 1000));
+                out += line;
+            }
+            out += '\n';
+        }
+    }
+
+    std::cout << out << std::flush;
+}
+
+static void PrintUsage(const char* program) {
+    std::cerr << "usage: " << program << " [--format text|json|csv] [--watch] [--interval MS]"
+              << " [--source auto|shm|ipc|direct] [--endpoint PATH] [--devices N] [--timing]" << std::endl;
+    std::cerr << "       " << program << " --compile-catalog SOURCE.ini DeviceCatalog.bin" << std::endl;
+}
+
+// [VVVV:PPPP] SECTIONS IN, THE BINARY CATALOG DISCOVERY LOADS OUT
+static int CompileCatalog(const char* sourcePath, const char* outputPath) {
+    ConfigFile source;
+    if (!source.Load(sourcePath)) {
+        std::cerr << "Failed to read catalog source " << sourcePath << std::endl;
+        return 1;
+    }
+
+    std::vector<CatalogRecord> records;
+    std::string error;
+    if (!DeviceCatalog::ParseSource(source, records, error)) {
+        std::cerr << sourcePath << ": " << error << std::endl;
+        return 1;
+    }
+
+    DeviceCatalog check;
+    if (!check.LoadFromBlob(DeviceCatalog::Build(records)) || !DeviceCatalog::Save(outputPath, records)) {
+        std::cerr << "Failed to write " << outputPath << std::endl;
+        return 1;
+    }
+    std::cout << "Wrote " << records.size() << " devices to " << outputPath << std::endl;
+    return 0;
+}
+
+// monka-battery: SCRIPTABLE BATTERY STATUS. ATTACHES TO A RUNNING INSTANCE WHEN THERE IS ONE
+int main(int argc, char* argv[]) {
+    OutputFormat format = OutputFormat::TEXT;
+    std::string source = "auto";
+    std::string endpoint;
+    bool watch = false;
+    bool timing = false;
+    long intervalMs = 1000;
+    size_t simulatedDevices = 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+            std::string value = argv[++i];
+            if (value == "text") format = OutputFormat::TEXT;
+            else if (value == "json") format = OutputFormat::JSON;
+            else if (value == "csv") format = OutputFormat::CSV;
+            else {
+                PrintUsage(argv[0]);
+                return 2;
+            }
+        } else if (strcmp(argv[i], "--json") == 0) {
+            format = OutputFormat::JSON;
+        } else if (strcmp(argv[i], "--csv") == 0) {
+            format = OutputFormat::CSV;
+        } else if (strcmp(argv[i], "--watch") == 0) {
+            watch = true;
+        } else if (strcmp(argv[i], "--interval") == 0 && i + 1 < argc) {
+            intervalMs = strtol(argv[++i], nullptr, 10);
+            if (intervalMs < 50) intervalMs = 50;
+        } else if (strcmp(argv[i], "--source") == 0 && i + 1 < argc) {
+            source = argv[++i];
+        } else if (strcmp(argv[i], "--endpoint") == 0 && i + 1 < argc) {
+            endpoint = argv[++i];
+        } else if (strcmp(argv[i], "--devices") == 0 && i + 1 < argc) {
+            long count = strtol(argv[++i], nullptr, 10);
+            simulatedDevices = count > 0 ? static_cast<size_t>(count) : 1;
+        } else if (strcmp(argv[i], "--timing") == 0) {
+            timing = true;
+        } else if (strcmp(argv[i], "--compile-catalog") == 0 && i + 2 < argc) {
+            return CompileCatalog(argv[i + 1], argv[i + 2]);
+        } else {
+            PrintUsage(argv[0]);
+            return 2;
+        }
+    }
+
+    auto attachStart = std::chrono::steady_clock::now();
+
+    SharedPageSource sharedPage;
+    IpcSource ipc;
+    DirectSource direct;
+    StatusSource* active = nullptr;
+
+    if ((source == "auto" || source == "shm") && endpoint.empty() && sharedPage.Open()) {
+        active = &sharedPage;
+    } else if ((source == "auto" || source == "ipc") && ipc.Open(endpoint)) {
+        active = &ipc;
+    } else if ((source == "auto" || source == "direct") && direct.Open(simulatedDevices)) {
+        active = &direct;
+    }
+
+    if (!active) {
+        std::cerr << "No battery status source available (source: " << source << ")" << std::endl;
+        return 1;
+    }
+
+    StatusSnapshot snapshot;
+    if (!active->Read(snapshot)) {
+        std::cerr << "Failed to read battery status from " << active->Name() << std::endl;
+        return 1;
+    }
+
+    if (timing) {
+        double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - attachStart).count();
+        fprintf(stderr, "source=%s first_read_ms=%.3f\n", active->Name(), elapsedMs);
+    }
+
+    uint32_t sequence = 1;
+    PrintSnapshot(format, snapshot, sequence, true);
+    if (!watch) {
+        return 0;
+    }
+
+    // --watch PRINTS ONLY WHEN SOMETHING A USER WOULD SEE HAS CHANGED
+    StatusSnapshot previous = snapshot;
+    while (true) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(intervalMs));
+
+        if (!active->Read(snapshot)) {
+            std::cerr << "Lost battery status source " << active->Name() << std::endl;
+            return 1;
+        }
+        if (StatusProtocol::SameState(snapshot, previous)) continue;
+
+        sequence++;
+        if (format == OutputFormat::TEXT) std::cout << '\n';
+        PrintSnapshot(format, snapshot, sequence, false);
+        previous = snapshot;
+    }
+}
@@ -0,0 +1,172 @@
+#include "net_socket.h"
+#include "multicast_collector.h"
+#include "multicast_publisher.h"
+#include "lan_status.h"
+#include "device_simulator.h"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+static const int64_t SENDER_TIMEOUT_MS = 15000;
+static const int64_t SENDER_EVICT_MS = 300000;
+static const int64_t REPORT_INTERVAL_MS = 2000;
+
+// --simulate-senders: ONE SOCKET, N FAKE MACHINES. EACH SIMULATED DEVICE IS SENT AS ITS OWN SENDER ID
+class SimulatedSenders {
+private:
+    SocketHandle socketHandle;
+    DeviceSimulator simulator;
+    std::vector<uint32_t> sequences;
+    std::vector<StatusSnapshot> lastSent;
+    int64_t lastHeartbeatMs;
+    uint64_t sentCount;
+
+public:
+    SimulatedSenders() : socketHandle(NO_SOCKET), simulator(12345), lastHeartbeatMs(0), sentCount(0) {}
+    ~SimulatedSenders() { if (socketHandle != NO_SOCKET) CloseSocket(socketHandle); }
+
+    bool Start(const std::string& group, int port, size_t count, int64_t nowMs) {
+        sockaddr_in destination = {};
+        destination.sin_family = AF_INET;
+        destination.sin_port = htons(static_cast<uint16_t>(port));
+        if (inet_pton(AF_INET, group.c_str(), &destination.sin_addr) != 1) return false;
+
+        socketHandle = socket(AF_INET, SOCK_DGRAM, 0);
+        if (socketHandle == NO_SOCKET) return false;
+
+        int loop = 1;
+        setsockopt(socketHandle, IPPROTO_IP, IP_MULTICAST_LOOP, reinterpret_cast<const char*>(&loop), sizeof(loop));
+        if (connect(socketHandle, reinterpret_cast<sockaddr*>(&destination), sizeof(destination)) != 0) return false;
+
+        simulator.AddDevices(count, nowMs);
+        sequences.assign(count, 0);
+        lastSent.assign(count, StatusSnapshot());
+        return true;
+    }
+
+    void Step(int64_t nowMs, int64_t heartbeatMs) {
+        simulator.Step(nowMs);
+
+        StatusSnapshot snapshot;
+        simulator.BuildSnapshot(snapshot);
+
+        bool heartbeatDue = nowMs - lastHeartbeatMs >= heartbeatMs;
+        if (heartbeatDue) lastHeartbeatMs = nowMs;
+
+        char datagram[LanStatus::MAX_DATAGRAM];
+        for (size_t i = 0; i < snapshot.size() && i < sequences.size(); i++) {
+            StatusSnapshot single(1, snapshot[i]);
+            single[0].isMonitored = true;
+
+            bool changed = !StatusProtocol::SameState(single, lastSent[i]);
+            if (!changed && !heartbeatDue) continue;
+
+            if (changed) {
+                sequences[i]++;
+                lastSent[i].swap(single);
+            }
+
+            size_t length = LanStatus::Encode(datagram, sizeof(datagram),
+                                              changed ? LanStatus::DATAGRAM_CHANGE : LanStatus::DATAGRAM_HEARTBEAT,
+                                              0x5349000000000000ull + i, sequences[i], "sim-" + std::to_string(i), lastSent[i]);
+            if (length > 0 && send(socketHandle, datagram, static_cast<int>(length), SEND_FLAGS) > 0) {
+                sentCount++;
+            }
+        }
+    }
+
+    uint64_t GetSentCount() const { return sentCount; }
+};
+
+static void PrintReport(const MulticastCollector& collector, int64_t nowMs, size_t detailLimit) {
+    const std::vector<CollectedSender>& senders = collector.GetSenders();
+
+    size_t stale = 0;
+    for (const auto& sender : senders) {
+        if (sender.isStale) stale++;
+    }
+
+    std::cout << "senders=" << senders.size() << " stale=" << stale << " devices=" << collector.GetDeviceCount()
+              << " accepted=" << collector.GetAcceptedCount() << " rejected=" << collector.GetRejectedCount() << std::endl;
+
+    for (size_t i = 0; i < senders.size() && i < detailLimit; i++) {
+        const CollectedSender& sender = senders[i];
+        std::cout << "  " << sender.host << " seq=" << sender.sequence << " age=" << (nowMs - sender.lastSeenMs) << "ms"
+                  << (sender.isStale ? " STALE" : "");
+        for (const auto& device : sender.devices) {
+            std::cout << " [" << device.id << " " << static_cast<int>(device.level) << "%"
+                      << (device.isCharging ? "+" : "") << " " << StatusProtocol::LinkStateName(device.linkState) << "]";
+        }
+        std::cout << std::endl;
+    }
+}
+
+// monka-collector: LISTENS FOR LAN STATUS DATAGRAMS AND PRINTS THE MERGED VENUE INDEX
+int main(int argc, char* argv[]) {
+    MulticastSettings settings = MulticastPublisher::DefaultSettings();
+    size_t simulatedSenders = 0;
+    size_t detailLimit = 10;
+    long durationMs = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--group") == 0 && i + 1 < argc) {
+            settings.group = argv[++i];
+        } else if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            settings.port = static_cast<int>(strtol(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--interface") == 0 && i + 1 < argc) {
+            settings.interfaceAddress = argv[++i];
+        } else if (strcmp(argv[i], "--simulate-senders") == 0 && i + 1 < argc) {
+            long count = strtol(argv[++i], nullptr, 10);
+            simulatedSenders = count > 0 ? static_cast<size_t>(count) : 0;
+        } else if (strcmp(argv[i], "--show") == 0 && i + 1 < argc) {
+            long count = strtol(argv[++i], nullptr, 10);
+            detailLimit = count >= 0 ? static_cast<size_t>(count) : 0;
+        } else if (strcmp(argv[i], "--duration") == 0 && i + 1 < argc) {
+            durationMs = strtol(argv[++i], nullptr, 10) * 1000;
+        } else {
+            std::cerr << "usage: " << argv[0] << " [--group ADDR] [--port PORT] [--interface ADDR]"
+                      << " [--simulate-senders N] [--show N] [--duration SECONDS]" << std::endl;
+            return 2;
+        }
+    }
+
+    MulticastCollector collector;
+    if (!collector.Start(settings.group, settings.port, settings.interfaceAddress)) {
+        std::cerr << "Failed to listen on " << settings.group << ":" << settings.port << std::endl;
+        return 1;
+    }
+
+    // THE COLLECTOR HOLDS A WINSOCK REFERENCE, SO THE SIMULATED SENDERS CAN SHARE IT
+    SimulatedSenders simulation;
+    if (simulatedSenders > 0 && !simulation.Start(settings.group, settings.port, simulatedSenders, SteadyNowMs())) {
+        std::cerr << "Failed to start simulated senders" << std::endl;
+        return 1;
+    }
+
+    std::cout << "Collecting from " << settings.group << ":" << settings.port << std::endl;
+
+    int64_t startMs = SteadyNowMs();
+    int64_t lastReportMs = startMs;
+    while (durationMs <= 0 || SteadyNowMs() - startMs < durationMs) {
+        if (simulatedSenders > 0) {
+            simulation.Step(SteadyNowMs(), settings.heartbeatMs);
+        }
+
+        collector.Poll(50, SteadyNowMs());
+
+        int64_t nowMs = SteadyNowMs();
+        if (nowMs - lastReportMs >= REPORT_INTERVAL_MS) {
+            collector.ExpireSenders(nowMs, SENDER_TIMEOUT_MS, SENDER_EVICT_MS);
+            PrintReport(collector, nowMs, detailLimit);
+            lastReportMs = nowMs;
+        }
+    }
+
+    collector.ExpireSenders(SteadyNowMs(), SENDER_TIMEOUT_MS, SENDER_EVICT_MS);
+    PrintReport(collector, SteadyNowMs(), detailLimit);
+    if (simulatedSenders > 0) {
+        std::cout << "simulated datagrams sent=" << simulation.GetSentCount() << std::endl;
+    }
+    return 0;
+}
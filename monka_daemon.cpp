@@ -0,0 +1,78 @@
+#include "battery_service.h"
+#include "trace_events.h"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+// monka-batteryd: THE HEADLESS SERVICE WITHOUT THE TRAY APP (SIMULATED DEVICES OFF WINDOWS)
+int main(int argc, char* argv[]) {
+    std::string endpoint;
+    size_t simulatedDevices = 1;
+    long reportIntervalMs = 0;
+    bool stats = false;
+    DashboardSettings dashboard = BatteryService::LoadDashboardSettings("Config.ini");
+    MulticastSettings multicast = BatteryService::LoadMulticastSettings("Config.ini");
+    std::string metricsTextfile = BatteryService::LoadMetricsTextfile("Config.ini");
+    std::string tracePath;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc) {
+            endpoint = argv[++i];
+        } else if (strcmp(argv[i], "--devices") == 0 && i + 1 < argc) {
+            long count = strtol(argv[++i], nullptr, 10);
+            simulatedDevices = count > 0 ? static_cast<size_t>(count) : 1;
+        } else if (strcmp(argv[i], "--report-ms") == 0 && i + 1 < argc) {
+            reportIntervalMs = strtol(argv[++i], nullptr, 10);
+            if (reportIntervalMs < 0) reportIntervalMs = 0;
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            stats = true;
+        } else if (strcmp(argv[i], "--http") == 0 && i + 1 < argc) {
+            dashboard.enabled = true;
+            dashboard.port = static_cast<int>(strtol(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--docs") == 0 && i + 1 < argc) {
+            dashboard.documentRoot = argv[++i];
+        } else if (strcmp(argv[i], "--multicast") == 0) {
+            multicast.enabled = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-') multicast.group = argv[++i];
+        } else if (strcmp(argv[i], "--multicast-port") == 0 && i + 1 < argc) {
+            multicast.port = static_cast<int>(strtol(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--multicast-interface") == 0 && i + 1 < argc) {
+            multicast.interfaceAddress = argv[++i];
+        } else if (strcmp(argv[i], "--metrics-file") == 0 && i + 1 < argc) {
+            metricsTextfile = argv[++i];
+        } else if (strcmp(argv[i], "--trace-events") == 0 && i + 1 < argc) {
+            tracePath = argv[++i];
+        } else {
+            std::cerr << "usage: " << argv[0] << " [--socket PATH] [--devices N] [--report-ms MS] [--stats] [--http PORT] [--docs DIR]"
+                      << " [--multicast [GROUP]] [--multicast-port PORT] [--multicast-interface ADDR]"
+                      << " [--metrics-file PATH] [--trace-events FILE]" << std::endl;
+            return 2;
+        }
+    }
+
+    if (!tracePath.empty()) {
+#ifdef MONKA_TRACE
+        if (TraceEvents::Start(tracePath)) {
+            std::cout << "Writing trace events to " << tracePath << std::endl;
+        } else {
+            std::cerr << "Failed to open trace file " << tracePath << std::endl;
+        }
+#else
+        std::cerr << "Ignoring --trace-events: built without MONKA_TRACE (cmake -DMONKA_TRACE=ON)" << std::endl;
+#endif
+    }
+
+    std::cout << "Serving battery status on " << (endpoint.empty() ? StatusServer::DefaultEndpoint() : endpoint) << std::endl;
+    if (dashboard.enabled && BatteryService::StartDashboard(dashboard)) {
+        std::cout << "Dashboard on http://127.0.0.1:" << dashboard.port << "/ (metrics at /metrics)" << std::endl;
+    }
+    if (multicast.enabled && BatteryService::StartMulticast(multicast)) {
+        std::cout << "Broadcasting status to " << multicast.group << ":" << multicast.port << std::endl;
+    }
+    BatteryService::SetMetricsTextfile(metricsTextfile);
+    BatteryService::SetFleetOptions(reportIntervalMs, stats);
+    int result = BatteryService::RunHeadless(endpoint, simulatedDevices);
+
+    TraceEvents::Stop();
+    return result;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+/* SHARED-MEMORY STATUS PAGE. PLAIN C SO WIDGETS IN ANY LANGUAGE CAN MAP IT.
+   ONE 64-BYTE HEADER LINE, THEN ONE 64-BYTE LINE PER DEVICE, EACH GUARDED BY ITS OWN SEQLOCK.
+   READING ONE DEVICE TOUCHES TWO CACHE LINES AND NEVER ENTERS THE KERNEL. */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MONKA_STATUS_MAGIC 0x50534B4Du /* "MKSP" */
+#define MONKA_STATUS_VERSION 1
+#define MONKA_STATUS_CAPACITY 1024
+#define MONKA_STATUS_NAME_SIZE 40
+
+#ifdef _WIN32
+#define MONKA_STATUS_DEFAULT_NAME "Local\\MonkaBatteryStatus"
+#else
+#define MONKA_STATUS_DEFAULT_NAME "/monka-battery-status"
+#endif
+
+typedef struct MonkaStatusHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t headerSize;
+    uint16_t recordSize;
+    uint16_t capacity;
+    volatile uint32_t sequence;     /* ODD WHILE THE DEVICE LIST IS BEING CHANGED */
+    volatile uint32_t deviceCount;
+    uint32_t writerPid;
+    volatile int64_t lastWriteMs;   /* WRITER'S MONOTONIC CLOCK, SAME BASE AS monka_status_now_ms() */
+    uint8_t reserved[32];
+} MonkaStatusHeader;
+
+typedef struct MonkaStatusRecord {
+    volatile uint32_t sequence;     /* ODD WHILE THE RECORD IS BEING WRITTEN */
+    uint32_t deviceId;
+    uint8_t level;
+    uint8_t isCharging;
+    uint8_t isOnline;
+    uint8_t connectionType;         /* 0 WIRED, 1 DONGLE, 2 BLUETOOTH, 3 UNKNOWN */
+    uint8_t linkState;              /* 0 UNKNOWN, 1 ONLINE, 2 SUSPECT, 3 OFFLINE */
+    uint8_t isMonitored;
+    uint16_t voltage;
+    int64_t lastUpdateMs;           /* 0 WHEN NO SAMPLE HAS ARRIVED YET */
+    char name[MONKA_STATUS_NAME_SIZE];
+} MonkaStatusRecord;
+
+typedef struct MonkaStatusPage {
+    MonkaStatusHeader header;
+    MonkaStatusRecord records[MONKA_STATUS_CAPACITY];
+} MonkaStatusPage;
+
+/* READER API (monka_status_reader.c) */
+typedef struct MonkaStatusReader MonkaStatusReader;
+
+MonkaStatusReader* monka_status_open(const char* name);
+void monka_status_close(MonkaStatusReader* reader);
+
+uint32_t monka_status_device_count(const MonkaStatusReader* reader);
+
+/* 1 WHILE THE PROCESS THAT CREATED THE PAGE IS STILL RUNNING. A CRASHED WRITER CAN LEAVE A POSIX SEGMENT BEHIND */
+int monka_status_writer_alive(const MonkaStatusReader* reader);
+
+/* RETURNS 0 ON SUCCESS, -1 WHEN THE INDEX IS OUT OF RANGE */
+int monka_status_read_device(const MonkaStatusReader* reader, uint32_t index, MonkaStatusRecord* out);
+
+/* CONSISTENT COPY OF THE WHOLE DEVICE LIST; RETURNS THE NUMBER OF RECORDS WRITTEN */
+uint32_t monka_status_read_all(const MonkaStatusReader* reader, MonkaStatusRecord* out, uint32_t maxRecords);
+
+int64_t monka_status_now_ms(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,187 @@
+#include "monka_status.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#define MONKA_READ_FENCE() MemoryBarrier()
+#else
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <errno.h>
+#include <unistd.h>
+#include <time.h>
+#define MONKA_READ_FENCE() __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#endif
+
+struct MonkaStatusReader {
+    const MonkaStatusPage* page;
+#ifdef _WIN32
+    HANDLE mapping;
+#else
+    size_t length;
+#endif
+};
+
+static int monka_status_valid(const MonkaStatusPage* page) {
+    return page->header.magic == MONKA_STATUS_MAGIC &&
+           page->header.version == MONKA_STATUS_VERSION &&
+           page->header.headerSize == sizeof(MonkaStatusHeader) &&
+           page->header.recordSize == sizeof(MonkaStatusRecord) &&
+           page->header.capacity <= MONKA_STATUS_CAPACITY;
+}
+
+MonkaStatusReader* monka_status_open(const char* name) {
+    MonkaStatusReader* reader;
+    const void* view;
+
+    if (!name) name = MONKA_STATUS_DEFAULT_NAME;
+
+#ifdef _WIN32
+    HANDLE mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, name);
+    if (!mapping) return NULL;
+
+    view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, sizeof(MonkaStatusPage));
+    if (!view) {
+        CloseHandle(mapping);
+        return NULL;
+    }
+#else
+    char path[256];
+    int fd;
+
+    /* THE WRITER APPENDS ITS UID SO USERS DON'T SHARE A SEGMENT */
+    if (strcmp(name, MONKA_STATUS_DEFAULT_NAME) == 0) {
+        snprintf(path, sizeof(path), "%s-%u", name, (unsigned)getuid());
+        name = path;
+    }
+
+    fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) return NULL;
+
+    view = mmap(NULL, sizeof(MonkaStatusPage), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED) return NULL;
+#endif
+
+    if (!monka_status_valid((const MonkaStatusPage*)view)) {
+#ifdef _WIN32
+        UnmapViewOfFile(view);
+        CloseHandle(mapping);
+#else
+        munmap((void*)view, sizeof(MonkaStatusPage));
+#endif
+        return NULL;
+    }
+
+    reader = (MonkaStatusReader*)calloc(1, sizeof(MonkaStatusReader));
+    if (!reader) return NULL;
+
+    reader->page = (const MonkaStatusPage*)view;
+#ifdef _WIN32
+    reader->mapping = mapping;
+#else
+    reader->length = sizeof(MonkaStatusPage);
+#endif
+    return reader;
+}
+
+void monka_status_close(MonkaStatusReader* reader) {
+    if (!reader) return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(reader->page);
+    CloseHandle(reader->mapping);
+#else
+    munmap((void*)reader->page, reader->length);
+#endif
+    free(reader);
+}
+
+uint32_t monka_status_device_count(const MonkaStatusReader* reader) {
+    uint32_t count = reader->page->header.deviceCount;
+    return count <= reader->page->header.capacity ? count : reader->page->header.capacity;
+}
+
+int monka_status_writer_alive(const MonkaStatusReader* reader) {
+    uint32_t pid = reader->page->header.writerPid;
+#ifdef _WIN32
+    HANDLE process;
+    DWORD wait;
+
+    process = OpenProcess(SYNCHRONIZE, FALSE, pid);
+    if (!process) return GetLastError() == ERROR_ACCESS_DENIED;
+
+    wait = WaitForSingleObject(process, 0);
+    CloseHandle(process);
+    return wait == WAIT_TIMEOUT;
+#else
+    if (pid == 0) return 0;
+    return kill((pid_t)pid, 0) == 0 || errno == EPERM;
+#endif
+}
+
+static void monka_status_copy_record(const MonkaStatusRecord* record, MonkaStatusRecord* out) {
+    uint32_t before;
+    uint32_t after;
+
+    do {
+        before = record->sequence;
+        MONKA_READ_FENCE();
+        memcpy(out, (const void*)record, sizeof(MonkaStatusRecord));
+        MONKA_READ_FENCE();
+        after = record->sequence;
+    } while ((before & 1u) || before != after);
+
+    out->sequence = before;
+    out->name[MONKA_STATUS_NAME_SIZE - 1] = '\0';
+}
+
+int monka_status_read_device(const MonkaStatusReader* reader, uint32_t index, MonkaStatusRecord* out) {
+    if (index >= monka_status_device_count(reader)) return -1;
+
+    monka_status_copy_record(&reader->page->records[index], out);
+    return 0;
+}
+
+uint32_t monka_status_read_all(const MonkaStatusReader* reader, MonkaStatusRecord* out, uint32_t maxRecords) {
+    const MonkaStatusHeader* header = &reader->page->header;
+    uint32_t before;
+    uint32_t after;
+    uint32_t count;
+    uint32_t i;
+
+    do {
+        before = header->sequence;
+        MONKA_READ_FENCE();
+
+        count = monka_status_device_count(reader);
+        if (count > maxRecords) count = maxRecords;
+        for (i = 0; i < count; i++) {
+            monka_status_copy_record(&reader->page->records[i], &out[i]);
+        }
+
+        MONKA_READ_FENCE();
+        after = header->sequence;
+    } while ((before & 1u) || before != after);
+
+    return count;
+}
+
+int64_t monka_status_now_ms(void) {
+#ifdef _WIN32
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+
+    if (frequency.QuadPart == 0) QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (int64_t)(counter.QuadPart / frequency.QuadPart * 1000 +
+                     counter.QuadPart % frequency.QuadPart * 1000 / frequency.QuadPart);
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+#endif
+}
@@ -117,6 +117,9 @@ void MouseItemRenderer::RenderMouseItem(Graphics* g, const MouseItem& item, int
         batteryColor = Color(255, 128, 128, 128);
         displayLevel = 0; 
         displayCharging = false;
+    } else if (item.isStale) {
+        Color levelColor = Colors::GetBatteryColor(item.batteryLevel);
+        batteryColor = Color(140, levelColor.GetR(), levelColor.GetG(), levelColor.GetB());
     } else {
         batteryColor = Colors::GetBatteryColor(item.batteryLevel);
     }
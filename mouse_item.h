@@ -12,17 +12,15 @@ using namespace Gdiplus;
 
 struct ConnectionInfo {
     ConnectionType type;
-    std::string devicePath;
+    DeviceId deviceId;
     bool isOnline;
     int batteryLevel;
     bool isCharging;
-    std::string vid;
-    std::string pid;
 
-    ConnectionInfo(ConnectionType type, const std::string& devicePath, bool isOnline = true,
-                   int batteryLevel = 0, bool isCharging = false, const std::string& vid = "", const std::string& pid = "")
-        : type(type), devicePath(devicePath), isOnline(isOnline), batteryLevel(batteryLevel),
-          isCharging(isCharging), vid(vid), pid(pid) {}
+    ConnectionInfo(ConnectionType type, DeviceId deviceId, bool isOnline = true,
+                   int batteryLevel = 0, bool isCharging = false)
+        : type(type), deviceId(deviceId), isOnline(isOnline), batteryLevel(batteryLevel),
+          isCharging(isCharging) {}
 };
 
 struct MouseItem {
@@ -35,14 +33,15 @@ struct MouseItem {
     float hoverProgress;
     bool isOnline; 
     bool isUpdating; 
+    bool isStale;
 
     std::vector<ConnectionInfo> connections;
 
     MouseItem(const std::wstring& name, const std::wstring& imagePath, int batteryLevel, bool isCharging = false, Color mouseColor = Color(255, 255, 255, 255), bool isHovered = false, bool isOnline = true)
-        : name(name), imagePath(imagePath), batteryLevel(batteryLevel), isCharging(isCharging), mouseColor(mouseColor), isHovered(isHovered), hoverProgress(0.0f), isOnline(isOnline), isUpdating(false) {}
+        : name(name), imagePath(imagePath), batteryLevel(batteryLevel), isCharging(isCharging), mouseColor(mouseColor), isHovered(isHovered), hoverProgress(0.0f), isOnline(isOnline), isUpdating(false), isStale(false) {}
 
     MouseItem(const std::wstring& name, const std::wstring& imagePath, const std::vector<ConnectionInfo>& connections)
-        : name(name), imagePath(imagePath), connections(connections), isHovered(false), hoverProgress(0.0f), isUpdating(false) {
+        : name(name), imagePath(imagePath), connections(connections), isHovered(false), hoverProgress(0.0f), isUpdating(false), isStale(false) {
         UpdateStatusFromConnections();
     }
 
@@ -0,0 +1,184 @@
+#include "net_socket.h"
+#include "multicast_collector.h"
+#include "lan_status.h"
+
+static SocketHandle ToSocket(intptr_t handle) { return static_cast<SocketHandle>(handle); }
+
+MulticastCollector::MulticastCollector()
+    : socketHandle(static_cast<intptr_t>(NO_SOCKET)), running(false), receiveBuffer(LanStatus::MAX_DATAGRAM + 1),
+      acceptedCount(0), rejectedCount(0) {
+}
+
+MulticastCollector::~MulticastCollector() {
+    Stop();
+}
+
+bool MulticastCollector::Start(const std::string& group, int port, const std::string& interfaceAddress) {
+    if (running) return true;
+
+    if (!InitSockets()) {
+        return false;
+    }
+
+    in_addr groupAddress = {};
+    in_addr localAddress = {};
+    localAddress.s_addr = htonl(INADDR_ANY);
+    if (inet_pton(AF_INET, group.c_str(), &groupAddress) != 1 ||
+        (!interfaceAddress.empty() && inet_pton(AF_INET, interfaceAddress.c_str(), &localAddress) != 1)) {
+        CleanupSockets();
+        return false;
+    }
+
+    SocketHandle receiver = socket(AF_INET, SOCK_DGRAM, 0);
+    if (receiver == NO_SOCKET) {
+        CleanupSockets();
+        return false;
+    }
+
+    // SEVERAL COLLECTORS ON ONE MACHINE MAY LISTEN TO THE SAME GROUP
+    int reuse = 1;
+    setsockopt(receiver, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+#ifdef SO_REUSEPORT
+    setsockopt(receiver, SOL_SOCKET, SO_REUSEPORT, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+#endif
+
+    // A VENUE OF SENDERS CAN BURST; GIVE THE KERNEL ROOM TO HOLD THEM BETWEEN POLLS
+    int receiveBufferSize = 4 * 1024 * 1024;
+    setsockopt(receiver, SOL_SOCKET, SO_RCVBUF, reinterpret_cast<const char*>(&receiveBufferSize), sizeof(receiveBufferSize));
+
+    bool isMulticast = (ntohl(groupAddress.s_addr) & 0xF0000000u) == 0xE0000000u;
+
+    sockaddr_in bindAddress = {};
+    bindAddress.sin_family = AF_INET;
+    bindAddress.sin_port = htons(static_cast<uint16_t>(port));
+    bindAddress.sin_addr = groupAddress;
+    if (isMulticast) bindAddress.sin_addr.s_addr = htonl(INADDR_ANY);
+
+    bool ok = bind(receiver, reinterpret_cast<sockaddr*>(&bindAddress), sizeof(bindAddress)) == 0;
+    if (ok && isMulticast) {
+        ip_mreq membership = {};
+        membership.imr_multiaddr = groupAddress;
+        membership.imr_interface = localAddress;
+        ok = setsockopt(receiver, IPPROTO_IP, IP_ADD_MEMBERSHIP, reinterpret_cast<const char*>(&membership), sizeof(membership)) == 0;
+    }
+
+    if (!ok) {
+        CloseSocket(receiver);
+        CleanupSockets();
+        return false;
+    }
+
+    SetNonBlocking(receiver);
+    socketHandle = static_cast<intptr_t>(receiver);
+    running = true;
+    return true;
+}
+
+void MulticastCollector::Stop() {
+    if (!running) return;
+
+    CloseSocket(ToSocket(socketHandle));
+    socketHandle = static_cast<intptr_t>(NO_SOCKET);
+    running = false;
+    CleanupSockets();
+}
+
+size_t MulticastCollector::Poll(int timeoutMs, int64_t nowMs) {
+    if (!running) return 0;
+
+    pollfd descriptor = { ToSocket(socketHandle), POLLIN, 0 };
+    if (PollSockets(&descriptor, 1, timeoutMs) <= 0) {
+        return 0;
+    }
+
+    size_t merged = 0;
+    while (true) {
+        int received = static_cast<int>(recv(ToSocket(socketHandle), receiveBuffer.data(), static_cast<int>(receiveBuffer.size()), 0));
+        if (received < 0) break;
+
+        if (Ingest(receiveBuffer.data(), static_cast<size_t>(received), nowMs)) {
+            merged++;
+        }
+    }
+    return merged;
+}
+
+bool MulticastCollector::Ingest(const char* data, size_t length, int64_t nowMs) {
+    LanStatus::Datagram datagram;
+    if (!LanStatus::Decode(data, length, datagram)) {
+        rejectedCount++;
+        return false;
+    }
+
+    auto it = senderIndex.find(datagram.senderId);
+    if (it == senderIndex.end()) {
+        it = senderIndex.emplace(datagram.senderId, senders.size()).first;
+
+        CollectedSender sender;
+        sender.senderId = datagram.senderId;
+        sender.sequence = 0;
+        sender.lastSeenMs = 0;
+        sender.isStale = false;
+        senders.push_back(sender);
+    }
+
+    CollectedSender& sender = senders[it->second];
+
+    // UDP REORDERS: NEVER LET AN OLDER CHANGE OVERWRITE A NEWER ONE. HEARTBEATS REPEAT THE CURRENT SEQUENCE
+    if (sender.lastSeenMs != 0 && datagram.sequence < sender.sequence) {
+        rejectedCount++;
+        return false;
+    }
+
+    sender.lastSeenMs = nowMs;
+    sender.isStale = false;
+    if (datagram.sequence != sender.sequence || sender.devices.empty()) {
+        sender.sequence = datagram.sequence;
+        sender.host.swap(datagram.host);
+        sender.devices.swap(datagram.devices);
+        for (auto& device : sender.devices) {
+            device.lastUpdateMs = nowMs;
+        }
+    }
+
+    acceptedCount++;
+    return true;
+}
+
+size_t MulticastCollector::ExpireSenders(int64_t nowMs, int64_t staleMs, int64_t evictMs) {
+    size_t stale = 0;
+    size_t i = 0;
+    while (i < senders.size()) {
+        CollectedSender& sender = senders[i];
+        int64_t silentMs = nowMs - sender.lastSeenMs;
+
+        // SWAP-AND-POP: THE LAST SENDER TAKES THIS SLOT, SO ITS INDEX ENTRY MOVES WITH IT
+        if (silentMs > evictMs) {
+            senderIndex.erase(sender.senderId);
+            if (i + 1 != senders.size()) {
+                sender = std::move(senders.back());
+                senderIndex[sender.senderId] = i;
+            }
+            senders.pop_back();
+            continue;
+        }
+
+        sender.isStale = silentMs > staleMs;
+        if (sender.isStale) stale++;
+        i++;
+    }
+    return stale;
+}
+
+const CollectedSender* MulticastCollector::FindSender(uint64_t senderId) const {
+    auto it = senderIndex.find(senderId);
+    return it != senderIndex.end() ? &senders[it->second] : nullptr;
+}
+
+size_t MulticastCollector::GetDeviceCount() const {
+    size_t count = 0;
+    for (const auto& sender : senders) {
+        count += sender.devices.size();
+    }
+    return count;
+}
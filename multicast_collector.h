@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "status_protocol.h"
+
+struct CollectedSender {
+    uint64_t senderId;
+    std::string host;
+    uint32_t sequence;
+    int64_t lastSeenMs;
+    bool isStale;
+    StatusSnapshot devices;
+};
+
+// MERGES LanStatus DATAGRAMS FROM ANY NUMBER OF SENDERS INTO ONE INDEX. NO THREAD OF ITS OWN: CALL Poll
+class MulticastCollector {
+private:
+    intptr_t socketHandle;
+    bool running;
+
+    std::unordered_map<uint64_t, size_t> senderIndex;
+    std::vector<CollectedSender> senders;
+    std::vector<char> receiveBuffer;
+
+    uint64_t acceptedCount;
+    uint64_t rejectedCount;
+
+public:
+    MulticastCollector();
+    ~MulticastCollector();
+
+    bool Start(const std::string& group, int port, const std::string& interfaceAddress);
+    void Stop();
+    bool IsRunning() const { return running; }
+
+    // WAITS UP TO timeoutMs FOR TRAFFIC, THEN DRAINS EVERYTHING QUEUED. RETURNS DATAGRAMS MERGED
+    size_t Poll(int timeoutMs, int64_t nowMs);
+    bool Ingest(const char* data, size_t length, int64_t nowMs);
+    // SILENT FOR staleMs: FLAGGED STALE. SILENT FOR evictMs: DROPPED. RETURNS SENDERS LEFT STALE
+    size_t ExpireSenders(int64_t nowMs, int64_t staleMs, int64_t evictMs);
+
+    const std::vector<CollectedSender>& GetSenders() const { return senders; }
+    const CollectedSender* FindSender(uint64_t senderId) const;
+    size_t GetDeviceCount() const;
+    uint64_t GetAcceptedCount() const { return acceptedCount; }
+    uint64_t GetRejectedCount() const { return rejectedCount; }
+
+private:
+    MulticastCollector(const MulticastCollector&);
+    MulticastCollector& operator=(const MulticastCollector&);
+};
@@ -0,0 +1,133 @@
+#include "net_socket.h"
+#include "multicast_publisher.h"
+#include "lan_status.h"
+#include "trace_events.h"
+#include <random>
+
+static SocketHandle ToSocket(intptr_t handle) { return static_cast<SocketHandle>(handle); }
+
+static bool IsMulticastAddress(const in_addr& address) {
+    return (ntohl(address.s_addr) & 0xF0000000u) == 0xE0000000u;
+}
+
+static std::string LocalHostName() {
+    char name[256] = {};
+    if (gethostname(name, sizeof(name) - 1) != 0) {
+        return "unknown";
+    }
+    return name;
+}
+
+MulticastPublisher::MulticastPublisher()
+    : socketHandle(static_cast<intptr_t>(NO_SOCKET)), running(false), senderId(0), sequence(0),
+      heartbeatMs(5000), lastSendMs(0), sentCount(0) {
+}
+
+MulticastPublisher::~MulticastPublisher() {
+    Stop();
+}
+
+MulticastSettings MulticastPublisher::DefaultSettings() {
+    MulticastSettings settings = { false, "239.255.77.77", 27777, 1, "", 5000 };
+    return settings;
+}
+
+bool MulticastPublisher::Start(const MulticastSettings& settings) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (running) return true;
+
+    if (!InitSockets()) {
+        return false;
+    }
+
+    sockaddr_in destination = {};
+    destination.sin_family = AF_INET;
+    destination.sin_port = htons(static_cast<uint16_t>(settings.port));
+    if (inet_pton(AF_INET, settings.group.c_str(), &destination.sin_addr) != 1) {
+        CleanupSockets();
+        return false;
+    }
+
+    SocketHandle sender = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sender == NO_SOCKET) {
+        CleanupSockets();
+        return false;
+    }
+
+    bool ok = true;
+    if (IsMulticastAddress(destination.sin_addr)) {
+        int ttl = settings.ttl > 0 ? settings.ttl : 1;
+        int loop = 1;
+        ok = setsockopt(sender, IPPROTO_IP, IP_MULTICAST_TTL, reinterpret_cast<const char*>(&ttl), sizeof(ttl)) == 0 &&
+             setsockopt(sender, IPPROTO_IP, IP_MULTICAST_LOOP, reinterpret_cast<const char*>(&loop), sizeof(loop)) == 0;
+
+        in_addr outgoing = {};
+        if (ok && !settings.interfaceAddress.empty() && inet_pton(AF_INET, settings.interfaceAddress.c_str(), &outgoing) == 1) {
+            ok = setsockopt(sender, IPPROTO_IP, IP_MULTICAST_IF, reinterpret_cast<const char*>(&outgoing), sizeof(outgoing)) == 0;
+        }
+    }
+
+    if (!ok || connect(sender, reinterpret_cast<sockaddr*>(&destination), sizeof(destination)) != 0) {
+        CloseSocket(sender);
+        CleanupSockets();
+        return false;
+    }
+    SetNonBlocking(sender);
+
+    // A FRESH ID PER RUN: COLLECTORS TREAT A RESTARTED MACHINE AS A NEW SENDER, NOT A SEQUENCE REWIND
+    std::random_device entropy;
+    senderId = (static_cast<uint64_t>(entropy()) << 32) ^ entropy() ^ static_cast<uint64_t>(SteadyNowMs());
+
+    socketHandle = static_cast<intptr_t>(sender);
+    host = LocalHostName();
+    heartbeatMs = settings.heartbeatMs > 0 ? settings.heartbeatMs : 5000;
+    sequence = 0;
+    lastSendMs = 0;
+    lastSnapshot.clear();
+    running = true;
+    return true;
+}
+
+void MulticastPublisher::Stop() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!running) return;
+
+    CloseSocket(ToSocket(socketHandle));
+    socketHandle = static_cast<intptr_t>(NO_SOCKET);
+    running = false;
+    CleanupSockets();
+}
+
+void MulticastPublisher::SendLocked(uint8_t type, int64_t nowMs) {
+    char datagram[LanStatus::MAX_DATAGRAM];
+    size_t length = LanStatus::Encode(datagram, sizeof(datagram), static_cast<LanStatus::DatagramType>(type),
+                                      senderId, sequence, host, lastSnapshot);
+    if (length == 0) return;
+
+    // A FULL SEND BUFFER JUST LOSES THIS DATAGRAM; THE NEXT HEARTBEAT CARRIES THE SAME STATE
+    if (send(ToSocket(socketHandle), datagram, static_cast<int>(length), SEND_FLAGS) > 0) {
+        sentCount++;
+    }
+    lastSendMs = nowMs;
+}
+
+void MulticastPublisher::Publish(const StatusSnapshot& snapshot, int64_t nowMs) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!running) return;
+
+    if (StatusProtocol::SameState(snapshot, lastSnapshot) && sequence != 0) {
+        return;
+    }
+
+    TRACE_SCOPE("MulticastPublisher::Publish", "ipc");
+    lastSnapshot = snapshot;
+    sequence++;
+    SendLocked(LanStatus::DATAGRAM_CHANGE, nowMs);
+}
+
+void MulticastPublisher::Tick(int64_t nowMs) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!running || sequence == 0 || nowMs - lastSendMs < heartbeatMs) return;
+
+    SendLocked(LanStatus::DATAGRAM_HEARTBEAT, nowMs);
+}
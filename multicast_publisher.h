@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include "status_protocol.h"
+
+struct MulticastSettings {
+    bool enabled;
+    std::string group;
+    int port;
+    int ttl;
+    std::string interfaceAddress;
+    int64_t heartbeatMs;
+};
+
+// OPT-IN LAN BROADCAST: ONE DATAGRAM PER REAL CHANGE, THE SAME STATE AGAIN EVERY heartbeatMs.
+// A NON-MULTICAST GROUP ADDRESS (E.G. 127.0.0.1) SENDS UNICAST, WHICH IS HOW LOOPBACK TESTS RUN
+class MulticastPublisher {
+private:
+    std::mutex mutex;
+    intptr_t socketHandle;
+    bool running;
+
+    uint64_t senderId;
+    uint32_t sequence;
+    std::string host;
+    int64_t heartbeatMs;
+    int64_t lastSendMs;
+    StatusSnapshot lastSnapshot;
+    uint64_t sentCount;
+
+    void SendLocked(uint8_t type, int64_t nowMs);
+
+public:
+    MulticastPublisher();
+    ~MulticastPublisher();
+
+    bool Start(const MulticastSettings& settings);
+    void Stop();
+    bool IsRunning() const { return running; }
+
+    void Publish(const StatusSnapshot& snapshot, int64_t nowMs);
+    void Tick(int64_t nowMs);
+
+    uint64_t GetSenderId() const { return senderId; }
+    uint64_t GetSentCount() const { return sentCount; }
+
+    static MulticastSettings DefaultSettings();
+
+private:
+    MulticastPublisher(const MulticastPublisher&);
+    MulticastPublisher& operator=(const MulticastPublisher&);
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+// THIN SOCKET PORTABILITY LAYER. INCLUDE BEFORE ANYTHING THAT PULLS IN windows.h
+#include <cstddef>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+
+typedef SOCKET SocketHandle;
+const SocketHandle NO_SOCKET = INVALID_SOCKET;
+const int SEND_FLAGS = 0;
+
+inline bool InitSockets() {
+    WSADATA wsaData;
+    return WSAStartup(MAKEWORD(2, 2), &wsaData) == 0;
+}
+
+inline void CleanupSockets() { WSACleanup(); }
+inline void CloseSocket(SocketHandle socket) { closesocket(socket); }
+inline bool WouldBlock() { return WSAGetLastError() == WSAEWOULDBLOCK; }
+inline int PollSockets(pollfd* fds, size_t count, int timeoutMs) { return WSAPoll(fds, static_cast<ULONG>(count), timeoutMs); }
+
+inline void SetNonBlocking(SocketHandle socket) {
+    u_long mode = 1;
+    ioctlsocket(socket, FIONBIO, &mode);
+}
+#else
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+typedef int SocketHandle;
+const SocketHandle NO_SOCKET = -1;
+const int SEND_FLAGS = MSG_NOSIGNAL;
+
+inline bool InitSockets() { return true; }
+inline void CleanupSockets() {}
+inline void CloseSocket(SocketHandle socket) { close(socket); }
+inline bool WouldBlock() { return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR; }
+inline int PollSockets(pollfd* fds, size_t count, int timeoutMs) { return poll(fds, count, timeoutMs); }
+
+inline void SetNonBlocking(SocketHandle socket) {
+    fcntl(socket, F_SETFL, fcntl(socket, F_GETFL, 0) | O_NONBLOCK);
+    fcntl(socket, F_SETFD, FD_CLOEXEC);
+}
+#endif
@@ -0,0 +1,50 @@
+#include "process_metrics.h"
+#include <atomic>
+#include <mutex>
+
+static std::atomic<uint64_t> counters[static_cast<int>(ProcessCounter::COUNT)];
+static std::atomic<uint64_t> version{0};
+
+static std::mutex paintMutex;
+static LatencyHistogram paintHistogram;
+
+void ProcessMetrics::Increment(ProcessCounter counter) {
+    counters[static_cast<int>(counter)].fetch_add(1, std::memory_order_relaxed);
+    version.fetch_add(1, std::memory_order_release);
+}
+
+void ProcessMetrics::RecordPaintUs(uint64_t durationUs) {
+    {
+        std::lock_guard<std::mutex> lock(paintMutex);
+        paintHistogram.Record(durationUs);
+    }
+    version.fetch_add(1, std::memory_order_release);
+}
+
+uint64_t ProcessMetrics::Get(ProcessCounter counter) {
+    return counters[static_cast<int>(counter)].load(std::memory_order_relaxed);
+}
+
+void ProcessMetrics::GetPaintHistogram(LatencyHistogram& histogram) {
+    std::lock_guard<std::mutex> lock(paintMutex);
+    histogram = paintHistogram;
+}
+
+uint64_t ProcessMetrics::GetVersion() {
+    return version.load(std::memory_order_acquire);
+}
+
+const char* ProcessMetrics::GetCounterName(ProcessCounter counter) {
+    switch (counter) {
+        case ProcessCounter::ICON_RENDERS: return "icon_renders";
+        case ProcessCounter::TRAY_ICON_REUSED: return "tray_icon_reused";
+        case ProcessCounter::FONT_CACHE_HITS: return "font_cache_hits";
+        case ProcessCounter::FONT_CACHE_MISSES: return "font_cache_misses";
+        case ProcessCounter::TIMER_ANIMATION: return "animation";
+        case ProcessCounter::TIMER_BATTERY: return "battery";
+        case ProcessCounter::TIMER_TRAY: return "tray";
+        case ProcessCounter::TIMER_HEARTBEAT: return "heartbeat";
+        case ProcessCounter::TIMER_HEADLESS: return "headless";
+        default: return "unknown";
+    }
+}
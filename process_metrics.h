@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include "latency_histogram.h"
+
+enum class ProcessCounter : uint8_t {
+    ICON_RENDERS,
+    TRAY_ICON_REUSED,
+    FONT_CACHE_HITS,
+    FONT_CACHE_MISSES,
+    TIMER_ANIMATION,
+    TIMER_BATTERY,
+    TIMER_TRAY,
+    TIMER_HEARTBEAT,
+    TIMER_HEADLESS,
+    COUNT
+};
+
+// LOCK-FREE PROCESS COUNTERS FOR THE METRICS EXPORTER. GetVersion CHANGES WHENEVER ANY VALUE DOES,
+// SO THE EXPORTER CAN SKIP RE-RENDERING WHEN NOTHING MOVED
+class ProcessMetrics {
+public:
+    static void Increment(ProcessCounter counter);
+    static void RecordPaintUs(uint64_t durationUs);
+
+    static uint64_t Get(ProcessCounter counter);
+    static void GetPaintHistogram(LatencyHistogram& histogram);
+    static uint64_t GetVersion();
+
+    static const char* GetCounterName(ProcessCounter counter);
+};
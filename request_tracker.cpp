@@ -0,0 +1,117 @@
+#include "request_tracker.h"
+
+void RequestTracker::EnsureDevice(DeviceId deviceId) {
+    if (deviceId < inFlight.size()) return;
+
+    size_t size = static_cast<size_t>(deviceId) + 1;
+    DeviceRequests empty = {};
+
+    nextSequence.resize(size, 1);
+    inFlight.resize(size, empty);
+    sentCount.resize(size, 0);
+    repliedCount.resize(size, 0);
+    timedOutCount.resize(size, 0);
+    rttHistograms.resize(size);
+}
+
+void RequestTracker::ExpireDevice(DeviceId deviceId, int64_t nowMs) {
+    DeviceRequests& requests = inFlight[deviceId];
+
+    while (requests.count > 0 && requests.pending[requests.head].deadlineMs <= nowMs) {
+        requests.head = static_cast<uint8_t>((requests.head + 1) % MAX_IN_FLIGHT);
+        requests.count--;
+        timedOutCount[deviceId]++;
+    }
+}
+
+uint32_t RequestTracker::OnRequestSent(DeviceId deviceId, int64_t nowMs) {
+    std::lock_guard<std::mutex> lock(mutex);
+    EnsureDevice(deviceId);
+    ExpireDevice(deviceId, nowMs);
+
+    DeviceRequests& requests = inFlight[deviceId];
+    if (requests.count == MAX_IN_FLIGHT) {
+        requests.head = static_cast<uint8_t>((requests.head + 1) % MAX_IN_FLIGHT);
+        requests.count--;
+        timedOutCount[deviceId]++;
+    }
+
+    uint32_t sequence = nextSequence[deviceId]++;
+    int slot = (requests.head + requests.count) % MAX_IN_FLIGHT;
+    requests.pending[slot].sequence = sequence;
+    requests.pending[slot].sentMs = nowMs;
+    requests.pending[slot].deadlineMs = nowMs + timeoutMs;
+    requests.count++;
+
+    sentCount[deviceId]++;
+    return sequence;
+}
+
+bool RequestTracker::OnReply(DeviceId deviceId, int64_t nowMs, int64_t* rttMs) {
+    std::lock_guard<std::mutex> lock(mutex);
+    EnsureDevice(deviceId);
+    ExpireDevice(deviceId, nowMs);
+
+    DeviceRequests& requests = inFlight[deviceId];
+    if (requests.count == 0) {
+        return false;
+    }
+
+    const InFlightRequest& request = requests.pending[requests.head];
+    int64_t rtt = nowMs - request.sentMs;
+    if (rtt < 0) rtt = 0;
+
+    requests.head = static_cast<uint8_t>((requests.head + 1) % MAX_IN_FLIGHT);
+    requests.count--;
+
+    repliedCount[deviceId]++;
+    rttHistograms[deviceId].Record(static_cast<uint64_t>(rtt));
+
+    if (rttMs) *rttMs = rtt;
+    return true;
+}
+
+uint32_t RequestTracker::ExpireRequests(int64_t nowMs) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    uint32_t before = 0;
+    uint32_t after = 0;
+    for (DeviceId id = 0; id < inFlight.size(); id++) {
+        before += timedOutCount[id];
+        ExpireDevice(id, nowMs);
+        after += timedOutCount[id];
+    }
+    return after - before;
+}
+
+RequestStats RequestTracker::GetStats(DeviceId deviceId) const {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    RequestStats stats = {};
+    if (deviceId >= inFlight.size()) {
+        return stats;
+    }
+
+    const LatencyHistogram& histogram = rttHistograms[deviceId];
+    stats.sent = sentCount[deviceId];
+    stats.replied = repliedCount[deviceId];
+    stats.timedOut = timedOutCount[deviceId];
+    stats.inFlight = inFlight[deviceId].count;
+    stats.p50Ms = histogram.ValueAtPercentile(50.0);
+    stats.p90Ms = histogram.ValueAtPercentile(90.0);
+    stats.p99Ms = histogram.ValueAtPercentile(99.0);
+    stats.maxMs = histogram.GetMax();
+    stats.sumMs = histogram.GetSum();
+    return stats;
+}
+
+void RequestTracker::Clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    nextSequence.clear();
+    inFlight.clear();
+    sentCount.clear();
+    repliedCount.clear();
+    timedOutCount.clear();
+    rttHistograms.clear();
+}
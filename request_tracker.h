@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <mutex>
+#include "device_registry.h"
+#include "latency_histogram.h"
+
+struct RequestStats {
+    uint32_t sent;
+    uint32_t replied;
+    uint32_t timedOut;
+    uint32_t inFlight;
+    uint64_t p50Ms;
+    uint64_t p90Ms;
+    uint64_t p99Ms;
+    uint64_t maxMs;
+    uint64_t sumMs;
+};
+
+class RequestTracker {
+private:
+    static const int MAX_IN_FLIGHT = 4;
+
+    struct InFlightRequest {
+        uint32_t sequence;
+        int64_t sentMs;
+        int64_t deadlineMs;
+    };
+
+    struct DeviceRequests {
+        InFlightRequest pending[MAX_IN_FLIGHT];
+        uint8_t head;
+        uint8_t count;
+    };
+
+    mutable std::mutex mutex;
+    int64_t timeoutMs;
+
+    std::vector<uint32_t> nextSequence;
+    std::vector<DeviceRequests> inFlight;
+    std::vector<uint32_t> sentCount;
+    std::vector<uint32_t> repliedCount;
+    std::vector<uint32_t> timedOutCount;
+    std::vector<LatencyHistogram> rttHistograms;
+
+    void EnsureDevice(DeviceId deviceId);
+    void ExpireDevice(DeviceId deviceId, int64_t nowMs);
+
+public:
+    RequestTracker() : timeoutMs(2000) {}
+
+    void SetTimeoutMs(int64_t timeout) { timeoutMs = timeout; }
+    int64_t GetTimeoutMs() const { return timeoutMs; }
+
+    uint32_t OnRequestSent(DeviceId deviceId, int64_t nowMs);
+    bool OnReply(DeviceId deviceId, int64_t nowMs, int64_t* rttMs);
+    uint32_t ExpireRequests(int64_t nowMs);
+
+    RequestStats GetStats(DeviceId deviceId) const;
+    void Clear();
+};
@@ -1,5 +1,6 @@
 #include "resource_loader.h"
 #include "resource.h"
+#include "trace_events.h"
 #include <shlwapi.h>
 #include <fstream>
 
@@ -8,6 +9,7 @@
 using namespace Gdiplus;
 
 Bitmap* ResourceLoader::LoadPNGFromResource(int resourceId) {
+    TRACE_SCOPE("ResourceLoader::LoadPNGFromResource", "png");
     HRSRC hResource = FindResource(GetModuleHandle(NULL), MAKEINTRESOURCE(resourceId), RT_RCDATA);
     if (!hResource) return nullptr;
 
@@ -23,6 +25,7 @@ Bitmap* ResourceLoader::LoadPNGFromResource(int resourceId) {
 }
 
 Bitmap* ResourceLoader::LoadPNGAsBitmap(const std::string& pngPath) {
+    TRACE_SCOPE("ResourceLoader::LoadPNGAsBitmap", "png");
     int resourceId = GetResourceIdFromPath(pngPath);
     if (resourceId != -1) {
         Bitmap* bitmap = LoadPNGFromResource(resourceId);
@@ -0,0 +1,274 @@
+#include "settings_store.h"
+#include "config_writer.h"
+#include "trace_events.h"
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct PendingEdit {
+    std::string section;
+    std::string key;
+    std::string value;
+    bool remove;
+};
+
+struct SettingsStore::Impl {
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable written;
+    std::thread thread;
+    bool running = false;
+    bool stopping = false;
+    bool flushRequested = false;
+
+    std::string path;
+    std::string defaults;
+    std::chrono::milliseconds quiet{ DEFAULT_QUIET_MS };
+    std::chrono::steady_clock::time_point lastEdit;
+
+    std::shared_ptr<const ConfigFile> base = std::make_shared<ConfigFile>();
+    std::vector<PendingEdit> dirty;
+    std::vector<PendingEdit> inFlight;   // TAKEN BY THE WRITER, STILL VISIBLE TO Get UNTIL THEY ARE ON DISK
+
+    uint64_t editSequence = 0;
+    uint64_t attemptedSequence = 0;
+    uint64_t committedSequence = 0;
+    uint64_t commitCount = 0;
+    uint64_t attemptCount = 0;
+
+    ~Impl() {
+        // A MISSED Stop STILL JOINS RATHER THAN TERMINATING AT EXIT
+        if (thread.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            wake.notify_one();
+            thread.join();
+        }
+    }
+
+    void Record(std::string_view section, std::string_view key, std::string_view value, bool remove);
+    const PendingEdit* FindPending(std::string_view section, std::string_view key);
+    void CommitLocked(std::unique_lock<std::mutex>& lock);
+    void Loop();
+};
+
+static PendingEdit* FindEdit(std::vector<PendingEdit>& edits, std::string_view section, std::string_view key) {
+    for (auto& edit : edits) {
+        if (edit.section == section && edit.key == key) return &edit;
+    }
+    return nullptr;
+}
+
+void SettingsStore::Impl::Record(std::string_view section, std::string_view key, std::string_view value, bool remove) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        PendingEdit* edit = FindEdit(dirty, section, key);
+        if (!edit) {
+            dirty.push_back(PendingEdit{ std::string(section), std::string(key), std::string(), false });
+            edit = &dirty.back();
+        }
+        edit->value.assign(value.data(), value.size());
+        edit->remove = remove;
+
+        editSequence++;
+        lastEdit = std::chrono::steady_clock::now();
+    }
+    wake.notify_one();
+}
+
+const PendingEdit* SettingsStore::Impl::FindPending(std::string_view section, std::string_view key) {
+    const PendingEdit* edit = FindEdit(dirty, section, key);
+    return edit ? edit : FindEdit(inFlight, section, key);
+}
+
+// CALLED WITH THE LOCK HELD; THE FILE WORK ITSELF RUNS WITHOUT IT SO SETTERS NEVER WAIT ON THE DISK
+void SettingsStore::Impl::CommitLocked(std::unique_lock<std::mutex>& lock) {
+    TRACE_SCOPE("SettingsStore::Commit", "config");
+    inFlight.swap(dirty);
+    dirty.clear();
+    uint64_t sequence = editSequence;
+    flushRequested = false;
+    lock.unlock();
+
+    ConfigWriter writer(path);
+    writer.SeedIfMissing(defaults);
+    for (const auto& edit : inFlight) {
+        if (edit.remove) writer.Remove(edit.section, edit.key);
+        else writer.Set(edit.section, edit.key, edit.value);
+    }
+    bool committed = writer.Commit(FileSync::FILE);
+    std::shared_ptr<const ConfigFile> snapshot = committed ? ConfigFile::Open(path) : nullptr;
+
+    lock.lock();
+    if (committed) {
+        base = snapshot;
+        committedSequence = sequence;
+        commitCount++;
+    } else {
+        std::cerr << "Failed to write " << path << ", retrying after the next quiet period" << std::endl;
+        // EDITS MADE DURING THE FAILED WRITE ARE NEWER AND WIN
+        for (auto& edit : inFlight) {
+            if (!FindEdit(dirty, edit.section, edit.key)) dirty.push_back(std::move(edit));
+        }
+        lastEdit = std::chrono::steady_clock::now();
+    }
+    inFlight.clear();
+    attemptedSequence = sequence;
+    attemptCount++;
+    written.notify_all();
+}
+
+void SettingsStore::Impl::Loop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        if (stopping) {
+            if (!dirty.empty()) CommitLocked(lock);
+            break;
+        }
+        if (dirty.empty()) {
+            wake.wait(lock);
+            continue;
+        }
+        if (!flushRequested) {
+            std::chrono::steady_clock::time_point due = lastEdit + quiet;
+            if (std::chrono::steady_clock::now() < due) {
+                wake.wait_until(lock, due);
+                continue;
+            }
+        }
+        CommitLocked(lock);
+    }
+}
+
+SettingsStore::Impl& SettingsStore::State() {
+    static Impl state;
+    return state;
+}
+
+bool SettingsStore::Start(const std::string& path, const std::string& defaults, int64_t quietMs) {
+    TRACE_SCOPE("SettingsStore::Start", "config");
+    Impl& state = State();
+    Stop();
+
+    std::shared_ptr<const ConfigFile> config = ConfigFile::Open(path);
+    if (!config->IsLoaded() && !defaults.empty()) {
+        if (AtomicFile::Replace(path, defaults, FileSync::FILE)) {
+            config = ConfigFile::Open(path);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.path = path;
+    state.defaults = defaults;
+    state.quiet = std::chrono::milliseconds(quietMs);
+    state.base = config;
+    state.stopping = false;
+    state.running = true;
+    state.thread = std::thread(&Impl::Loop, &state);
+    return config->IsLoaded();
+}
+
+void SettingsStore::Stop() {
+    Impl& state = State();
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        if (!state.running) return;
+        state.stopping = true;
+    }
+    state.wake.notify_one();
+    if (state.thread.joinable()) {
+        state.thread.join();
+    }
+
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.running = false;
+}
+
+bool SettingsStore::IsRunning() {
+    Impl& state = State();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    return state.running;
+}
+
+void SettingsStore::Set(std::string_view section, std::string_view key, std::string_view value) {
+    State().Record(section, key, value, false);
+}
+
+void SettingsStore::Remove(std::string_view section, std::string_view key) {
+    State().Record(section, key, std::string_view(), true);
+}
+
+bool SettingsStore::Get(std::string_view section, std::string_view key, std::string& value) {
+    Impl& state = State();
+    std::lock_guard<std::mutex> lock(state.mutex);
+
+    if (const PendingEdit* edit = state.FindPending(section, key)) {
+        if (edit->remove) return false;
+        value = edit->value;
+        return true;
+    }
+
+    std::string_view stored;
+    if (!state.base->Get(section, key, stored)) return false;
+    value.assign(stored.data(), stored.size());
+    return true;
+}
+
+bool SettingsStore::GetBool(std::string_view section, std::string_view key, bool fallback) {
+    std::string value;
+    if (!Get(section, key, value)) return fallback;
+
+    if (value == "1" || value == "true") return true;
+    if (value == "0" || value == "false") return false;
+    return fallback;
+}
+
+std::shared_ptr<const ConfigFile> SettingsStore::Snapshot() {
+    Impl& state = State();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    return state.base;
+}
+
+void SettingsStore::Adopt(std::shared_ptr<const ConfigFile> config) {
+    Impl& state = State();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if (config && config->IsLoaded()) {
+        state.base = std::move(config);
+    }
+}
+
+bool SettingsStore::Flush() {
+    TRACE_SCOPE("SettingsStore::Flush", "config");
+    Impl& state = State();
+    std::unique_lock<std::mutex> lock(state.mutex);
+    if (!state.running) return state.dirty.empty();
+
+    if (state.dirty.empty() && state.inFlight.empty()) return true;
+
+    // A WRITE ALREADY UNDER WAY MAY PREDATE THE NEWEST EDITS; WAIT FOR AN ATTEMPT THAT COVERS ALL OF THEM
+    uint64_t target = state.editSequence;
+    uint64_t attempts = state.attemptCount;
+    state.flushRequested = true;
+    state.wake.notify_one();
+    state.written.wait(lock, [&state, target, attempts] {
+        return (state.attemptCount > attempts && state.attemptedSequence >= target) || !state.running;
+    });
+    return state.committedSequence >= target;
+}
+
+bool SettingsStore::IsDirty() {
+    Impl& state = State();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    return !state.dirty.empty() || !state.inFlight.empty();
+}
+
+uint64_t SettingsStore::GetCommitCount() {
+    Impl& state = State();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    return state.commitCount;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include "atomic_file.h"
+#include "config_file.h"
+
+// IN-MEMORY FRONT FOR Config.ini. SETTERS ONLY MARK A KEY DIRTY; A BACKGROUND WRITER COMMITS THE DIRTY SET THROUGH
+// ConfigWriter ONCE NO EDIT HAS ARRIVED FOR quietMs, WHEN Flush IS CALLED, OR AT Stop. NO FILE I/O ON THE CALLER'S THREAD
+class SettingsStore {
+public:
+    static const int64_t DEFAULT_QUIET_MS = 750;
+
+    // CREATES THE FILE FROM defaults IF IT IS MISSING, LOADS IT AND STARTS THE WRITER
+    static bool Start(const std::string& path, const std::string& defaults, int64_t quietMs = DEFAULT_QUIET_MS);
+    // WRITES WHATEVER IS STILL DIRTY, THEN JOINS THE WRITER
+    static void Stop();
+    static bool IsRunning();
+
+    static void Set(std::string_view section, std::string_view key, std::string_view value);
+    static void Remove(std::string_view section, std::string_view key);
+
+    // PENDING EDITS FIRST, THEN THE LAST STATE READ FROM OR WRITTEN TO DISK
+    static bool Get(std::string_view section, std::string_view key, std::string& value);
+    static bool GetBool(std::string_view section, std::string_view key, bool fallback);
+
+    // SCHEMA KEYS: THE SAME ConfigKey NAMES A VALUE ON SAVE AND ON LOAD
+    static void Set(ConfigKey key, std::string_view value) { Set(ConfigSchema::Def(key).section, ConfigSchema::Def(key).key, value); }
+    static void Remove(ConfigKey key) { Remove(ConfigSchema::Def(key).section, ConfigSchema::Def(key).key); }
+    static bool Get(ConfigKey key, std::string& value) { return Get(ConfigSchema::Def(key).section, ConfigSchema::Def(key).key, value); }
+    static bool GetBool(ConfigKey key, bool fallback) { return GetBool(ConfigSchema::Def(key).section, ConfigSchema::Def(key).key, fallback); }
+    // THE FILE AS LAST LOADED OR COMMITTED, WITHOUT PENDING EDITS
+    static std::shared_ptr<const ConfigFile> Snapshot();
+    // TAKES A PARSE OF AN OUTSIDE EDIT (HOT RELOAD) AS THE NEW BASE; PENDING EDITS STILL WIN OVER IT
+    static void Adopt(std::shared_ptr<const ConfigFile> config);
+
+    // BLOCKS UNTIL EVERY EDIT MADE BEFORE THE CALL IS ON DISK. FALSE IF THE WRITE FAILED
+    static bool Flush();
+    static bool IsDirty();
+    static uint64_t GetCommitCount();
+
+private:
+    struct Impl;
+    static Impl& State();
+};
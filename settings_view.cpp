@@ -5,8 +5,10 @@
 #include "font_loader.h"
 #include "resource_loader.h"
 #include "settings_mouse_renderer.h"
+#include "trace_events.h"
+#include "config_file.h"
+#include "settings_store.h"
 #include <commdlg.h>
-#include <fstream>
 
 bool SettingsView::s_iconModeColored = true;
 
@@ -499,136 +501,16 @@ void SettingsView::ApplySettings() {
 }
 
 void SettingsView::LoadUISettings() {
-  std::ifstream configFile("Config.ini");
-  if (!configFile.is_open()) {
-    std::string configContent =
-        ResourceLoader::LoadResourceAsString(IDR_CONFIG_INI);
-    if (!configContent.empty()) {
-      std::ofstream createFile("Config.ini");
-      createFile << configContent;
-      createFile.close();
-
-      configFile.open("Config.ini");
-    }
+  TRACE_SCOPE("SettingsView::LoadUISettings", "config");
+  std::string iconMode;
+  if (SettingsStore::Get(ConfigKey::UI_ICON_MODE, iconMode)) {
+    s_iconModeColored = (iconMode == "COLORED");
   }
-
-  if (!configFile.is_open()) {
-    s_iconModeColored = true;
-    return;
-  }
-
-  std::string line;
-  bool inUISettings = false;
-
-  while (std::getline(configFile, line)) {
-    line.erase(0, line.find_first_not_of(" \t"));
-    line.erase(line.find_last_not_of(" \t") + 1);
-
-    if (line == "[UISettings]") {
-      inUISettings = true;
-      continue;
-    }
-
-    if (line.empty() || line[0] == '[') {
-      inUISettings = false;
-      continue;
-    }
-
-    if (inUISettings) {
-      size_t equalPos = line.find('=');
-      if (equalPos != std::string::npos) {
-        std::string key = line.substr(0, equalPos);
-        std::string value = line.substr(equalPos + 1);
-
-        if (key == "IconMode") {
-          s_iconModeColored = (value == "COLORED");
-        }
-      }
-    }
-  }
-
-  configFile.close();
 }
 
 void SettingsView::SaveUISettings() {
-  std::ifstream checkFile("Config.ini");
-  bool fileExists = checkFile.is_open();
-  checkFile.close();
-
-  if (!fileExists) {
-    std::string configContent =
-        ResourceLoader::LoadResourceAsString(IDR_CONFIG_INI);
-    if (!configContent.empty()) {
-      std::ofstream createFile("Config.ini");
-      createFile << configContent;
-      createFile.close();
-    }
-  }
-
-  std::ifstream configFile("Config.ini");
-  std::vector<std::string> lines;
-  std::string line;
-
-  while (configFile.is_open() && std::getline(configFile, line)) {
-    lines.push_back(line);
-  }
-  configFile.close();
-
-  if (lines.empty()) {
-    lines.push_back("[Option]");
-    lines.push_back("EnableNotifications=1");
-    lines.push_back("");
-    lines.push_back("[UISettings]");
-    lines.push_back("IconMode=" +
-                    std::string(s_iconModeColored ? "COLORED" : "FLAT"));
-    lines.push_back("");
-    lines.push_back("[ColorSettings]");
-  } else {
-    bool uiSectionFound = false;
-    bool iconModeUpdated = false;
-
-    for (size_t i = 0; i < lines.size(); i++) {
-      std::string trimmedLine = lines[i];
-      trimmedLine.erase(0, trimmedLine.find_first_not_of(" \t"));
-      trimmedLine.erase(trimmedLine.find_last_not_of(" \t") + 1);
-
-      if (trimmedLine == "[UISettings]") {
-        uiSectionFound = true;
-        continue;
-      }
-
-      if (uiSectionFound && trimmedLine.find("IconMode=") == 0) {
-        lines[i] =
-            "IconMode=" + std::string(s_iconModeColored ? "COLORED" : "FLAT");
-        iconModeUpdated = true;
-        break;
-      }
-
-      if (uiSectionFound && (trimmedLine.empty() || trimmedLine[0] == '[')) {
-        if (!iconModeUpdated) {
-          lines.insert(lines.begin() + i,
-                       "IconMode=" +
-                           std::string(s_iconModeColored ? "COLORED" : "FLAT"));
-        }
-        break;
-      }
-    }
-
-    if (!uiSectionFound) {
-      if (!lines.empty() && !lines.back().empty()) {
-        lines.push_back("");
-      }
-      lines.push_back("[UISettings]");
-      lines.push_back("IconMode=" +
-                      std::string(s_iconModeColored ? "COLORED" : "FLAT"));
-    }
-  }
-
-  std::ofstream outFile("Config.ini");
-  for (const auto &fileLine : lines) {
-    outFile << fileLine << "\n";
-  }
-  outFile.close();
+  TRACE_SCOPE("SettingsView::SaveUISettings", "config");
+  SettingsStore::Set(ConfigKey::UI_ICON_MODE, s_iconModeColored ? "COLORED" : "FLAT");
 }
 
 bool SettingsView::IsIconModeColored() { return s_iconModeColored; }
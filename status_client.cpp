@@ -0,0 +1,233 @@
+#include "status_client.h"
+#include "status_server.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <unistd.h>
+#include <errno.h>
+#include <cstring>
+#endif
+
+struct StatusClient::Impl {
+#ifdef _WIN32
+    HANDLE pipe;
+    HANDLE readEvent;
+    Impl() : pipe(INVALID_HANDLE_VALUE), readEvent(NULL) {}
+#else
+    int fd;
+    Impl() : fd(-1) {}
+#endif
+    std::string input;
+
+    bool Write(const std::string& data);
+    // APPENDS WHATEVER ARRIVES WITHIN timeoutMs; FALSE ON TIMEOUT OR A CLOSED ENDPOINT
+    bool ReadMore(int timeoutMs);
+};
+
+StatusClient::StatusClient() : impl(new Impl()) {
+}
+
+StatusClient::~StatusClient() {
+    Close();
+}
+
+bool StatusClient::SendRequest(StatusProtocol::Opcode opcode) {
+    std::string request;
+    StatusProtocol::AppendRequest(request, opcode);
+    return impl->Write(request);
+}
+
+bool StatusClient::ReadFrame(StatusProtocol::FrameType& type, StatusSnapshot& snapshot, int timeoutMs) {
+    int64_t deadline = SteadyNowMs() + timeoutMs;
+
+    while (true) {
+        uint32_t sequence = 0;
+        int consumed = StatusProtocol::ParseBinary(impl->input.data(), impl->input.size(), type, sequence, snapshot);
+        if (consumed > 0) {
+            impl->input.erase(0, static_cast<size_t>(consumed));
+            return true;
+        }
+        if (consumed < 0) {
+            Close();
+            return false;
+        }
+
+        int64_t remaining = deadline - SteadyNowMs();
+        if (remaining <= 0 || !impl->ReadMore(static_cast<int>(remaining))) {
+            return false;
+        }
+    }
+}
+
+bool StatusClient::Query(StatusSnapshot& snapshot, int timeoutMs) {
+    if (!IsConnected() || !SendRequest(StatusProtocol::OP_GET_STATUS)) {
+        return false;
+    }
+
+    // A SUBSCRIBED SERVER MAY INTERLEAVE UPDATES; WAIT FOR THE STATUS FRAME ITSELF
+    StatusProtocol::FrameType type;
+    while (ReadFrame(type, snapshot, timeoutMs)) {
+        if (type == StatusProtocol::FRAME_STATUS) return true;
+        if (type == StatusProtocol::FRAME_ERROR) return false;
+    }
+    return false;
+}
+
+#ifdef _WIN32
+
+bool StatusClient::Connect(const std::string& endpoint, int timeoutMs) {
+    Close();
+
+    std::string pipeName = endpoint.empty() ? StatusServer::DefaultEndpoint() : endpoint;
+    HANDLE pipe = CreateFileA(pipeName.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_EXISTING, FILE_FLAG_OVERLAPPED, NULL);
+    if (pipe == INVALID_HANDLE_VALUE && GetLastError() == ERROR_PIPE_BUSY) {
+        if (!WaitNamedPipeA(pipeName.c_str(), static_cast<DWORD>(timeoutMs))) {
+            return false;
+        }
+        pipe = CreateFileA(pipeName.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_EXISTING, FILE_FLAG_OVERLAPPED, NULL);
+    }
+    if (pipe == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    impl->readEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+    if (!impl->readEvent) {
+        CloseHandle(pipe);
+        return false;
+    }
+
+    impl->pipe = pipe;
+    impl->input.clear();
+    return true;
+}
+
+void StatusClient::Close() {
+    if (impl->pipe != INVALID_HANDLE_VALUE) {
+        CloseHandle(impl->pipe);
+        impl->pipe = INVALID_HANDLE_VALUE;
+    }
+    if (impl->readEvent) {
+        CloseHandle(impl->readEvent);
+        impl->readEvent = NULL;
+    }
+    impl->input.clear();
+}
+
+bool StatusClient::IsConnected() const {
+    return impl->pipe != INVALID_HANDLE_VALUE;
+}
+
+bool StatusClient::Impl::Write(const std::string& data) {
+    OVERLAPPED overlapped = {};
+    overlapped.hEvent = readEvent;
+    ResetEvent(readEvent);
+
+    DWORD written = 0;
+    if (!WriteFile(pipe, data.data(), static_cast<DWORD>(data.size()), NULL, &overlapped) && GetLastError() != ERROR_IO_PENDING) {
+        return false;
+    }
+    return GetOverlappedResult(pipe, &overlapped, &written, TRUE) && written == data.size();
+}
+
+bool StatusClient::Impl::ReadMore(int timeoutMs) {
+    char buffer[4096];
+    OVERLAPPED overlapped = {};
+    overlapped.hEvent = readEvent;
+    ResetEvent(readEvent);
+
+    DWORD received = 0;
+    if (!ReadFile(pipe, buffer, sizeof(buffer), NULL, &overlapped) && GetLastError() != ERROR_IO_PENDING) {
+        return false;
+    }
+
+    if (WaitForSingleObject(readEvent, static_cast<DWORD>(timeoutMs)) != WAIT_OBJECT_0) {
+        CancelIo(pipe);
+        GetOverlappedResult(pipe, &overlapped, &received, TRUE);
+        return false;
+    }
+
+    if (!GetOverlappedResult(pipe, &overlapped, &received, FALSE) || received == 0) {
+        return false;
+    }
+
+    input.append(buffer, received);
+    return true;
+}
+
+#else
+
+bool StatusClient::Connect(const std::string& endpoint, int timeoutMs) {
+    (void)timeoutMs;
+    Close();
+
+    std::string path = endpoint.empty() ? StatusServer::DefaultEndpoint() : endpoint;
+
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        return false;
+    }
+    memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+    // A LOCAL SOCKET CONNECTS OR FAILS IMMEDIATELY; THE TIMEOUT ONLY MATTERS FOR THE PIPE
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return false;
+    }
+    if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        close(fd);
+        return false;
+    }
+
+    impl->fd = fd;
+    impl->input.clear();
+    return true;
+}
+
+void StatusClient::Close() {
+    if (impl->fd >= 0) {
+        close(impl->fd);
+        impl->fd = -1;
+    }
+    impl->input.clear();
+}
+
+bool StatusClient::IsConnected() const {
+    return impl->fd >= 0;
+}
+
+bool StatusClient::Impl::Write(const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t result = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (result < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        sent += static_cast<size_t>(result);
+    }
+    return true;
+}
+
+bool StatusClient::Impl::ReadMore(int timeoutMs) {
+    pollfd descriptor = { fd, POLLIN, 0 };
+    int ready = poll(&descriptor, 1, timeoutMs);
+    if (ready <= 0) {
+        return false;
+    }
+
+    char buffer[4096];
+    ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+    if (received <= 0) {
+        return false;
+    }
+
+    input.append(buffer, static_cast<size_t>(received));
+    return true;
+}
+
+#endif
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "status_protocol.h"
+
+// CLIENT SIDE OF StatusServer: BINARY FRAMES OVER THE SAME NAMED PIPE / UNIX SOCKET
+class StatusClient {
+public:
+    StatusClient();
+    ~StatusClient();
+
+    // EMPTY ENDPOINT MEANS StatusServer::DefaultEndpoint()
+    bool Connect(const std::string& endpoint, int timeoutMs);
+    void Close();
+    bool IsConnected() const;
+
+    bool Query(StatusSnapshot& snapshot, int timeoutMs);
+
+private:
+    StatusClient(const StatusClient&);
+    StatusClient& operator=(const StatusClient&);
+
+    bool SendRequest(StatusProtocol::Opcode opcode);
+    bool ReadFrame(StatusProtocol::FrameType& type, StatusSnapshot& snapshot, int timeoutMs);
+
+    struct Impl;
+    std::unique_ptr<Impl> impl;
+};
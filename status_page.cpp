@@ -0,0 +1,228 @@
+#include "status_page.h"
+#include "trace_events.h"
+#include <atomic>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+static_assert(sizeof(MonkaStatusHeader) == 64, "status header must fill one cache line");
+static_assert(sizeof(MonkaStatusRecord) == 64, "status record must fill one cache line");
+
+static const int32_t NO_SLOT = -1;
+
+StatusPage::StatusPage()
+    : page(nullptr),
+#ifdef _WIN32
+      mapping(nullptr)
+#else
+      fd(-1)
+#endif
+{
+}
+
+StatusPage::~StatusPage() {
+    Close();
+}
+
+std::string StatusPage::DefaultName() {
+#ifdef _WIN32
+    return MONKA_STATUS_DEFAULT_NAME;
+#else
+    return std::string(MONKA_STATUS_DEFAULT_NAME) + "-" + std::to_string(static_cast<unsigned>(getuid()));
+#endif
+}
+
+bool StatusPage::Open(const std::string& pageName) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (page) return true;
+
+    name = pageName.empty() ? DefaultName() : pageName;
+
+#ifdef _WIN32
+    HANDLE handle = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0,
+                                       static_cast<DWORD>(sizeof(MonkaStatusPage)), name.c_str());
+    if (!handle) {
+        OutputDebugStringA("StatusPage: CreateFileMapping failed\n");
+        return false;
+    }
+
+    void* view = MapViewOfFile(handle, FILE_MAP_WRITE, 0, 0, sizeof(MonkaStatusPage));
+    if (!view) {
+        CloseHandle(handle);
+        return false;
+    }
+    mapping = handle;
+    DWORD pid = GetCurrentProcessId();
+#else
+    int handle = shm_open(name.c_str(), O_RDWR | O_CREAT, 0600);
+    if (handle < 0) {
+        return false;
+    }
+
+    if (ftruncate(handle, sizeof(MonkaStatusPage)) != 0) {
+        close(handle);
+        return false;
+    }
+
+    void* view = mmap(NULL, sizeof(MonkaStatusPage), PROT_READ | PROT_WRITE, MAP_SHARED, handle, 0);
+    if (view == MAP_FAILED) {
+        close(handle);
+        return false;
+    }
+    fd = handle;
+    pid_t pid = getpid();
+#endif
+
+    page = static_cast<MonkaStatusPage*>(view);
+
+    // READERS CHECK THE MAGIC LAST, SO WRITE IT AFTER EVERYTHING ELSE IS IN PLACE
+    MonkaStatusHeader& header = page->header;
+    header.magic = 0;
+    std::atomic_thread_fence(std::memory_order_release);
+
+    header.version = MONKA_STATUS_VERSION;
+    header.headerSize = sizeof(MonkaStatusHeader);
+    header.recordSize = sizeof(MonkaStatusRecord);
+    header.capacity = MONKA_STATUS_CAPACITY;
+    header.sequence = 0;
+    header.deviceCount = 0;
+    header.writerPid = static_cast<uint32_t>(pid);
+    header.lastWriteMs = SteadyNowMs();
+
+    std::atomic_thread_fence(std::memory_order_release);
+    header.magic = MONKA_STATUS_MAGIC;
+
+    slotOf.clear();
+    return true;
+}
+
+void StatusPage::Close() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!page) return;
+
+    page->header.deviceCount = 0;
+
+#ifdef _WIN32
+    UnmapViewOfFile(page);
+    CloseHandle(static_cast<HANDLE>(mapping));
+    mapping = nullptr;
+#else
+    munmap(page, sizeof(MonkaStatusPage));
+    close(fd);
+    fd = -1;
+    shm_unlink(name.c_str());
+#endif
+
+    page = nullptr;
+    slotOf.clear();
+}
+
+void StatusPage::BeginWrite(volatile uint32_t& sequence) {
+    sequence = sequence + 1;
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+void StatusPage::EndWrite(volatile uint32_t& sequence) {
+    std::atomic_thread_fence(std::memory_order_release);
+    sequence = sequence + 1;
+}
+
+bool StatusPage::SameRecord(const MonkaStatusRecord& record, const DeviceStatus& status) {
+    return record.deviceId == status.id &&
+           record.level == status.level &&
+           record.isCharging == (status.isCharging ? 1 : 0) &&
+           record.isOnline == (status.isOnline ? 1 : 0) &&
+           record.connectionType == static_cast<uint8_t>(status.connectionType) &&
+           record.linkState == static_cast<uint8_t>(status.linkState) &&
+           record.isMonitored == (status.isMonitored ? 1 : 0) &&
+           record.voltage == status.voltage &&
+           record.lastUpdateMs == status.lastUpdateMs &&
+           strncmp(record.name, status.name.c_str(), MONKA_STATUS_NAME_SIZE - 1) == 0;
+}
+
+void StatusPage::WriteRecord(MonkaStatusRecord& record, const DeviceStatus& status) {
+    record.deviceId = status.id;
+    record.level = status.level;
+    record.isCharging = status.isCharging ? 1 : 0;
+    record.isOnline = status.isOnline ? 1 : 0;
+    record.connectionType = static_cast<uint8_t>(status.connectionType);
+    record.linkState = static_cast<uint8_t>(status.linkState);
+    record.isMonitored = status.isMonitored ? 1 : 0;
+    record.voltage = status.voltage;
+    record.lastUpdateMs = status.lastUpdateMs;
+
+    size_t nameLength = status.name.size();
+    if (nameLength > MONKA_STATUS_NAME_SIZE - 1) nameLength = MONKA_STATUS_NAME_SIZE - 1;
+
+    memset(record.name, 0, sizeof(record.name));
+    memcpy(record.name, status.name.data(), nameLength);
+}
+
+void StatusPage::Publish(const StatusSnapshot& snapshot) {
+    TRACE_SCOPE("StatusPage::Publish", "ipc");
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!page) return;
+
+    MonkaStatusHeader& header = page->header;
+    uint32_t count = static_cast<uint32_t>(snapshot.size());
+    if (count > MONKA_STATUS_CAPACITY) count = MONKA_STATUS_CAPACITY;
+
+    bool membershipChanged = (count != header.deviceCount);
+    for (uint32_t i = 0; i < count && !membershipChanged; i++) {
+        membershipChanged = (page->records[i].deviceId != snapshot[i].id);
+    }
+
+    // ONLY A CHANGED DEVICE LIST TAKES THE PAGE-WIDE LOCK; VALUE CHANGES STAY PER RECORD
+    if (membershipChanged) {
+        BeginWrite(header.sequence);
+        slotOf.clear();
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        const DeviceStatus& status = snapshot[i];
+        MonkaStatusRecord& record = page->records[i];
+
+        if (membershipChanged) {
+            if (status.id >= slotOf.size()) slotOf.resize(status.id + 1, NO_SLOT);
+            slotOf[status.id] = static_cast<int32_t>(i);
+        }
+
+        if (SameRecord(record, status)) continue;
+
+        BeginWrite(record.sequence);
+        WriteRecord(record, status);
+        EndWrite(record.sequence);
+    }
+
+    header.lastWriteMs = SteadyNowMs();
+
+    if (membershipChanged) {
+        header.deviceCount = count;
+        EndWrite(header.sequence);
+    }
+}
+
+// FAST PATH FOR THE HID THREAD: ONE RECORD, NO SNAPSHOT
+void StatusPage::UpdateSample(DeviceId deviceId, const BatteryStatus& status, int64_t nowMs) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!page || deviceId >= slotOf.size() || slotOf[deviceId] == NO_SLOT) return;
+
+    MonkaStatusRecord& record = page->records[slotOf[deviceId]];
+
+    BeginWrite(record.sequence);
+    record.level = status.level;
+    record.isCharging = status.isCharging ? 1 : 0;
+    record.voltage = status.BatVoltage;
+    record.isOnline = 1;
+    record.lastUpdateMs = nowMs;
+    EndWrite(record.sequence);
+
+    page->header.lastWriteMs = nowMs;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <vector>
+#include "monka_status.h"
+#include "status_protocol.h"
+
+// WRITER SIDE OF THE SHARED-MEMORY STATUS PAGE. WRITERS SERIALIZE ON A MUTEX; READERS NEVER BLOCK THEM
+class StatusPage {
+private:
+    MonkaStatusPage* page;
+#ifdef _WIN32
+    void* mapping;
+#else
+    int fd;
+#endif
+    std::string name;
+
+    std::mutex mutex;
+    std::vector<int32_t> slotOf;
+
+    static bool SameRecord(const MonkaStatusRecord& record, const DeviceStatus& status);
+    static void WriteRecord(MonkaStatusRecord& record, const DeviceStatus& status);
+    static void BeginWrite(volatile uint32_t& sequence);
+    static void EndWrite(volatile uint32_t& sequence);
+
+public:
+    StatusPage();
+    ~StatusPage();
+
+    bool Open(const std::string& pageName);
+    void Close();
+    bool IsOpen() const { return page != nullptr; }
+
+    void Publish(const StatusSnapshot& snapshot);
+    void UpdateSample(DeviceId deviceId, const BatteryStatus& status, int64_t nowMs);
+
+    static std::string DefaultName();
+
+private:
+    StatusPage(const StatusPage&);
+    StatusPage& operator=(const StatusPage&);
+};
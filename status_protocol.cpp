@@ -0,0 +1,321 @@
+#include "status_protocol.h"
+#include <cstdio>
+
+namespace {
+
+const uint32_t NO_SAMPLE_AGE = 0xFFFFFFFFu;
+
+void WriteU16(std::string& out, uint16_t value) {
+    out.push_back(static_cast<char>(value & 0xFF));
+    out.push_back(static_cast<char>((value >> 8) & 0xFF));
+}
+
+void WriteU32(std::string& out, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+uint16_t ReadU16(const unsigned char* p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+uint32_t ReadU32(const unsigned char* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+uint32_t SampleAge(const DeviceStatus& status, int64_t nowMs) {
+    if (status.lastUpdateMs == 0) return NO_SAMPLE_AGE;
+
+    int64_t age = nowMs - status.lastUpdateMs;
+    if (age < 0) age = 0;
+    if (age >= NO_SAMPLE_AGE) age = NO_SAMPLE_AGE - 1;
+    return static_cast<uint32_t>(age);
+}
+
+void AppendJsonString(std::string& out, const std::string& value) {
+    out.push_back('"');
+    for (char c : value) {
+        if (c == '"' || c == '\\') {
+            out.push_back('\\');
+            out.push_back(c);
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned char>(c));
+            out += escaped;
+        } else {
+            out.push_back(c);
+        }
+    }
+    out.push_back('"');
+}
+
+}
+
+const char* StatusProtocol::ConnectionTypeName(ConnectionType type) {
+    switch (type) {
+    case ConnectionType::USB_WIRED: return "wired";
+    case ConnectionType::WIRELESS_DONGLE: return "dongle";
+    case ConnectionType::BLUETOOTH: return "bluetooth";
+    default: return "unknown";
+    }
+}
+
+const char* StatusProtocol::LinkStateName(LinkState state) {
+    switch (state) {
+    case LinkState::ONLINE: return "online";
+    case LinkState::SUSPECT: return "suspect";
+    case LinkState::OFFLINE: return "offline";
+    default: return "unknown";
+    }
+}
+
+bool StatusProtocol::SameDevice(const DeviceStatus& x, const DeviceStatus& y) {
+    return x.id == y.id && x.connectionType == y.connectionType && x.linkState == y.linkState &&
+           x.level == y.level && x.isCharging == y.isCharging && x.isOnline == y.isOnline &&
+           x.isMonitored == y.isMonitored && x.name == y.name;
+}
+
+bool StatusProtocol::SameState(const StatusSnapshot& a, const StatusSnapshot& b) {
+    if (a.size() != b.size()) return false;
+
+    for (size_t i = 0; i < a.size(); i++) {
+        if (!SameDevice(a[i], b[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void StatusProtocol::AppendJsonDevice(std::string& out, const DeviceStatus& status, int64_t nowMs) {
+    char buffer[200];
+
+    snprintf(buffer, sizeof(buffer), "{\"id\":%u,\"name\":", status.id);
+    out += buffer;
+    AppendJsonString(out, status.name);
+
+    uint32_t age = SampleAge(status, nowMs);
+    snprintf(buffer, sizeof(buffer),
+             ",\"connection\":\"%s\",\"link\":\"%s\",\"level\":%u,\"charging\":%s,\"online\":%s,\"monitored\":%s,\"voltage\":%u,\"ageMs\":%lld}",
+             ConnectionTypeName(status.connectionType), LinkStateName(status.linkState),
+             static_cast<unsigned>(status.level),
+             status.isCharging ? "true" : "false",
+             status.isOnline ? "true" : "false",
+             status.isMonitored ? "true" : "false",
+             static_cast<unsigned>(status.voltage),
+             age == NO_SAMPLE_AGE ? -1ll : static_cast<long long>(age));
+    out += buffer;
+}
+
+void StatusProtocol::AppendJson(std::string& out, const char* type, uint32_t sequence, const StatusSnapshot& snapshot, int64_t nowMs) {
+    char buffer[160];
+
+    snprintf(buffer, sizeof(buffer), "{\"type\":\"%s\",\"seq\":%u,\"devices\":[", type, sequence);
+    out += buffer;
+
+    for (size_t i = 0; i < snapshot.size(); i++) {
+        if (i > 0) out.push_back(',');
+        AppendJsonDevice(out, snapshot[i], nowMs);
+    }
+
+    out += "]}\n";
+}
+
+void StatusProtocol::AppendJsonError(std::string& out, const char* message) {
+    out += "{\"type\":\"error\",\"message\":";
+    AppendJsonString(out, message);
+    out += "}\n";
+}
+
+void StatusProtocol::AppendBinary(std::string& out, FrameType type, uint32_t sequence, const StatusSnapshot& snapshot, int64_t nowMs) {
+    size_t headerPos = out.size();
+
+    out.push_back(static_cast<char>(MAGIC_0));
+    out.push_back(static_cast<char>(MAGIC_1));
+    out.push_back(static_cast<char>(VERSION));
+    out.push_back(static_cast<char>(type));
+    WriteU32(out, 0);
+
+    size_t payloadPos = out.size();
+    uint16_t count = static_cast<uint16_t>(snapshot.size() > 0xFFFF ? 0xFFFF : snapshot.size());
+
+    WriteU32(out, sequence);
+    WriteU16(out, count);
+
+    for (uint16_t i = 0; i < count; i++) {
+        const DeviceStatus& status = snapshot[i];
+
+        uint8_t flags = 0;
+        if (status.isOnline) flags |= RECORD_ONLINE;
+        if (status.isCharging) flags |= RECORD_CHARGING;
+        if (status.isMonitored) flags |= RECORD_MONITORED;
+
+        WriteU32(out, status.id);
+        out.push_back(static_cast<char>(status.connectionType));
+        out.push_back(static_cast<char>(flags));
+        out.push_back(static_cast<char>(status.level));
+        out.push_back(static_cast<char>(status.linkState));
+        WriteU16(out, status.voltage);
+        WriteU16(out, 0);
+        WriteU32(out, SampleAge(status, nowMs));
+
+        uint8_t nameLength = static_cast<uint8_t>(status.name.size() > 0xFF ? 0xFF : status.name.size());
+        out.push_back(static_cast<char>(nameLength));
+        out.append(status.name.data(), nameLength);
+    }
+
+    uint32_t payloadLength = static_cast<uint32_t>(out.size() - payloadPos);
+    for (int i = 0; i < 4; i++) {
+        out[headerPos + 4 + i] = static_cast<char>((payloadLength >> (8 * i)) & 0xFF);
+    }
+}
+
+void StatusProtocol::AppendRequest(std::string& out, Opcode opcode) {
+    out.push_back(static_cast<char>(MAGIC_0));
+    out.push_back(static_cast<char>(MAGIC_1));
+    out.push_back(static_cast<char>(VERSION));
+    out.push_back(static_cast<char>(opcode));
+}
+
+int StatusProtocol::ParseBinary(const char* data, size_t length, FrameType& type, uint32_t& sequence, StatusSnapshot& snapshot) {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    if (length < RESPONSE_HEADER_SIZE) return 0;
+
+    if (bytes[0] != MAGIC_0 || bytes[1] != MAGIC_1 || bytes[2] != VERSION) return -1;
+
+    uint32_t payloadLength = ReadU32(bytes + 4);
+    if (payloadLength > (1u << 24)) return -1;
+    if (length < RESPONSE_HEADER_SIZE + payloadLength) return 0;
+
+    type = static_cast<FrameType>(bytes[3]);
+    snapshot.clear();
+
+    const unsigned char* p = bytes + RESPONSE_HEADER_SIZE;
+    const unsigned char* end = p + payloadLength;
+    if (end - p < 6) return -1;
+
+    sequence = ReadU32(p);
+    uint16_t count = ReadU16(p + 4);
+    p += 6;
+
+    int64_t nowMs = SteadyNowMs();
+    snapshot.reserve(count);
+
+    for (uint16_t i = 0; i < count; i++) {
+        if (static_cast<size_t>(end - p) < RECORD_FIXED_SIZE + 1) return -1;
+
+        DeviceStatus status;
+        status.id = ReadU32(p);
+        status.connectionType = p[4] <= static_cast<uint8_t>(ConnectionType::UNKNOWN)
+            ? static_cast<ConnectionType>(p[4]) : ConnectionType::UNKNOWN;
+        status.isOnline = (p[5] & RECORD_ONLINE) != 0;
+        status.isCharging = (p[5] & RECORD_CHARGING) != 0;
+        status.isMonitored = (p[5] & RECORD_MONITORED) != 0;
+        status.level = p[6];
+        status.linkState = p[7] <= static_cast<uint8_t>(LinkState::OFFLINE)
+            ? static_cast<LinkState>(p[7]) : LinkState::UNKNOWN;
+        status.voltage = ReadU16(p + 8);
+
+        uint32_t age = ReadU32(p + 12);
+        status.lastUpdateMs = (age == NO_SAMPLE_AGE) ? 0 : nowMs - age;
+
+        uint8_t nameLength = p[RECORD_FIXED_SIZE];
+        p += RECORD_FIXED_SIZE + 1;
+        if (end - p < nameLength) return -1;
+
+        status.name.assign(reinterpret_cast<const char*>(p), nameLength);
+        p += nameLength;
+
+        snapshot.push_back(status);
+    }
+
+    return static_cast<int>(RESPONSE_HEADER_SIZE + payloadLength);
+}
+
+void StatusSession::OnInput(const char* data, size_t length, uint32_t sequence, const StatusSnapshot& snapshot, std::string& out) {
+    pending.append(data, length);
+
+    if (mode == Mode::UNKNOWN && pending.size() >= 2) {
+        bool binary = static_cast<uint8_t>(pending[0]) == StatusProtocol::MAGIC_0 &&
+                      static_cast<uint8_t>(pending[1]) == StatusProtocol::MAGIC_1;
+        mode = binary ? Mode::BINARY : Mode::TEXT;
+    }
+
+    int64_t nowMs = SteadyNowMs();
+
+    if (mode == Mode::BINARY) {
+        size_t pos = 0;
+        while (pending.size() - pos >= StatusProtocol::REQUEST_SIZE) {
+            const unsigned char* request = reinterpret_cast<const unsigned char*>(pending.data() + pos);
+            pos += StatusProtocol::REQUEST_SIZE;
+
+            if (request[0] != StatusProtocol::MAGIC_0 || request[1] != StatusProtocol::MAGIC_1 ||
+                request[2] != StatusProtocol::VERSION) {
+                StatusProtocol::AppendBinary(out, StatusProtocol::FRAME_ERROR, sequence, StatusSnapshot(), nowMs);
+                closing = true;
+                break;
+            }
+
+            switch (request[3]) {
+            case StatusProtocol::OP_SUBSCRIBE:
+                subscribed = true;
+                StatusProtocol::AppendBinary(out, StatusProtocol::FRAME_STATUS, sequence, snapshot, nowMs);
+                break;
+            case StatusProtocol::OP_UNSUBSCRIBE:
+                subscribed = false;
+                break;
+            case StatusProtocol::OP_GET_STATUS:
+                StatusProtocol::AppendBinary(out, StatusProtocol::FRAME_STATUS, sequence, snapshot, nowMs);
+                break;
+            default:
+                StatusProtocol::AppendBinary(out, StatusProtocol::FRAME_ERROR, sequence, StatusSnapshot(), nowMs);
+                break;
+            }
+        }
+        pending.erase(0, pos);
+    } else if (mode == Mode::TEXT) {
+        size_t newline;
+        while ((newline = pending.find('\n')) != std::string::npos) {
+            std::string command = pending.substr(0, newline);
+            pending.erase(0, newline + 1);
+
+            command.erase(0, command.find_first_not_of(" \t\r"));
+            command.erase(command.find_last_not_of(" \t\r") + 1);
+            if (!command.empty()) {
+                HandleTextCommand(command, sequence, snapshot, out);
+            }
+        }
+    }
+
+    if (pending.size() > MAX_PENDING_INPUT) {
+        closing = true;
+    }
+}
+
+void StatusSession::HandleTextCommand(const std::string& command, uint32_t sequence, const StatusSnapshot& snapshot, std::string& out) {
+    int64_t nowMs = SteadyNowMs();
+
+    if (command == "status") {
+        StatusProtocol::AppendJson(out, "status", sequence, snapshot, nowMs);
+    } else if (command == "subscribe") {
+        subscribed = true;
+        StatusProtocol::AppendJson(out, "status", sequence, snapshot, nowMs);
+    } else if (command == "unsubscribe") {
+        subscribed = false;
+        out += "{\"type\":\"unsubscribed\"}\n";
+    } else {
+        StatusProtocol::AppendJsonError(out, "unknown command");
+    }
+}
+
+void StatusSession::AppendUpdate(uint32_t sequence, const StatusSnapshot& snapshot, std::string& out) const {
+    if (!subscribed) return;
+
+    int64_t nowMs = SteadyNowMs();
+    if (mode == Mode::BINARY) {
+        StatusProtocol::AppendBinary(out, StatusProtocol::FRAME_UPDATE, sequence, snapshot, nowMs);
+    } else {
+        StatusProtocol::AppendJson(out, "update", sequence, snapshot, nowMs);
+    }
+}
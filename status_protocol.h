@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "device_registry.h"
+#include "heartbeat_monitor.h"
+
+struct DeviceStatus {
+    DeviceId id;
+    std::string name;
+    ConnectionType connectionType;
+    LinkState linkState;
+    uint8_t level;
+    bool isCharging;
+    bool isOnline;
+    bool isMonitored;
+    uint16_t voltage;
+    int64_t lastUpdateMs;
+};
+
+typedef std::vector<DeviceStatus> StatusSnapshot;
+
+// BINARY FRAMES: 'M' 'K' VERSION OPCODE/TYPE. RESPONSES ADD A U32 PAYLOAD LENGTH, ALL LITTLE ENDIAN.
+// TEXT MODE: ONE COMMAND PER LINE (status, subscribe, unsubscribe), ONE JSON OBJECT PER LINE BACK
+namespace StatusProtocol {
+    const uint8_t MAGIC_0 = 'M';
+    const uint8_t MAGIC_1 = 'K';
+    const uint8_t VERSION = 1;
+
+    const size_t REQUEST_SIZE = 4;
+    const size_t RESPONSE_HEADER_SIZE = 8;
+    const size_t RECORD_FIXED_SIZE = 16;
+
+    enum Opcode : uint8_t {
+        OP_GET_STATUS = 1,
+        OP_SUBSCRIBE = 2,
+        OP_UNSUBSCRIBE = 3
+    };
+
+    enum FrameType : uint8_t {
+        FRAME_STATUS = 1,
+        FRAME_UPDATE = 2,
+        FRAME_ERROR = 3
+    };
+
+    enum RecordFlags : uint8_t {
+        RECORD_ONLINE = 0x01,
+        RECORD_CHARGING = 0x02,
+        RECORD_MONITORED = 0x04
+    };
+
+    const char* ConnectionTypeName(ConnectionType type);
+    const char* LinkStateName(LinkState state);
+
+    bool SameDevice(const DeviceStatus& a, const DeviceStatus& b);
+    bool SameState(const StatusSnapshot& a, const StatusSnapshot& b);
+
+    void AppendJsonDevice(std::string& out, const DeviceStatus& status, int64_t nowMs);
+    void AppendJson(std::string& out, const char* type, uint32_t sequence, const StatusSnapshot& snapshot, int64_t nowMs);
+    void AppendJsonError(std::string& out, const char* message);
+
+    void AppendBinary(std::string& out, FrameType type, uint32_t sequence, const StatusSnapshot& snapshot, int64_t nowMs);
+    void AppendRequest(std::string& out, Opcode opcode);
+
+    // RETURNS BYTES CONSUMED, 0 WHEN THE FRAME IS INCOMPLETE, -1 ON A MALFORMED FRAME
+    int ParseBinary(const char* data, size_t length, FrameType& type, uint32_t& sequence, StatusSnapshot& snapshot);
+}
+
+// PER-CONNECTION STATE SHARED BY THE NAMED PIPE AND UNIX SOCKET TRANSPORTS
+class StatusSession {
+public:
+    enum class Mode { UNKNOWN, TEXT, BINARY };
+
+    StatusSession() : mode(Mode::UNKNOWN), subscribed(false), closing(false) {}
+
+    void OnInput(const char* data, size_t length, uint32_t sequence, const StatusSnapshot& snapshot, std::string& out);
+    void AppendUpdate(uint32_t sequence, const StatusSnapshot& snapshot, std::string& out) const;
+
+    bool IsSubscribed() const { return subscribed; }
+    bool IsClosing() const { return closing; }
+
+private:
+    static const size_t MAX_PENDING_INPUT = 4096;
+
+    Mode mode;
+    bool subscribed;
+    bool closing;
+    std::string pending;
+
+    void HandleTextCommand(const std::string& command, uint32_t sequence, const StatusSnapshot& snapshot, std::string& out);
+};
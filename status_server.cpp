@@ -0,0 +1,554 @@
+#include "status_server.h"
+#include "trace_events.h"
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <cstdlib>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+static const size_t MAX_CLIENT_OUTBOX = 1024 * 1024;
+static const size_t READ_CHUNK = 4096;
+
+#ifdef _WIN32
+
+struct StatusClient {
+    HANDLE pipe;
+    HANDLE readEvent;
+    HANDLE writeEvent;
+    HANDLE wakeEvent;
+
+    std::mutex mutex;
+    StatusSession session;
+    std::string outbox;
+    bool dropped;
+
+    std::thread thread;
+    std::atomic<bool> finished;
+
+    StatusClient(HANDLE pipeHandle)
+        : pipe(pipeHandle), dropped(false), finished(false) {
+        readEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+        writeEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+        wakeEvent = CreateEventA(NULL, FALSE, FALSE, NULL);
+    }
+
+    ~StatusClient() {
+        if (thread.joinable()) thread.join();
+        CloseHandle(readEvent);
+        CloseHandle(writeEvent);
+        CloseHandle(wakeEvent);
+    }
+};
+
+struct StatusServer::Impl {
+    std::mutex mutex;
+    StatusSnapshot snapshot;
+    uint32_t sequence;
+
+    std::string pipeName;
+    std::atomic<bool> running;
+    HANDLE stopEvent;
+    std::thread acceptThread;
+
+    std::mutex clientsMutex;
+    std::vector<std::unique_ptr<StatusClient>> clients;
+
+    Impl() : sequence(0), running(false), stopEvent(NULL) {}
+
+    void AcceptLoop();
+    void ClientLoop(StatusClient* client);
+    bool FlushClient(StatusClient* client);
+    void ReapFinishedClients();
+};
+
+bool StatusServer::Impl::FlushClient(StatusClient* client) {
+    std::string pendingOut;
+    {
+        std::lock_guard<std::mutex> lock(client->mutex);
+        pendingOut.swap(client->outbox);
+    }
+
+    size_t offset = 0;
+    while (offset < pendingOut.size()) {
+        OVERLAPPED overlapped = {};
+        overlapped.hEvent = client->writeEvent;
+        ResetEvent(client->writeEvent);
+
+        DWORD chunk = static_cast<DWORD>(pendingOut.size() - offset);
+        DWORD written = 0;
+        if (!WriteFile(client->pipe, pendingOut.data() + offset, chunk, NULL, &overlapped) &&
+            GetLastError() != ERROR_IO_PENDING) {
+            return false;
+        }
+        if (!GetOverlappedResult(client->pipe, &overlapped, &written, TRUE) || written == 0) {
+            return false;
+        }
+        offset += written;
+    }
+    return true;
+}
+
+void StatusServer::Impl::ClientLoop(StatusClient* client) {
+    TRACE_THREAD_NAME("status-client");
+
+    char buffer[READ_CHUNK];
+    OVERLAPPED readOverlapped = {};
+    readOverlapped.hEvent = client->readEvent;
+    bool readPending = false;
+
+    while (running) {
+        if (!readPending) {
+            ResetEvent(client->readEvent);
+            if (!ReadFile(client->pipe, buffer, sizeof(buffer), NULL, &readOverlapped) &&
+                GetLastError() != ERROR_IO_PENDING) {
+                break;
+            }
+            readPending = true;
+        }
+
+        HANDLE handles[3] = { client->readEvent, client->wakeEvent, stopEvent };
+        DWORD waitResult = WaitForMultipleObjects(3, handles, FALSE, INFINITE);
+
+        if (waitResult == WAIT_OBJECT_0) {
+            DWORD bytesRead = 0;
+            readPending = false;
+            if (!GetOverlappedResult(client->pipe, &readOverlapped, &bytesRead, FALSE) || bytesRead == 0) {
+                break;
+            }
+
+            std::lock_guard<std::mutex> snapshotLock(mutex);
+            std::lock_guard<std::mutex> clientLock(client->mutex);
+            client->session.OnInput(buffer, bytesRead, sequence, snapshot, client->outbox);
+        } else if (waitResult != WAIT_OBJECT_0 + 1) {
+            break;
+        }
+
+        if (!FlushClient(client)) {
+            break;
+        }
+
+        std::lock_guard<std::mutex> clientLock(client->mutex);
+        if (client->dropped || (client->session.IsClosing() && client->outbox.empty())) {
+            break;
+        }
+    }
+
+    if (readPending) {
+        DWORD ignored = 0;
+        CancelIo(client->pipe);
+        GetOverlappedResult(client->pipe, &readOverlapped, &ignored, TRUE);
+    }
+
+    DisconnectNamedPipe(client->pipe);
+    CloseHandle(client->pipe);
+    client->pipe = INVALID_HANDLE_VALUE;
+    client->finished = true;
+}
+
+void StatusServer::Impl::ReapFinishedClients() {
+    std::vector<std::unique_ptr<StatusClient>> finished;
+    {
+        std::lock_guard<std::mutex> lock(clientsMutex);
+        for (size_t i = 0; i < clients.size();) {
+            if (clients[i]->finished) {
+                finished.push_back(std::move(clients[i]));
+                clients.erase(clients.begin() + i);
+            } else {
+                i++;
+            }
+        }
+    }
+}
+
+void StatusServer::Impl::AcceptLoop() {
+    TRACE_THREAD_NAME("status-accept");
+
+    HANDLE connectEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+
+    while (running) {
+        HANDLE pipe = CreateNamedPipeA(pipeName.c_str(),
+                                       PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED,
+                                       PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS,
+                                       PIPE_UNLIMITED_INSTANCES, 64 * 1024, 64 * 1024, 0, NULL);
+        if (pipe == INVALID_HANDLE_VALUE) {
+            OutputDebugStringA("StatusServer: CreateNamedPipe failed\n");
+            WaitForSingleObject(stopEvent, 1000);
+            continue;
+        }
+
+        OVERLAPPED overlapped = {};
+        overlapped.hEvent = connectEvent;
+        ResetEvent(connectEvent);
+
+        bool connected = ConnectNamedPipe(pipe, &overlapped) != FALSE;
+        DWORD error = GetLastError();
+
+        if (!connected && error == ERROR_IO_PENDING) {
+            HANDLE handles[2] = { connectEvent, stopEvent };
+            DWORD waitResult = WaitForMultipleObjects(2, handles, FALSE, INFINITE);
+            if (waitResult != WAIT_OBJECT_0) {
+                DWORD ignored = 0;
+                CancelIo(pipe);
+                GetOverlappedResult(pipe, &overlapped, &ignored, TRUE);
+                CloseHandle(pipe);
+                break;
+            }
+
+            DWORD ignored = 0;
+            connected = GetOverlappedResult(pipe, &overlapped, &ignored, FALSE) != FALSE;
+        } else if (!connected && error == ERROR_PIPE_CONNECTED) {
+            connected = true;
+        }
+
+        if (!connected) {
+            CloseHandle(pipe);
+            continue;
+        }
+
+        ReapFinishedClients();
+
+        std::unique_ptr<StatusClient> client(new StatusClient(pipe));
+        StatusClient* raw = client.get();
+        {
+            std::lock_guard<std::mutex> lock(clientsMutex);
+            clients.push_back(std::move(client));
+        }
+        raw->thread = std::thread(&StatusServer::Impl::ClientLoop, this, raw);
+    }
+
+    CloseHandle(connectEvent);
+}
+
+StatusServer::StatusServer() : impl(new Impl()) {}
+
+StatusServer::~StatusServer() {
+    Stop();
+}
+
+std::string StatusServer::DefaultEndpoint() {
+    return "\\\\.\\pipe\\MonkaBattery";
+}
+
+bool StatusServer::Start(const std::string& endpoint) {
+    if (impl->running) return true;
+
+    impl->pipeName = endpoint.empty() ? DefaultEndpoint() : endpoint;
+    impl->stopEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+    if (!impl->stopEvent) {
+        return false;
+    }
+
+    impl->running = true;
+    impl->acceptThread = std::thread(&StatusServer::Impl::AcceptLoop, impl.get());
+    return true;
+}
+
+void StatusServer::Stop() {
+    if (!impl->running.exchange(false)) return;
+
+    SetEvent(impl->stopEvent);
+    if (impl->acceptThread.joinable()) {
+        impl->acceptThread.join();
+    }
+
+    std::vector<std::unique_ptr<StatusClient>> clients;
+    {
+        std::lock_guard<std::mutex> lock(impl->clientsMutex);
+        clients.swap(impl->clients);
+    }
+    clients.clear();
+
+    CloseHandle(impl->stopEvent);
+    impl->stopEvent = NULL;
+}
+
+void StatusServer::Publish(const StatusSnapshot& snapshot) {
+    std::lock_guard<std::mutex> snapshotLock(impl->mutex);
+
+    bool changed = !StatusProtocol::SameState(snapshot, impl->snapshot);
+    impl->snapshot = snapshot;
+    if (!changed) return;
+
+    impl->sequence++;
+
+    std::lock_guard<std::mutex> clientsLock(impl->clientsMutex);
+    for (auto& client : impl->clients) {
+        std::lock_guard<std::mutex> clientLock(client->mutex);
+        if (!client->session.IsSubscribed()) continue;
+
+        client->session.AppendUpdate(impl->sequence, impl->snapshot, client->outbox);
+        if (client->outbox.size() > MAX_CLIENT_OUTBOX) {
+            client->dropped = true;
+        }
+        SetEvent(client->wakeEvent);
+    }
+}
+
+size_t StatusServer::GetClientCount() const {
+    std::lock_guard<std::mutex> lock(impl->clientsMutex);
+
+    size_t count = 0;
+    for (const auto& client : impl->clients) {
+        if (!client->finished) count++;
+    }
+    return count;
+}
+
+#else
+
+struct StatusClient {
+    int fd;
+    StatusSession session;
+    std::string outbox;
+};
+
+struct StatusServer::Impl {
+    std::mutex mutex;
+    StatusSnapshot snapshot;
+    uint32_t sequence;
+    bool updatePending;
+
+    std::string socketPath;
+    std::atomic<bool> running;
+    int listenFd;
+    int wakePipe[2];
+    std::thread thread;
+
+    std::vector<StatusClient> clients;
+    std::atomic<size_t> clientCount;
+
+    Impl() : sequence(0), updatePending(false), running(false), listenFd(-1), clientCount(0) {
+        wakePipe[0] = wakePipe[1] = -1;
+    }
+
+    void Loop();
+    bool FlushClient(StatusClient& client);
+};
+
+static void SetNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+}
+
+bool StatusServer::Impl::FlushClient(StatusClient& client) {
+    while (!client.outbox.empty()) {
+        ssize_t written = send(client.fd, client.outbox.data(), client.outbox.size(), MSG_NOSIGNAL);
+        if (written < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            if (errno == EINTR) continue;
+            return false;
+        }
+        client.outbox.erase(0, static_cast<size_t>(written));
+    }
+    return client.outbox.size() <= MAX_CLIENT_OUTBOX;
+}
+
+void StatusServer::Impl::Loop() {
+    TRACE_THREAD_NAME("status-server");
+
+    std::vector<pollfd> pollFds;
+    char buffer[READ_CHUNK];
+
+    while (running) {
+        pollFds.clear();
+        pollFds.push_back({ wakePipe[0], POLLIN, 0 });
+        pollFds.push_back({ listenFd, POLLIN, 0 });
+        for (const auto& client : clients) {
+            short events = POLLIN;
+            if (!client.outbox.empty()) events |= POLLOUT;
+            pollFds.push_back({ client.fd, events, 0 });
+        }
+
+        if (poll(pollFds.data(), pollFds.size(), -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+
+        if (pollFds[0].revents & POLLIN) {
+            while (read(wakePipe[0], buffer, sizeof(buffer)) > 0) {}
+        }
+        if (!running) break;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (updatePending) {
+                updatePending = false;
+                for (auto& client : clients) {
+                    client.session.AppendUpdate(sequence, snapshot, client.outbox);
+                }
+            }
+        }
+
+        std::vector<bool> closed(clients.size(), false);
+
+        for (size_t i = 0; i < clients.size(); i++) {
+            StatusClient& client = clients[i];
+            short revents = pollFds[i + 2].revents;
+
+            if (revents & (POLLIN | POLLHUP | POLLERR)) {
+                while (true) {
+                    ssize_t bytesRead = recv(client.fd, buffer, sizeof(buffer), 0);
+                    if (bytesRead > 0) {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        client.session.OnInput(buffer, static_cast<size_t>(bytesRead), sequence, snapshot, client.outbox);
+                        continue;
+                    }
+                    if (bytesRead < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+                    if (bytesRead < 0 && errno == EINTR) continue;
+                    closed[i] = true;
+                    break;
+                }
+            }
+
+            if (!closed[i] && !FlushClient(client)) {
+                closed[i] = true;
+            }
+            if (client.session.IsClosing() && client.outbox.empty()) {
+                closed[i] = true;
+            }
+        }
+
+        for (size_t i = clients.size(); i-- > 0;) {
+            if (closed[i]) {
+                close(clients[i].fd);
+                clients.erase(clients.begin() + i);
+            }
+        }
+
+        if (pollFds[1].revents & POLLIN) {
+            while (true) {
+                int fd = accept(listenFd, NULL, NULL);
+                if (fd < 0) break;
+
+                SetNonBlocking(fd);
+                StatusClient client;
+                client.fd = fd;
+                clients.push_back(client);
+            }
+        }
+
+        clientCount = clients.size();
+    }
+
+    for (auto& client : clients) {
+        close(client.fd);
+    }
+    clients.clear();
+    clientCount = 0;
+}
+
+StatusServer::StatusServer() : impl(new Impl()) {}
+
+StatusServer::~StatusServer() {
+    Stop();
+}
+
+std::string StatusServer::DefaultEndpoint() {
+    const char* runtimeDir = getenv("XDG_RUNTIME_DIR");
+    if (runtimeDir && runtimeDir[0]) {
+        return std::string(runtimeDir) + "/monka-battery.sock";
+    }
+    return "/tmp/monka-battery-" + std::to_string(static_cast<unsigned long>(getuid())) + ".sock";
+}
+
+bool StatusServer::Start(const std::string& endpoint) {
+    if (impl->running) return true;
+
+    impl->socketPath = endpoint.empty() ? DefaultEndpoint() : endpoint;
+
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (impl->socketPath.size() >= sizeof(address.sun_path)) {
+        return false;
+    }
+    impl->socketPath.copy(address.sun_path, impl->socketPath.size());
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return false;
+    }
+
+    // A LEFTOVER SOCKET FILE NOBODY ANSWERS ON IS STALE; A LIVE ONE MEANS ANOTHER INSTANCE
+    if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0) {
+        close(fd);
+        return false;
+    }
+    unlink(impl->socketPath.c_str());
+
+    mode_t oldMask = umask(0077);
+    bool bound = bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+    umask(oldMask);
+
+    if (!bound || listen(fd, 16) != 0 || pipe(impl->wakePipe) != 0) {
+        close(fd);
+        return false;
+    }
+
+    SetNonBlocking(fd);
+    SetNonBlocking(impl->wakePipe[0]);
+    SetNonBlocking(impl->wakePipe[1]);
+
+    impl->listenFd = fd;
+    impl->running = true;
+    impl->thread = std::thread(&StatusServer::Impl::Loop, impl.get());
+    return true;
+}
+
+void StatusServer::Stop() {
+    if (!impl->running.exchange(false)) return;
+
+    char wake = 1;
+    if (write(impl->wakePipe[1], &wake, 1) < 0) {}
+    if (impl->thread.joinable()) {
+        impl->thread.join();
+    }
+
+    close(impl->listenFd);
+    close(impl->wakePipe[0]);
+    close(impl->wakePipe[1]);
+    impl->listenFd = -1;
+    impl->wakePipe[0] = impl->wakePipe[1] = -1;
+
+    unlink(impl->socketPath.c_str());
+}
+
+void StatusServer::Publish(const StatusSnapshot& snapshot) {
+    {
+        std::lock_guard<std::mutex> lock(impl->mutex);
+
+        bool changed = !StatusProtocol::SameState(snapshot, impl->snapshot);
+        impl->snapshot = snapshot;
+        if (!changed) return;
+
+        impl->sequence++;
+        impl->updatePending = true;
+    }
+
+    if (impl->running) {
+        char wake = 1;
+        if (write(impl->wakePipe[1], &wake, 1) < 0) {}
+    }
+}
+
+size_t StatusServer::GetClientCount() const {
+    return impl->clientCount;
+}
+
+#endif
+
+bool StatusServer::IsRunning() const {
+    return impl->running;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include "status_protocol.h"
+
+// LOCAL STATUS ENDPOINT: A NAMED PIPE ON WINDOWS, A UNIX DOMAIN SOCKET ELSEWHERE.
+// CLIENTS PICK BINARY OR JSON WITH THEIR FIRST BYTES; SUBSCRIBERS GET A FRAME ON EVERY STATE CHANGE
+class StatusServer {
+public:
+    StatusServer();
+    ~StatusServer();
+
+    bool Start(const std::string& endpoint);
+    void Stop();
+    bool IsRunning() const;
+
+    void Publish(const StatusSnapshot& snapshot);
+    size_t GetClientCount() const;
+
+    static std::string DefaultEndpoint();
+
+private:
+    StatusServer(const StatusServer&);
+    StatusServer& operator=(const StatusServer&);
+
+    struct Impl;
+    std::unique_ptr<Impl> impl;
+};
@@ -1,4 +1,5 @@
 #include "svg_renderer.h"
+#include "trace_events.h"
 #include <math.h>
 #include <string.h>
 #include <stdio.h>
@@ -12,6 +13,7 @@
 using namespace Gdiplus;
 
 bool SVGRenderer::RenderSVGFromFile(Graphics* g, const wchar_t* filePath, int x, int y, int width, int height, Color tintColor) {
+    TRACE_SCOPE("SVGRenderer::RenderSVGFromFile", "svg");
     char narrowPath[512];
     WideCharToMultiByte(CP_UTF8, 0, filePath, -1, narrowPath, sizeof(narrowPath), NULL, NULL);
     
@@ -62,6 +64,7 @@ bool SVGRenderer::RenderSVGFromFile(Graphics* g, const wchar_t* filePath, int x,
 }
 
 bool SVGRenderer::RenderSVGFromString(Graphics* g, const std::string& svgContent, int x, int y, int width, int height, Color tintColor) {
+    TRACE_SCOPE("SVGRenderer::RenderSVGFromString", "svg");
     if (svgContent.empty()) {
         return false;
     }
@@ -114,6 +117,7 @@ bool SVGRenderer::RenderSVGFromString(Graphics* g, const std::string& svgContent
 }
 
 Image* SVGRenderer::LoadSVGAsImage(const wchar_t* filePath, int width, int height, Color tintColor) {
+    TRACE_SCOPE("SVGRenderer::LoadSVGAsImage", "svg");
     char narrowPath[512];
     WideCharToMultiByte(CP_UTF8, 0, filePath, -1, narrowPath, sizeof(narrowPath), NULL, NULL);
     
@@ -0,0 +1,160 @@
+#include "trace_events.h"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <cstdio>
+
+namespace {
+
+const size_t FLUSH_THRESHOLD = 64 * 1024;
+
+std::mutex g_traceMutex;
+std::atomic<bool> g_active{false};
+FILE* g_traceFile = nullptr;
+std::string g_buffer;
+bool g_firstEvent = true;
+
+std::atomic<uint32_t> g_nextThreadId{1};
+thread_local uint32_t t_threadId = 0;
+
+uint32_t CurrentThreadId() {
+    if (t_threadId == 0) {
+        t_threadId = g_nextThreadId.fetch_add(1);
+    }
+    return t_threadId;
+}
+
+void AppendEscaped(std::string& out, const char* text) {
+    for (const char* p = text; *p; p++) {
+        char c = *p;
+        if (c == '"' || c == '\\') {
+            out.push_back('\\');
+            out.push_back(c);
+        } else if (static_cast<unsigned char>(c) >= 0x20) {
+            out.push_back(c);
+        }
+    }
+}
+
+void FlushLocked() {
+    if (g_traceFile && !g_buffer.empty()) {
+        fwrite(g_buffer.data(), 1, g_buffer.size(), g_traceFile);
+        fflush(g_traceFile);
+    }
+    g_buffer.clear();
+}
+
+void AppendEventLocked(const char* name, const char* category, char phase,
+                       int64_t timestampUs, int64_t durationUs, uint32_t threadId, const char* argName) {
+    if (!g_traceFile) return;
+
+    g_buffer += g_firstEvent ? "\n" : ",\n";
+    g_firstEvent = false;
+
+    char numbers[96];
+
+    g_buffer += "{\"name\":\"";
+    AppendEscaped(g_buffer, name);
+    g_buffer += "\",\"cat\":\"";
+    AppendEscaped(g_buffer, category);
+    g_buffer += "\",\"ph\":\"";
+    g_buffer.push_back(phase);
+
+    snprintf(numbers, sizeof(numbers), "\",\"pid\":1,\"tid\":%u,\"ts\":%lld",
+             threadId, static_cast<long long>(timestampUs));
+    g_buffer += numbers;
+
+    if (phase == 'X') {
+        snprintf(numbers, sizeof(numbers), ",\"dur\":%lld", static_cast<long long>(durationUs));
+        g_buffer += numbers;
+    } else if (phase == 'i') {
+        g_buffer += ",\"s\":\"t\"";
+    }
+
+    if (argName) {
+        g_buffer += ",\"args\":{\"name\":\"";
+        AppendEscaped(g_buffer, argName);
+        g_buffer += "\"}";
+    }
+
+    g_buffer += "}";
+
+    if (g_buffer.size() >= FLUSH_THRESHOLD) {
+        FlushLocked();
+    }
+}
+
+}
+
+int64_t TraceEvents::NowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool TraceEvents::Start(const std::string& filePath) {
+    std::lock_guard<std::mutex> lock(g_traceMutex);
+    if (g_traceFile) {
+        return true;
+    }
+
+#ifdef _MSC_VER
+    if (fopen_s(&g_traceFile, filePath.c_str(), "wb") != 0) {
+        g_traceFile = nullptr;
+    }
+#else
+    g_traceFile = fopen(filePath.c_str(), "wb");
+#endif
+    if (!g_traceFile) {
+        return false;
+    }
+
+    g_buffer.reserve(FLUSH_THRESHOLD * 2);
+    g_buffer = "[";
+    g_firstEvent = true;
+    g_active = true;
+    return true;
+}
+
+void TraceEvents::Stop() {
+    std::lock_guard<std::mutex> lock(g_traceMutex);
+    if (!g_traceFile) {
+        return;
+    }
+
+    g_active = false;
+    g_buffer += "\n]\n";
+    FlushLocked();
+
+    fclose(g_traceFile);
+    g_traceFile = nullptr;
+}
+
+bool TraceEvents::IsActive() {
+    return g_active.load(std::memory_order_relaxed);
+}
+
+void TraceEvents::Complete(const char* name, const char* category, int64_t startUs, int64_t durationUs) {
+    uint32_t threadId = CurrentThreadId();
+
+    std::lock_guard<std::mutex> lock(g_traceMutex);
+    AppendEventLocked(name, category, 'X', startUs, durationUs, threadId, nullptr);
+}
+
+void TraceEvents::Instant(const char* name, const char* category) {
+    if (!IsActive()) return;
+
+    uint32_t threadId = CurrentThreadId();
+    int64_t now = NowUs();
+
+    std::lock_guard<std::mutex> lock(g_traceMutex);
+    AppendEventLocked(name, category, 'i', now, 0, threadId, nullptr);
+}
+
+void TraceEvents::SetThreadName(const char* name) {
+    if (!IsActive()) return;
+
+    uint32_t threadId = CurrentThreadId();
+
+    std::lock_guard<std::mutex> lock(g_traceMutex);
+    AppendEventLocked("thread_name", "__metadata", 'M', 0, 0, threadId, name);
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// TRACE EVENT FORMAT WRITER, LOADABLE IN chrome://tracing AND ui.perfetto.dev.
+// INSTRUMENT WITH THE TRACE_* MACROS; THEY EXPAND TO NOTHING UNLESS MONKA_TRACE IS DEFINED
+class TraceEvents {
+public:
+    static bool Start(const std::string& filePath);
+    static void Stop();
+    static bool IsActive();
+
+    static void Complete(const char* name, const char* category, int64_t startUs, int64_t durationUs);
+    static void Instant(const char* name, const char* category);
+    static void SetThreadName(const char* name);
+
+    static int64_t NowUs();
+};
+
+class TraceScope {
+public:
+    TraceScope(const char* name, const char* category)
+        : name(name), category(category), startUs(TraceEvents::IsActive() ? TraceEvents::NowUs() : -1) {}
+
+    ~TraceScope() {
+        if (startUs >= 0) {
+            TraceEvents::Complete(name, category, startUs, TraceEvents::NowUs() - startUs);
+        }
+    }
+
+private:
+    TraceScope(const TraceScope&);
+    TraceScope& operator=(const TraceScope&);
+
+    const char* name;
+    const char* category;
+    int64_t startUs;
+};
+
+#ifdef MONKA_TRACE
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name, category) TraceScope TRACE_CONCAT(traceScope_, __LINE__)(name, category)
+#define TRACE_INSTANT(name, category) TraceEvents::Instant(name, category)
+#define TRACE_THREAD_NAME(name) TraceEvents::SetThreadName(name)
+#else
+#define TRACE_SCOPE(name, category) ((void)0)
+#define TRACE_INSTANT(name, category) ((void)0)
+#define TRACE_THREAD_NAME(name) ((void)0)
+#endif
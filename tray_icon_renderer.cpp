@@ -2,6 +2,8 @@
 #include "font_loader.h"
 #include "settings_view.h"
 #include "resource_loader.h"
+#include "trace_events.h"
+#include "process_metrics.h"
 
 using namespace Gdiplus;
 
@@ -9,6 +11,8 @@ DWORD TrayIconRenderer::s_lastBlinkTime = 0;
 bool TrayIconRenderer::s_blinkState = true;
 
 HICON TrayIconRenderer::CreateBatteryIcon(int batteryLevel, bool isCharging, bool isOnline, bool isUpdating) {
+    TRACE_SCOPE("TrayIconRenderer::CreateBatteryIcon", "render");
+    ProcessMetrics::Increment(ProcessCounter::ICON_RENDERS);
     const int iconSize = 64;
 
     Bitmap* iconBitmap = new Bitmap(iconSize, iconSize, PixelFormat32bppARGB);
@@ -3,6 +3,13 @@
 #include "device_discovery.h"
 #include "colors.h"
 #include "color_picker_dialog.h"
+#include "device_cache.h"
+#include "latency_trace.h"
+#include "trace_events.h"
+#include "battery_service.h"
+#include "settings_store.h"
+#include "Monka M1 Pro Battery Indicator.h"
+#include <algorithm>
 
 ULONG_PTR UIRenderer::gdiplusToken = 0;
 bool UIRenderer::gdiplusInitialized = false;
@@ -15,10 +22,20 @@ DWORD UIRenderer::lastHoverUpdate = 0;
 bool UIRenderer::isTrackingMouse = false;
 DWORD UIRenderer::lastBatteryUpdate = 0;
 DWORD UIRenderer::lastDeviceDiscovery = 0;
-std::map<std::string, DWORD> UIRenderer::deviceLastResponse;
-std::vector<std::string> UIRenderer::activeDevicePaths;
+std::vector<DeviceId> UIRenderer::activeDeviceIds;
+std::thread UIRenderer::discoveryThread;
+std::atomic<bool> UIRenderer::discoveryInProgress{false};
+std::atomic<bool> UIRenderer::cacheDirty{false};
+std::atomic<bool> UIRenderer::statusDirty{false};
+DeviceId UIRenderer::preferredDeviceId = INVALID_DEVICE_ID;
+ConfigWatcher UIRenderer::configWatcher;
+std::mutex UIRenderer::configMutex;
+std::shared_ptr<const ConfigFile> UIRenderer::pendingConfig;
+std::shared_ptr<const ConfigFile> UIRenderer::appliedConfig;
 SettingsView UIRenderer::settingsView;
 HWND UIRenderer::mainWindowHandle = nullptr;
+std::mutex UIRenderer::batteryMutex;
+std::vector<UIRenderer::PendingBatteryUpdate> UIRenderer::pendingBatteryUpdates;
 
 bool UIRenderer::Initialize() {
   if (gdiplusInitialized)
@@ -38,11 +55,27 @@ bool UIRenderer::Initialize() {
 
   DeviceDiscovery& discovery = GetDeviceDiscovery();
   discovery.SetBatteryUpdateCallback(OnBatteryDataReceived);
+  discovery.SetLinkStateCallback(OnLinkStateEvent);
 
-  return LoadFonts() && InitializeMouseList();
+  return LoadFonts() && LoadCachedMouseList();
+}
+
+void UIRenderer::Shutdown() {
+  configWatcher.Stop();
+
+  if (discoveryThread.joinable()) {
+    discoveryThread.join();
+  }
+  discoveryInProgress = false;
+
+  if (GetDeviceDiscovery().IsInitialized()) {
+    SaveDeviceCache();
+  }
 }
 
 void UIRenderer::Cleanup() {
+  Shutdown();
+
   interFont = nullptr;
   geistMonoFont = nullptr;
 
@@ -80,6 +113,121 @@ Gdiplus::Font* UIRenderer::GetGeistMonoFont() {
   return geistMonoFont;
 }
 
+bool UIRenderer::LoadCachedMouseList() {
+  mouseList.clear();
+
+  std::vector<CachedDevice> cachedDevices;
+  if (!DeviceCache::Load(DeviceCache::DefaultPath(), cachedDevices)) {
+    return true;
+  }
+
+  DeviceDiscovery& discovery = GetDeviceDiscovery();
+  preferredDeviceId = discovery.SeedFromCache(cachedDevices);
+
+  mouseList = discovery.GetMouseItems();
+  for (auto& mouseItem : mouseList) {
+    mouseItem.isStale = true;
+  }
+
+  if (mouseList.size() == 1) {
+    settingsView.Show(&mouseList[0]);
+  }
+
+  return true;
+}
+
+void UIRenderer::StartBackgroundDiscovery(HWND hWnd) {
+  if (discoveryInProgress.exchange(true)) {
+    return;
+  }
+
+  if (discoveryThread.joinable()) {
+    discoveryThread.join();
+  }
+
+  // THE WORKER CLEARS THE DEVICE LIST AND GROWS THE REGISTRY UNLOCKED; NO HID REPLY MAY READ EITHER MEANWHILE.
+  // ApplyDiscoveredDevices STARTS MONITORING AGAIN ON WM_DISCOVERY_COMPLETE
+  DeviceDiscovery& discovery = GetDeviceDiscovery();
+  if (discovery.IsInitialized()) {
+    discovery.StopBatteryMonitoring();
+    activeDeviceIds.clear();
+  }
+
+  discoveryThread = std::thread([hWnd]() {
+    TRACE_THREAD_NAME("discovery");
+    DeviceDiscovery& discovery = GetDeviceDiscovery();
+
+    bool initialized = discovery.IsInitialized() || discovery.Initialize();
+    if (initialized) {
+      discovery.DiscoverDevices();
+    }
+
+    PostMessage(hWnd, WM_DISCOVERY_COMPLETE, initialized ? 1 : 0, 0);
+  });
+}
+
+void UIRenderer::OnBackgroundDiscoveryComplete(HWND hWnd, bool initialized) {
+  if (discoveryThread.joinable()) {
+    discoveryThread.join();
+  }
+  discoveryInProgress = false;
+
+  extern bool g_isUsingMockData;
+  DeviceDiscovery& discovery = GetDeviceDiscovery();
+
+  if (!initialized) {
+    mouseList.clear();
+    mouseList.push_back(MouseItem(L"Monka M1 Pro (Mock)",
+                                  L"assets/pngs/mouse/m1_pro.png", 90, false,
+                                  Color(255, 255, 255, 255) // WHITE
+                                  ));
+    g_isUsingMockData = true;
+  } else {
+    g_isUsingMockData = discovery.IsUsingMockData();
+
+    if (!discovery.GetDiscoveredDevices().empty()) {
+      ApplyDiscoveredDevices();
+      SaveDeviceCache();
+    } else {
+      for (auto& mouseItem : mouseList) {
+        mouseItem.isOnline = false;
+      }
+    }
+  }
+
+  for (auto& mouseItem : mouseList) {
+    mouseItem.isStale = false;
+  }
+
+  if (initialized) {
+    statusDirty = true;
+    SetTimer(hWnd, 4, static_cast<UINT>(discovery.GetHeartbeatTickMs()), NULL); // HEARTBEAT WHEEL
+  }
+
+  if (!mouseList.empty() && (mouseList.size() == 1 || settingsView.IsVisible())) {
+    settingsView.Show(&mouseList[0]);
+  }
+
+  InvalidateRect(hWnd, NULL, FALSE);
+  UpdateSystemTrayIcon();
+
+  // A RELOAD THAT ARRIVED WHILE DISCOVERY OWNED THE DEVICE LIST
+  OnConfigChanged(hWnd);
+}
+
+bool UIRenderer::IsDiscoveryInProgress() {
+  return discoveryInProgress.load();
+}
+
+void UIRenderer::SaveDeviceCache() {
+  cacheDirty = false;
+
+  std::vector<CachedDevice> snapshot = GetDeviceDiscovery().BuildCacheSnapshot();
+  if (!snapshot.empty()) {
+    DeviceCache::Save(DeviceCache::DefaultPath(), snapshot);
+  }
+}
+
 bool UIRenderer::InitializeMouseList() {
   mouseList.clear();
 
@@ -105,51 +253,65 @@ bool UIRenderer::InitializeMouseList() {
   g_isUsingMockData = discovery.IsUsingMockData();
 
   if (discovery.DiscoverDevices()) {
-    auto newMouseItems = discovery.GetMouseItems();
+    ApplyDiscoveredDevices();
+  }
 
-    for (size_t i = 0; i < newMouseItems.size() && i < mouseList.size(); i++) {
-      newMouseItems[i].isHovered = mouseList[i].isHovered;
-      newMouseItems[i].hoverProgress = mouseList[i].hoverProgress;
-    }
+  return true;
+}
 
-    mouseList = newMouseItems;
+void UIRenderer::ApplyDiscoveredDevices() {
+  DeviceDiscovery& discovery = GetDeviceDiscovery();
 
-    const auto& devices = discovery.GetDiscoveredDevices();
-    if (!devices.empty()) {
-      activeDevicePaths.clear();
-      deviceLastResponse.clear();
+  auto newMouseItems = discovery.GetMouseItems();
+
+  for (size_t i = 0; i < newMouseItems.size() && i < mouseList.size(); i++) {
+    newMouseItems[i].isHovered = mouseList[i].isHovered;
+    newMouseItems[i].hoverProgress = mouseList[i].hoverProgress;
+  }
+
+  mouseList = newMouseItems;
+
+  const auto& devices = discovery.GetDiscoveredDevices();
+  if (!devices.empty()) {
+    activeDeviceIds.clear();
 
-      std::string bestDevice;
+    DeviceId bestDevice = INVALID_DEVICE_ID;
+    for (const auto& device : devices) {
+      if (device.id == preferredDeviceId) {
+        bestDevice = device.id;
+        break;
+      }
+    }
+
+    if (bestDevice == INVALID_DEVICE_ID) {
       for (const auto& device : devices) {
         if (device.isOnline) {
           if (device.connectionType == ConnectionType::USB_WIRED) {
-            bestDevice = device.devicePath;
+            bestDevice = device.id;
             break;
-          } else if (bestDevice.empty() || device.connectionType == ConnectionType::WIRELESS_DONGLE) {
-            bestDevice = device.devicePath;
+          } else if (bestDevice == INVALID_DEVICE_ID || device.connectionType == ConnectionType::WIRELESS_DONGLE) {
+            bestDevice = device.id;
           }
         }
       }
+    }
 
-      if (bestDevice.empty()) {
-        bestDevice = devices[0].devicePath;
-      }
-
-      if (discovery.StartBatteryMonitoring(bestDevice)) {
-        activeDevicePaths.push_back(bestDevice);
-        UpdateDeviceResponseTime(bestDevice);
-      }
+    if (bestDevice == INVALID_DEVICE_ID) {
+      bestDevice = devices[0].id;
     }
 
-    if (mouseList.size() == 1) {
-      settingsView.Show(&mouseList[0]);
+    if (discovery.StartBatteryMonitoring(bestDevice)) {
+      activeDeviceIds.push_back(bestDevice);
     }
   }
 
-  return true;
+  if (mouseList.size() == 1) {
+    settingsView.Show(&mouseList[0]);
+  }
 }
 
 void UIRenderer::RenderUI(HDC hdc, const RECT &clientRect) {
+  TRACE_SCOPE("UIRenderer::RenderUI", "paint");
   if (!gdiplusInitialized)
     return;
 
@@ -293,10 +455,14 @@ void UIRenderer::UpdateBatteryStatus(HWND hWnd) {
     }
 
     DeviceDiscovery& discovery = GetDeviceDiscovery();
-    if (!discovery.IsInitialized()) {
+    if (discoveryInProgress || !discovery.IsInitialized()) {
         return;
     }
 
+    if (cacheDirty) {
+        SaveDeviceCache();
+    }
+
     if (currentTime - lastDeviceDiscovery > 30000) {
         PerformDeviceDiscovery(hWnd);
         lastDeviceDiscovery = currentTime;
@@ -304,35 +470,35 @@ void UIRenderer::UpdateBatteryStatus(HWND hWnd) {
 
     bool statusChanged = false;
 
+    discovery.ExpireBatteryRequests();
+
     const auto& devices = discovery.GetDiscoveredDevices();
     for (const auto& device : devices) {
-        discovery.RequestBatteryLevel(device.devicePath);
-
-        bool isOnline = discovery.IsDeviceOnline(device.devicePath);
+        bool isOnline = discovery.IsDeviceOnline(device.id);
 
         for (auto& mouseItem : mouseList) {
-            std::string deviceName(mouseItem.name.begin(), mouseItem.name.end());
-            if (deviceName == device.name) {
+            // MATCH ON THE ENDPOINT, NOT THE NAME: TWO IDENTICAL MICE HAVE TWO CARDS
+            bool ownsDevice = std::any_of(mouseItem.connections.begin(), mouseItem.connections.end(),
+                [&device](const ConnectionInfo& connection) { return connection.deviceId == device.id; });
+            if (ownsDevice) {
                 if (mouseItem.isOnline != isOnline) {
                     mouseItem.isOnline = isOnline;
                     statusChanged = true;
                 }
 
-                auto status = discovery.GetBatteryStatus(device.devicePath);
+                auto status = discovery.GetBatteryStatus(device.id);
 
                 int calculatedLevel = 0;
                 if (status.level > 0) {
                     calculatedLevel = status.level;
                 } else if (status.BatVoltage > 0) {
-                    calculatedLevel = discovery.calculateBatteryPercentage(status.BatVoltage);
+                    calculatedLevel = discovery.calculateBatteryPercentage(device.id, status.BatVoltage);
                 }
 
                 if (calculatedLevel != mouseItem.batteryLevel && calculatedLevel > 0) {
                     mouseItem.batteryLevel = calculatedLevel;
                     mouseItem.isCharging = (status.isCharging != 0);
                     statusChanged = true;
-
-                    UpdateDeviceResponseTime(device.devicePath);
                 }
                 break;
             }
@@ -411,39 +577,195 @@ void UIRenderer::UpdateThemeFromSystem() {
     }
 }
 
-void UIRenderer::CheckDeviceHealth(HWND hWnd) {
-    DWORD currentTime = GetTickCount();
-    const DWORD DEVICE_TIMEOUT = 5000;
+void UIRenderer::TickHeartbeats() {
+    if (discoveryInProgress) {
+        return;
+    }
 
-    bool anyDeviceResponding = false;
-    bool needsSwitching = false;
+    GetDeviceDiscovery().TickHeartbeats();
 
-    for (const auto& devicePath : activeDevicePaths) {
-        auto it = deviceLastResponse.find(devicePath);
-        if (it != deviceLastResponse.end() && (currentTime - it->second) < DEVICE_TIMEOUT) {
-            anyDeviceResponding = true;
-            break;
+    if (statusDirty.exchange(false)) {
+        PublishStatus();
+    }
+    BatteryService::Tick(SteadyNowMs());
+}
+
+void UIRenderer::PublishStatus() {
+    DeviceDiscovery& discovery = GetDeviceDiscovery();
+
+    StatusSnapshot snapshot;
+    discovery.BuildStatusSnapshot(snapshot);
+    discovery.PublishStatusPage(snapshot);
+
+    std::vector<DeviceCounters> counters;
+    discovery.BuildDeviceCounters(snapshot, counters);
+    BatteryService::PublishDeviceCounters(counters);
+    BatteryService::PublishSnapshot(snapshot);
+}
+
+// RUNS ON THE HID THREAD OR INSIDE TickHeartbeats; HAND THE EVENT TO THE WINDOW THREAD
+void UIRenderer::OnLinkStateEvent(DeviceId deviceId, LinkState newState) {
+    if (mainWindowHandle) {
+        PostMessage(mainWindowHandle, WM_LINK_STATE_CHANGED, static_cast<WPARAM>(deviceId), static_cast<LPARAM>(newState));
+    }
+}
+
+void UIRenderer::StartConfigWatcher(HWND hWnd) {
+    appliedConfig = SettingsStore::Snapshot();
+
+    bool started = configWatcher.Start("Config.ini", [hWnd](const std::shared_ptr<const ConfigFile>& config) {
+        {
+            std::lock_guard<std::mutex> lock(configMutex);
+            pendingConfig = config;
         }
+        PostMessage(hWnd, WM_CONFIG_CHANGED, 0, 0);
+    });
+    if (!started) {
+        OutputDebugStringA("Config.ini watcher unavailable; edits apply on restart\n");
     }
+}
 
-    if (!anyDeviceResponding && !activeDevicePaths.empty()) {
-        needsSwitching = true;
+// APPLIES ONLY THE KEYS THAT DIFFER FROM WHAT IS ALREADY SHOWN. OUR OWN SAVES COME BACK HERE TOO AND DIFF TO NOTHING
+void UIRenderer::OnConfigChanged(HWND hWnd) {
+    TRACE_SCOPE("UIRenderer::OnConfigChanged", "config");
+    // DISCOVERY OWNS THE PID LISTS UNTIL IT COMPLETES; THE RELOAD STAYS PENDING UNTIL THEN
+    if (discoveryInProgress) {
+        return;
     }
 
-    if (needsSwitching) {
-        for (auto& mouseItem : mouseList) {
-            mouseItem.isUpdating = true;
+    std::shared_ptr<const ConfigFile> config;
+    {
+        std::lock_guard<std::mutex> lock(configMutex);
+        config.swap(pendingConfig);
+    }
+    if (!config || !appliedConfig) {
+        return;
+    }
+
+    std::shared_ptr<const ConfigFile> previous = appliedConfig;
+    std::vector<ConfigFile::KeyChange> changes;
+    ConfigFile::Diff(*previous, *config, changes);
+    appliedConfig = config;
+    SettingsStore::Adopt(config);
+    if (changes.empty()) {
+        return;
+    }
+
+    bool colorsChanged = false;
+    bool iconModeChanged = false;
+    bool notificationsChanged = false;
+    for (const auto& change : changes) {
+        switch (ConfigSchema::Identify(change.hash, change.section, change.key)) {
+        case ConfigKey::COLOR_CUSTOM_PRIMARY:
+        case ConfigKey::COLOR_CUSTOM_SUCCESS:
+        case ConfigKey::COLOR_CUSTOM_WARNING:
+        case ConfigKey::COLOR_CUSTOM_CRITICAL:
+            colorsChanged = true;
+            break;
+        case ConfigKey::UI_ICON_MODE:
+            iconModeChanged = true;
+            break;
+        case ConfigKey::OPTION_ENABLE_NOTIFICATIONS:
+            notificationsChanged = true;
+            break;
+        default:
+            break;
         }
+    }
 
+    if (colorsChanged) {
+        ColorPickerDialog::LoadColorSettings();
+    }
+    if (iconModeChanged) {
+        SettingsView::LoadUISettings();
+    }
+    if (notificationsChanged) {
+        LoadStartupSettings();
+    }
+
+    DeviceDiscovery& discovery = GetDeviceDiscovery();
+    ConfigDelta delta;
+    if (discovery.IsInitialized()) {
+        delta = discovery.ApplyConfigChanges(*config, changes);
+    }
+
+    if (delta.rediscover) {
+        StartBackgroundDiscovery(hWnd);
+    } else if (!delta.addedPids.empty() || !delta.removedPids.empty()) {
+        // DiscoverPids INTERNS THE NEW ENDPOINTS; SwitchToAvailableDevice STARTS MONITORING AGAIN
+        discovery.StopBatteryMonitoring();
+        activeDeviceIds.clear();
+        discovery.DiscoverPids(delta.addedPids);
+        ApplyDiscoveredDevices();
         SwitchToAvailableDevice(hWnd);
+        cacheDirty = true;
+        statusDirty = true;
+    }
+    // DISCOVERY RENAMED ITS DEVICES; THE CARDS ONLY NEED THE NEW NAME, NOT A REBUILD THAT RESTARTS MONITORING
+    if (delta.profilesChanged && !delta.rediscover) {
+        for (auto& mouseItem : mouseList) {
+            if (mouseItem.connections.empty()) continue;
+            for (const auto& device : discovery.GetDiscoveredDevices()) {
+                if (device.id == mouseItem.connections[0].deviceId) {
+                    mouseItem.name.assign(device.name.begin(), device.name.end());
+                    break;
+                }
+            }
+        }
+        cacheDirty = true;
+        statusDirty = true;
+    }
+    if (delta.heartbeatChanged) {
+        SetTimer(hWnd, 4, static_cast<UINT>(discovery.GetHeartbeatTickMs()), NULL); // HEARTBEAT WHEEL
+    }
 
+    // COLORS, ICON MODE AND PROFILES ONLY AFFECT DRAWING: A REPAINT AND A FRESH TRAY ICON, NOTHING ELSE
+    if (colorsChanged || iconModeChanged || delta.profilesChanged || !delta.addedPids.empty() || !delta.removedPids.empty()) {
         InvalidateRect(hWnd, NULL, FALSE);
+        UpdateSystemTrayIcon();
+    }
+}
+
+void UIRenderer::OnLinkStateChanged(HWND hWnd, DeviceId deviceId, LinkState newState) {
+    if (discoveryInProgress) {
+        return;
+    }
+
+    statusDirty = true;
+    bool isOnline = (newState != LinkState::OFFLINE);
+
+    for (auto& mouseItem : mouseList) {
+        bool matched = false;
+        bool anyOnline = false;
+        for (auto& connection : mouseItem.connections) {
+            if (connection.deviceId == deviceId) {
+                connection.isOnline = isOnline;
+                matched = true;
+            }
+            anyOnline = anyOnline || connection.isOnline;
+        }
+
+        if (matched) {
+            mouseItem.isOnline = anyOnline;
+        }
+    }
+
+    if (newState == LinkState::OFFLINE) {
+        for (DeviceId activeId : activeDeviceIds) {
+            if (activeId == deviceId) {
+                SwitchToAvailableDevice(hWnd);
+                break;
+            }
+        }
     }
+
+    InvalidateRect(hWnd, NULL, FALSE);
+    UpdateSystemTrayIcon();
 }
 
 void UIRenderer::PerformDeviceDiscovery(HWND hWnd) {
     DeviceDiscovery& discovery = GetDeviceDiscovery();
-    if (!discovery.IsInitialized()) {
+    if (discoveryInProgress || !discovery.IsInitialized()) {
         return;
     }
 
@@ -452,6 +774,10 @@ void UIRenderer::PerformDeviceDiscovery(HWND hWnd) {
     }
     InvalidateRect(hWnd, NULL, FALSE);
 
+    // DiscoverDevices REBUILDS THE DEVICE LIST UNDER THE HID CALLBACK; SwitchToAvailableDevice STARTS MONITORING AGAIN
+    discovery.StopBatteryMonitoring();
+    activeDeviceIds.clear();
+
     if (discovery.DiscoverDevices()) {
         auto newMouseItems = discovery.GetMouseItems();
 
@@ -462,14 +788,10 @@ void UIRenderer::PerformDeviceDiscovery(HWND hWnd) {
         }
 
         mouseList = newMouseItems;
-
-        SwitchToAvailableDevice(hWnd);
-    } else {
-        for (auto& mouseItem : mouseList) {
-            mouseItem.isUpdating = false;
-        }
     }
 
+    SwitchToAvailableDevice(hWnd);
+
     InvalidateRect(hWnd, NULL, FALSE);
 }
 
@@ -480,40 +802,40 @@ void UIRenderer::SwitchToAvailableDevice(HWND hWnd) {
     }
 
     const auto& devices = discovery.GetDiscoveredDevices();
-    std::string bestDevice;
+    DeviceId bestDevice = INVALID_DEVICE_ID;
 
     for (const auto& device : devices) {
-        if (device.isOnline) {
+        if (device.isOnline && discovery.GetLinkState(device.id) != LinkState::OFFLINE) {
             if (device.connectionType == ConnectionType::USB_WIRED) {
-                bestDevice = device.devicePath;
+                bestDevice = device.id;
                 break;
-            } else if (bestDevice.empty() || device.connectionType == ConnectionType::WIRELESS_DONGLE) {
-                bestDevice = device.devicePath;
+            } else if (bestDevice == INVALID_DEVICE_ID || device.connectionType == ConnectionType::WIRELESS_DONGLE) {
+                bestDevice = device.id;
             }
         }
     }
 
-    if (bestDevice.empty() && !devices.empty()) {
-        bestDevice = devices[0].devicePath;
+    if (bestDevice == INVALID_DEVICE_ID && !devices.empty()) {
+        bestDevice = devices[0].id;
     }
 
-    if (!bestDevice.empty()) {
+    // KEEP PROBING AN OFFLINE ENDPOINT INSTEAD OF RESTARTING THE SERVER ON IT
+    bool alreadyMonitored = (bestDevice == discovery.GetMonitoredDevice() &&
+                             discovery.GetLinkState(bestDevice) == LinkState::OFFLINE);
+
+    if (bestDevice != INVALID_DEVICE_ID && !alreadyMonitored) {
         discovery.StopBatteryMonitoring();
         if (discovery.StartBatteryMonitoring(bestDevice)) {
-            activeDevicePaths.clear();
-            activeDevicePaths.push_back(bestDevice);
-
-            UpdateDeviceResponseTime(bestDevice);
+            activeDeviceIds.clear();
+            activeDeviceIds.push_back(bestDevice);
         }
     }
 
     for (auto& mouseItem : mouseList) {
         mouseItem.isUpdating = false;
     }
-}
 
-void UIRenderer::UpdateDeviceResponseTime(const std::string& devicePath) {
-    deviceLastResponse[devicePath] = GetTickCount();
+    statusDirty = true;
 }
 
 void UIRenderer::SetMainWindow(HWND hWnd) {
@@ -521,32 +843,88 @@ void UIRenderer::SetMainWindow(HWND hWnd) {
     settingsView.SetParentWindow(hWnd);
 }
 
-void UIRenderer::OnBatteryDataReceived(const std::string& devicePath, const BatteryStatus& status) {
+// RUNS ON THE HID THREAD; THE CARDS AND THE TRAY ICON BELONG TO THE WINDOW THREAD
+void UIRenderer::OnBatteryDataReceived(DeviceId deviceId, const BatteryStatus& status) {
+    if (!mainWindowHandle) {
+        return;
+    }
+
+    bool wasEmpty;
+    {
+        std::lock_guard<std::mutex> lock(batteryMutex);
+        wasEmpty = pendingBatteryUpdates.empty();
+
+        // A NEWER READING FOR A DEVICE STILL QUEUED REPLACES IT; THE SPAN KEEPS THE OLDER START
+        auto pending = std::find_if(pendingBatteryUpdates.begin(), pendingBatteryUpdates.end(),
+            [deviceId](const PendingBatteryUpdate& update) { return update.deviceId == deviceId; });
+        if (pending != pendingBatteryUpdates.end()) {
+            pending->status = status;
+        } else {
+            PendingBatteryUpdate update = { deviceId, status, LatencyTrace::Handoff() };
+            pendingBatteryUpdates.push_back(update);
+        }
+    }
+
+    if (wasEmpty) {
+        PostMessage(mainWindowHandle, WM_BATTERY_UPDATED, 0, 0);
+    }
+}
+
+void UIRenderer::OnBatteryUpdated(HWND hWnd) {
+    std::vector<PendingBatteryUpdate> updates;
+    {
+        std::lock_guard<std::mutex> lock(batteryMutex);
+        updates.swap(pendingBatteryUpdates);
+    }
+
+    for (const auto& update : updates) {
+        LatencyTrace::Resume(update.span);
+        LatencyTrace::Mark(LatencyStage::UI_NOTIFIED);
+        ApplyBatteryUpdate(hWnd, update.deviceId, update.status);
+        LatencyTrace::End();
+    }
+}
+
+void UIRenderer::ApplyBatteryUpdate(HWND hWnd, DeviceId deviceId, const BatteryStatus& status) {
+    statusDirty = true;
+
     bool statusChanged = false;
 
     for (auto& mouseItem : mouseList) {
+        // THE CARD OF THE ENDPOINT THAT ANSWERED, AS IN UpdateBatteryStatus: TWO IDENTICAL MICE HAVE TWO CARDS
+        auto connection = std::find_if(mouseItem.connections.begin(), mouseItem.connections.end(),
+            [deviceId](const ConnectionInfo& candidate) { return candidate.deviceId == deviceId; });
+        if (connection == mouseItem.connections.end()) continue;
+
         int newLevel = status.level;
         bool newCharging = (status.isCharging != 0);
+        connection->batteryLevel = newLevel;
+        connection->isCharging = newCharging;
+        connection->isOnline = true;
 
         if (mouseItem.batteryLevel != newLevel || mouseItem.isCharging != newCharging) {
             mouseItem.batteryLevel = newLevel;
             mouseItem.isCharging = newCharging;
             mouseItem.isOnline = true;
             mouseItem.isUpdating = false; 
+            mouseItem.isStale = false;
             statusChanged = true;
-
-            UpdateDeviceResponseTime(devicePath);
+            cacheDirty = true;
         }
         break; 
     }
 
-    if (statusChanged && mainWindowHandle) {
-        InvalidateRect(mainWindowHandle, NULL, FALSE);
+    if (statusChanged) {
+        InvalidateRect(hWnd, NULL, FALSE);
         UpdateSystemTrayIcon();
     }
 }
 
 void UIRenderer::OnDeviceChange() {
+    if (discoveryInProgress) {
+        return;
+    }
+
     for (auto& mouseItem : mouseList) {
         mouseItem.isUpdating = true;
     }
@@ -5,15 +5,26 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include "svg_renderer.h"
 #include "mouse_item.h"
 #include "mouse_list.h"
 #include "settings_view.h"
 #include "colors.h"
 #include "device_discovery.h"
+#include "config_watcher.h"
+#include "latency_trace.h"
 
 #pragma comment(lib, "gdiplus.lib")
 
+#define WM_DISCOVERY_COMPLETE (WM_APP + 1)
+#define WM_LINK_STATE_CHANGED (WM_APP + 2)
+#define WM_CONFIG_CHANGED (WM_APP + 3)
+#define WM_BATTERY_UPDATED (WM_APP + 4)
+
 enum class BatteryLevel {
     Empty,
     Low,
@@ -43,15 +54,37 @@ private:
 
     static DWORD lastBatteryUpdate;
     static DWORD lastDeviceDiscovery;
-    static std::map<std::string, DWORD> deviceLastResponse;  
-    static std::vector<std::string> activeDevicePaths;   
+    static std::vector<DeviceId> activeDeviceIds;
+
+    static std::thread discoveryThread;
+    static std::atomic<bool> discoveryInProgress;
+    static std::atomic<bool> cacheDirty;
+    static std::atomic<bool> statusDirty;
+    static DeviceId preferredDeviceId;
+
+    static ConfigWatcher configWatcher;
+    static std::mutex configMutex;
+    static std::shared_ptr<const ConfigFile> pendingConfig;   // LATEST RELOAD, HANDED OVER BY THE WATCHER THREAD
+    static std::shared_ptr<const ConfigFile> appliedConfig;   // WHAT THE UI AND DISCOVERY CURRENTLY REFLECT
 
     static SettingsView settingsView;
     static SettingsView& GetSettingsView() { return settingsView; }
 
     static HWND mainWindowHandle;
 
+    struct PendingBatteryUpdate {
+        DeviceId deviceId;
+        BatteryStatus status;
+        LatencySpan span;
+    };
+    static std::mutex batteryMutex;
+    static std::vector<PendingBatteryUpdate> pendingBatteryUpdates;   // FILLED BY THE HID THREAD, DRAINED ON WM_BATTERY_UPDATED
+
     static bool InitializeMouseList();
+    static bool LoadCachedMouseList();
+    static void ApplyDiscoveredDevices();
+    static void OnLinkStateEvent(DeviceId deviceId, LinkState newState);
+    static void ApplyBatteryUpdate(HWND hWnd, DeviceId deviceId, const BatteryStatus& status);
     
 public:
     static bool Initialize();
@@ -59,6 +92,12 @@ public:
     static void SetMainWindow(HWND hWnd);
 
     static void Cleanup();
+    static void Shutdown();
+
+    static void StartBackgroundDiscovery(HWND hWnd);
+    static void OnBackgroundDiscoveryComplete(HWND hWnd, bool initialized);
+    static bool IsDiscoveryInProgress();
+    static void SaveDeviceCache();
     
     static void RenderUI(HDC hdc, const RECT& clientRect);
     
@@ -78,12 +117,16 @@ public:
 
     static void UpdateBatteryStatus(HWND hWnd);
     static void RefreshDeviceList(HWND hWnd);
-    static void CheckDeviceHealth(HWND hWnd);
+    static void TickHeartbeats();
+    static void PublishStatus();
+    static void OnLinkStateChanged(HWND hWnd, DeviceId deviceId, LinkState newState);
+    static void StartConfigWatcher(HWND hWnd);
+    static void OnConfigChanged(HWND hWnd);
     static void PerformDeviceDiscovery(HWND hWnd);
     static void SwitchToAvailableDevice(HWND hWnd);
-    static void UpdateDeviceResponseTime(const std::string& devicePath);
 
-    static void OnBatteryDataReceived(const std::string& devicePath, const BatteryStatus& status);
+    static void OnBatteryDataReceived(DeviceId deviceId, const BatteryStatus& status);
+    static void OnBatteryUpdated(HWND hWnd);
 
     static void OnDeviceChange();
 